@@ -7,17 +7,82 @@
 
 #include <cstddef>
 #include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
 #include "construct.h"
 
 namespace Lsh {
+    /**
+    * @brief The result of allocate_at_least: a block and the number of objects it really holds.
+    */
+    template<class Pointer, class SizeType = std::size_t>
+    struct allocation_result {
+        Pointer  ptr;
+        SizeType count;
+    };
+
+    /**
+    * @brief Returns how many bytes malloc really hands out for a request of `bytes`.
+    *
+    * glibc rounds a chunk (payload plus one size_t header) up to twice the size_t alignment,
+    * with a minimum of four size_ts, and the caller may use everything but the header. Other C
+    * libraries get the request rounded to max_align_t, which is always safe to ask for.
+    */
+    inline std::size_t malloc_good_size(std::size_t bytes) noexcept {
+#if defined(__GLIBC__)
+        const std::size_t header = sizeof(std::size_t);
+        const std::size_t align  = alignof(std::max_align_t) > 2 * header ? alignof(std::max_align_t) : 2 * header;
+        const std::size_t min    = 4 * header;
+        if (bytes > std::numeric_limits<std::size_t>::max() - header - align) {
+            return bytes;
+        }
+        const std::size_t chunk = (bytes + header + align - 1) & ~(align - 1);
+        return (chunk < min ? min : chunk) - header;
+#else
+        const std::size_t align = alignof(std::max_align_t);
+        if (bytes > std::numeric_limits<std::size_t>::max() - align) {
+            return bytes;
+        }
+        return (bytes + align - 1) & ~(align - 1);
+#endif
+    }
+
+    /**
+    * @brief ::operator new / ::operator delete honouring an alignment.
+    *
+    * Alignments above __STDCPP_DEFAULT_NEW_ALIGNMENT__ go through the std::align_val_t
+    * overloads; the rest use the plain ones. `align` must be a power of two, and the pair
+    * must be called with the same bytes and align.
+    */
+    inline void* aligned_operator_new(std::size_t bytes, std::size_t align) {
+        if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return ::operator new(bytes, std::align_val_t(align));
+        }
+        return ::operator new(bytes);
+    }
+
+    inline void aligned_operator_delete(void* p, std::size_t bytes, std::size_t align) noexcept {
+        if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            ::operator delete(p, bytes, std::align_val_t(align));
+        } else {
+            ::operator delete(p, bytes);
+        }
+    }
+
     /**
     * @brief A custom allocator class for managing memory.
     *
     * This class provides basic memory management functions, including:
-    * - Allocating and deallocating memory for objects using new/delete
+    * - Allocating and deallocating memory for objects using new/delete, honouring alignof(T)
+    *   for over-aligned types.
     * - Constructing objects in allocated memory using placement new.
     * - Destroying objects safely, with optimizations for trivial destructors.
     * - Rebinding to allocate memory for different types.
+    * - allocate_at_least, which rounds a request up to the block size malloc would hand out
+    *   anyway, so containers can use the slack as capacity.
+    * - Use in C++20 constant evaluation (see LSH_CONSTEXPR20), where blocks come from
+    *   std::allocator.
     *
     * @tparam T The type of objects this allocator will manage.
     */
@@ -33,6 +98,10 @@ namespace Lsh {
         typedef std::size_t    size_type;
         typedef std::ptrdiff_t difference_type;
 
+        // Stateless: any two instances can free each other's memory.
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type is_always_equal;
+
         template<class U>
         struct rebind {
             typedef allocator<U> other;
@@ -41,6 +110,12 @@ namespace Lsh {
     public:
         allocator() noexcept = default;
 
+        allocator(const allocator&) noexcept = default;
+
+        template<class U>
+        constexpr allocator(const allocator<U>&) noexcept {
+        }
+
         ~allocator() = default;
 
 
@@ -49,22 +124,25 @@ namespace Lsh {
 
         const_pointer address(const_reference x) const noexcept;
 
-        [[nodiscard]] static size_type max_size() noexcept;
+        [[nodiscard]] static constexpr size_type max_size() noexcept;
 
-        static pointer allocate(size_type n);
+        static LSH_CONSTEXPR20 pointer allocate(size_type n);
 
-        static void deallocate(pointer p, size_type n);
+        // Allocates at least n objects; deallocate must then be passed the returned count.
+        static LSH_CONSTEXPR20 allocation_result<pointer, size_type> allocate_at_least(size_type n);
 
-        void construct(pointer p);
+        static LSH_CONSTEXPR20 void deallocate(pointer p, size_type n);
 
-        void construct(pointer p, const_reference x);
+        LSH_CONSTEXPR20 void construct(pointer p);
+
+        LSH_CONSTEXPR20 void construct(pointer p, const_reference x);
 
         template<class U, class... Args>
-        void construct(U* p, Args&&... args);
+        LSH_CONSTEXPR20 void construct(U* p, Args&&... args);
 
-        void destroy(pointer p);
+        LSH_CONSTEXPR20 void destroy(pointer p);
 
-        void destroy(pointer first, pointer last);
+        LSH_CONSTEXPR20 void destroy(pointer first, pointer last);
     };
 
     template<class T>
@@ -78,44 +156,281 @@ namespace Lsh {
     }
 
     template<class T>
-    typename allocator<T>::size_type allocator<T>::max_size() noexcept {
+    constexpr typename allocator<T>::size_type allocator<T>::max_size() noexcept {
         return std::numeric_limits<size_type>::max() / sizeof(value_type);
     }
 
+    // Constant evaluation cannot call ::operator new; std::allocator is the one allocator the
+    // language lets allocate there, and the block must be freed before evaluation ends.
+    template<class T>
+    LSH_CONSTEXPR20 typename allocator<T>::pointer allocator<T>::allocate(size_type n) {
+        if (n > max_size()) {
+            throw std::bad_array_new_length();
+        }
+#if LSH_HAS_CONSTEXPR_ALLOCATION
+        if (std::is_constant_evaluated()) {
+            return std::allocator<T>().allocate(n);
+        }
+#endif
+        return static_cast<pointer>(aligned_operator_new(n * sizeof(T), alignof(T)));
+    }
+
     template<class T>
-    typename allocator<T>::pointer allocator<T>::allocate(size_type n) {
-        return static_cast<pointer>(::operator new(n * sizeof(T)));
+    LSH_CONSTEXPR20 allocation_result<typename allocator<T>::pointer, typename allocator<T>::size_type>
+    allocator<T>::allocate_at_least(size_type n) {
+        if (Lsh::is_constant_evaluated()) {
+            return {allocate(n), n};
+        }
+        // Ask ::operator new for the whole block explicitly, so the extra objects are ours
+        // even if operator new has been replaced. Over-aligned blocks come from the aligned
+        // overloads, whose rounding malloc_good_size does not describe.
+        if (n < max_size() && alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            const size_type count = malloc_good_size(n * sizeof(T)) / sizeof(T);
+            n = count < max_size() ? count : max_size();
+        }
+        return {allocate(n), n};
     }
 
     template<class T>
-    void allocator<T>::deallocate(pointer p, size_type n) {
-        ::operator delete(p, n * sizeof(T));
+    LSH_CONSTEXPR20 void allocator<T>::deallocate(pointer p, size_type n) {
+#if LSH_HAS_CONSTEXPR_ALLOCATION
+        if (std::is_constant_evaluated()) {
+            std::allocator<T>().deallocate(p, n);
+            return;
+        }
+#endif
+        aligned_operator_delete(p, n * sizeof(T), alignof(T));
     }
 
     template<class T>
-    void allocator<T>::construct(pointer p) {
+    LSH_CONSTEXPR20 void allocator<T>::construct(pointer p) {
         Lsh::construct(p);
     }
 
     template<class T>
-    void allocator<T>::construct(pointer p, const_reference x) {
+    LSH_CONSTEXPR20 void allocator<T>::construct(pointer p, const_reference x) {
         Lsh::construct(p, x);
     }
 
     template<class T>
     template<class U, class... Args>
-    void allocator<T>::construct(U* p, Args&&... args) {
+    LSH_CONSTEXPR20 void allocator<T>::construct(U* p, Args&&... args) {
         Lsh::construct(p, std::forward<Args>(args)...);
     }
 
     template<class T>
-    void allocator<T>::destroy(pointer p) {
+    LSH_CONSTEXPR20 void allocator<T>::destroy(pointer p) {
         Lsh::destroy(p);
     }
 
     template<class T>
-    void allocator<T>::destroy(pointer first, pointer last) {
+    LSH_CONSTEXPR20 void allocator<T>::destroy(pointer first, pointer last) {
         Lsh::destroy(first, last);
     }
+
+    template<class T, class U>
+    constexpr bool operator==(const allocator<T>&, const allocator<U>&) noexcept {
+        return true;
+    }
+
+    template<class T, class U>
+    constexpr bool operator!=(const allocator<T>&, const allocator<U>&) noexcept {
+        return false;
+    }
+
+    // allocator<T>::construct/destroy only forward to Lsh::construct/Lsh::destroy.
+    template<class T>
+    struct uses_default_construct<allocator<T>> : std::true_type {
+    };
+
+    /**
+    * @brief An allocator whose blocks start on an Align-byte boundary.
+    *
+    * Use it to request cache-line (64) or SIMD-width (32 for AVX, 64 for AVX-512) alignment
+    * for element types that do not declare it themselves, e.g.
+    * `Lsh::vector<float, Lsh::aligned_allocator<float, 32>>` lets kernels use aligned loads
+    * from data(). allocate_at_least rounds the block up to a multiple of the alignment, so the
+    * capacity covers whole SIMD registers or cache lines.
+    *
+    * @tparam T The type of objects this allocator will manage.
+    * @tparam Align The requested alignment, a power of two; alignof(T) wins if it is larger.
+    */
+    template<class T, std::size_t Align>
+    class aligned_allocator {
+        static_assert(Align != 0 && (Align & (Align - 1)) == 0, "Align must be a power of two");
+
+    public:
+        typedef T              value_type;
+        typedef T*             pointer;
+        typedef const T*       const_pointer;
+        typedef T&             reference;
+        typedef const T&       const_reference;
+        typedef std::size_t    size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type is_always_equal;
+
+        static constexpr std::size_t alignment = Align > alignof(T) ? Align : alignof(T);
+
+        template<class U>
+        struct rebind {
+            typedef aligned_allocator<U, Align> other;
+        };
+
+    public:
+        aligned_allocator() noexcept = default;
+
+        aligned_allocator(const aligned_allocator&) noexcept = default;
+
+        template<class U>
+        aligned_allocator(const aligned_allocator<U, Align>&) noexcept {
+        }
+
+        ~aligned_allocator() = default;
+
+        [[nodiscard]] static size_type max_size() noexcept {
+            return (std::numeric_limits<size_type>::max() - alignment) / sizeof(value_type);
+        }
+
+        static pointer allocate(size_type n) {
+            if (n > max_size()) {
+                throw std::bad_array_new_length();
+            }
+            return static_cast<pointer>(aligned_operator_new(n * sizeof(T), alignment));
+        }
+
+        static allocation_result<pointer, size_type> allocate_at_least(size_type n) {
+            if (n <= max_size()) {
+                n = ((n * sizeof(T) + alignment - 1) & ~(alignment - 1)) / sizeof(T);
+            }
+            return {allocate(n), n};
+        }
+
+        static void deallocate(pointer p, size_type n) noexcept {
+            aligned_operator_delete(p, n * sizeof(T), alignment);
+        }
+    };
+
+    template<class T, class U, std::size_t Align>
+    bool operator==(const aligned_allocator<T, Align>&, const aligned_allocator<U, Align>&) noexcept {
+        return true;
+    }
+
+    template<class T, class U, std::size_t Align>
+    bool operator!=(const aligned_allocator<T, Align>&, const aligned_allocator<U, Align>&) noexcept {
+        return false;
+    }
+
+    /*
+     * Optional allocator extensions, detected by containers at compile time.
+     *
+     * - reallocate(p, old_n, new_n): resizes a block and keeps its bytes, possibly moving it
+     *   (see malloc_allocator.h). Only valid for elements that can be relocated byte-wise.
+     * - allocate_at_least(n): returns an allocation_result whose count may exceed n. The
+     *   free function below falls back to allocate(n) for allocators without it.
+     * - allocate_zeroed(n): like allocate(n), but every byte of the block is zero (calloc or
+     *   fresh anonymous pages), so pages nobody writes need never be backed.
+     */
+    template<class Alloc, class = void>
+    struct has_reallocate : std::false_type {
+    };
+
+    template<class Alloc>
+    struct has_reallocate<Alloc, std::void_t<decltype(std::declval<Alloc&>().reallocate(
+                                     std::declval<typename std::allocator_traits<Alloc>::pointer>(),
+                                     std::size_t(), std::size_t()))>>
+        : std::true_type {
+    };
+
+    template<class Alloc, class = void>
+    struct has_allocate_at_least : std::false_type {
+    };
+
+    template<class Alloc>
+    struct has_allocate_at_least<Alloc, std::void_t<decltype(std::declval<Alloc&>().allocate_at_least(
+                                            std::size_t()))>>
+        : std::true_type {
+    };
+
+    template<class Alloc, class = void>
+    struct has_allocate_zeroed : std::false_type {
+    };
+
+    template<class Alloc>
+    struct has_allocate_zeroed<Alloc, std::void_t<decltype(std::declval<Alloc&>().allocate_zeroed(
+                                          std::size_t()))>>
+        : std::true_type {
+    };
+
+    template<class Alloc>
+    LSH_CONSTEXPR20 allocation_result<typename std::allocator_traits<Alloc>::pointer, std::size_t>
+    allocate_at_least_aux(Alloc& alloc, std::size_t n, std::true_type) {
+        auto result = alloc.allocate_at_least(n);
+        return {result.ptr, result.count};
+    }
+
+    template<class Alloc>
+    LSH_CONSTEXPR20 allocation_result<typename std::allocator_traits<Alloc>::pointer, std::size_t>
+    allocate_at_least_aux(Alloc& alloc, std::size_t n, std::false_type) {
+        return {std::allocator_traits<Alloc>::allocate(alloc, n), n};
+    }
+
+    template<class Alloc>
+    LSH_CONSTEXPR20 allocation_result<typename std::allocator_traits<Alloc>::pointer, std::size_t>
+    allocate_at_least(Alloc& alloc, std::size_t n) {
+        return allocate_at_least_aux(alloc, n, has_allocate_at_least<Alloc>());
+    }
+
+    /*
+     * Allocator propagation helpers for containers.
+     *
+     * Each helper copies, moves or swaps the allocators only when the corresponding
+     * propagate_on_container_* trait says so, and is a no-op otherwise.
+     */
+    template<class Alloc>
+    LSH_CONSTEXPR20 void alloc_on_copy_aux(Alloc& to, const Alloc& from, std::true_type) {
+        to = from;
+    }
+
+    template<class Alloc>
+    LSH_CONSTEXPR20 void alloc_on_copy_aux(Alloc&, const Alloc&, std::false_type) {
+    }
+
+    template<class Alloc>
+    LSH_CONSTEXPR20 void alloc_on_copy(Alloc& to, const Alloc& from) {
+        alloc_on_copy_aux(to, from, typename std::allocator_traits<Alloc>::
+                          propagate_on_container_copy_assignment());
+    }
+
+    template<class Alloc>
+    LSH_CONSTEXPR20 void alloc_on_move_aux(Alloc& to, Alloc& from, std::true_type) {
+        to = std::move(from);
+    }
+
+    template<class Alloc>
+    LSH_CONSTEXPR20 void alloc_on_move_aux(Alloc&, Alloc&, std::false_type) {
+    }
+
+    template<class Alloc>
+    LSH_CONSTEXPR20 void alloc_on_move(Alloc& to, Alloc& from) {
+        alloc_on_move_aux(to, from, typename std::allocator_traits<Alloc>::
+                          propagate_on_container_move_assignment());
+    }
+
+    template<class Alloc>
+    LSH_CONSTEXPR20 void alloc_on_swap_aux(Alloc& a, Alloc& b, std::true_type) {
+        using std::swap;
+        swap(a, b);
+    }
+
+    template<class Alloc>
+    LSH_CONSTEXPR20 void alloc_on_swap_aux(Alloc&, Alloc&, std::false_type) {
+    }
+
+    template<class Alloc>
+    LSH_CONSTEXPR20 void alloc_on_swap(Alloc& a, Alloc& b) {
+        alloc_on_swap_aux(a, b, typename std::allocator_traits<Alloc>::propagate_on_container_swap());
+    }
 }
 #endif //ALLOCATOR_H
@@ -0,0 +1,275 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include "allocator.h"
+
+namespace Lsh {
+    /**
+    * @brief A monotonic arena: allocation bumps a pointer through a chain of large chunks.
+    *
+    * - Individual blocks are never freed; reset() rewinds to the first chunk in O(1) and keeps
+    *   every chunk for reuse, release() returns all chunks to ::operator delete.
+    * - When the current chunk is exhausted the next chunk of the chain is reused if the request
+    *   fits, otherwise a new chunk is inserted after the current one. New chunks double in size
+    *   up to max_chunk_size (or the request, if larger).
+    * - The most recent block can be grown in place (see reallocate), which lets a vector that
+    *   is the last thing allocated extend without copying.
+    *
+    * Not thread-safe: use one arena per request or per thread.
+    */
+    class arena {
+    public:
+        static constexpr std::size_t default_chunk_size = 64 * 1024;
+        static constexpr std::size_t max_chunk_size     = 16 * 1024 * 1024;
+
+        explicit arena(std::size_t initial_chunk_size = default_chunk_size) noexcept
+            : next_chunk_size_(initial_chunk_size < sizeof(chunk_header) * 2 ? sizeof(chunk_header) * 2
+                                                                             : initial_chunk_size) {
+        }
+
+        arena(const arena&) = delete;
+
+        arena& operator=(const arena&) = delete;
+
+        ~arena() {
+            release();
+        }
+
+        // Returns `bytes` bytes aligned to `align` (a power of two).
+        void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t));
+
+        // Blocks are reclaimed only by reset() or release().
+        void deallocate(void*, std::size_t) noexcept {
+        }
+
+        /**
+        * @brief Resizes the block at p from old_bytes to new_bytes, keeping its contents.
+        *
+        * The most recently allocated block grows or shrinks in place while the current chunk
+        * has room; any other block is copied to a fresh allocation.
+        */
+        void* reallocate(void* p, std::size_t old_bytes, std::size_t new_bytes,
+                         std::size_t align = alignof(std::max_align_t));
+
+        // Makes every chunk available again without returning memory, in O(1).
+        void reset() noexcept;
+
+        // Returns every chunk to ::operator delete.
+        void release() noexcept;
+
+        // Bytes reserved in chunks, used or not.
+        std::size_t capacity() const noexcept {
+            return capacity_;
+        }
+
+    private:
+        struct chunk_header {
+            chunk_header* next;
+            std::size_t size; // including the header
+        };
+
+        char* chunk_begin(chunk_header* chunk) const noexcept {
+            return reinterpret_cast<char*>(chunk) + sizeof(chunk_header);
+        }
+
+        char* chunk_end(chunk_header* chunk) const noexcept {
+            return reinterpret_cast<char*>(chunk) + chunk->size;
+        }
+
+        static char* align_up(char* p, std::size_t align) noexcept {
+            const std::uintptr_t value = reinterpret_cast<std::uintptr_t>(p);
+            return p + ((align - value % align) % align);
+        }
+
+        // Moves to a chunk that can hold bytes at align, reusing the chain when possible.
+        void next_chunk(std::size_t bytes, std::size_t align);
+
+        chunk_header* first_   = nullptr; // head of the chain
+        chunk_header* current_ = nullptr; // chunk being bumped through
+        char* cursor_          = nullptr; // next free byte in current_
+        char* last_block_      = nullptr; // most recent block, for in-place reallocate
+        std::size_t next_chunk_size_;
+        std::size_t capacity_ = 0;
+    };
+
+    inline void* arena::allocate(std::size_t bytes, std::size_t align) {
+        if (current_) {
+            char* p = align_up(cursor_, align);
+            if (p <= chunk_end(current_) && bytes <= std::size_t(chunk_end(current_) - p)) {
+                cursor_     = p + bytes;
+                last_block_ = p;
+                return p;
+            }
+        }
+        next_chunk(bytes, align);
+        char* p     = align_up(cursor_, align);
+        cursor_     = p + bytes;
+        last_block_ = p;
+        return p;
+    }
+
+    inline void* arena::reallocate(void* p, std::size_t old_bytes, std::size_t new_bytes, std::size_t align) {
+        if (!p) {
+            return allocate(new_bytes, align);
+        }
+        char* block = static_cast<char*>(p);
+        if (block == last_block_ && block + old_bytes == cursor_ &&
+            new_bytes <= std::size_t(chunk_end(current_) - block)) {
+            cursor_ = block + new_bytes;
+            return p;
+        }
+        void* result = allocate(new_bytes, align);
+        std::memcpy(result, p, old_bytes < new_bytes ? old_bytes : new_bytes);
+        return result;
+    }
+
+    inline void arena::next_chunk(std::size_t bytes, std::size_t align) {
+        // Worst case the alignment padding is align - 1 bytes past the header.
+        if (bytes > std::numeric_limits<std::size_t>::max() - sizeof(chunk_header) - align) {
+            throw std::bad_alloc();
+        }
+        const std::size_t needed = sizeof(chunk_header) + align - 1 + bytes;
+
+        chunk_header* candidate = current_ ? current_->next : first_;
+        if (!candidate || candidate->size < needed) {
+            std::size_t size = next_chunk_size_;
+            while (size < needed && size < max_chunk_size) {
+                size *= 2;
+            }
+            if (size < needed) {
+                size = needed;
+            }
+            candidate       = static_cast<chunk_header*>(::operator new(size));
+            candidate->size = size;
+            capacity_ += size;
+            if (next_chunk_size_ < max_chunk_size) {
+                next_chunk_size_ *= 2;
+            }
+            // Splice in after the current chunk, keeping the rest of the chain for later.
+            if (current_) {
+                candidate->next = current_->next;
+                current_->next  = candidate;
+            } else {
+                candidate->next = first_;
+                first_          = candidate;
+            }
+        }
+        current_ = candidate;
+        cursor_  = chunk_begin(current_);
+    }
+
+    inline void arena::reset() noexcept {
+        current_    = first_;
+        cursor_     = first_ ? chunk_begin(first_) : nullptr;
+        last_block_ = nullptr;
+    }
+
+    inline void arena::release() noexcept {
+        while (first_) {
+            chunk_header* next = first_->next;
+            ::operator delete(first_, first_->size);
+            first_ = next;
+        }
+        current_    = nullptr;
+        cursor_     = nullptr;
+        last_block_ = nullptr;
+        capacity_   = 0;
+    }
+
+    /**
+    * @brief An allocator that draws from an Lsh::arena.
+    *
+    * deallocate does nothing; memory comes back when the arena is reset or released, so every
+    * container using the arena must be destroyed (or abandoned) before that. reallocate lets a
+    * vector of trivially relocatable elements grow in place at the top of the arena.
+    *
+    * Copies share the arena; two allocators are equal when they use the same arena. The
+    * allocator does not propagate, so a container keeps its arena across assignment and swap.
+    *
+    * @tparam T The type of objects this allocator will manage.
+    */
+    template<class T>
+    class arena_allocator {
+    public:
+        typedef T              value_type;
+        typedef T*             pointer;
+        typedef const T*       const_pointer;
+        typedef T&             reference;
+        typedef const T&       const_reference;
+        typedef std::size_t    size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        typedef std::false_type propagate_on_container_copy_assignment;
+        typedef std::false_type propagate_on_container_move_assignment;
+        typedef std::false_type propagate_on_container_swap;
+        typedef std::false_type is_always_equal;
+
+        template<class U>
+        struct rebind {
+            typedef arena_allocator<U> other;
+        };
+
+    public:
+        arena_allocator(arena& source) noexcept : arena_(std::addressof(source)) {
+        }
+
+        arena_allocator(const arena_allocator&) noexcept = default;
+
+        template<class U>
+        arena_allocator(const arena_allocator<U>& other) noexcept : arena_(other.get_arena()) {
+        }
+
+        ~arena_allocator() = default;
+
+        [[nodiscard]] static size_type max_size() noexcept {
+            return std::numeric_limits<size_type>::max() / sizeof(value_type);
+        }
+
+        pointer allocate(size_type n) {
+            if (n > max_size()) {
+                throw std::bad_alloc();
+            }
+            return static_cast<pointer>(arena_->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(pointer p, size_type n) noexcept {
+            arena_->deallocate(p, n * sizeof(T));
+        }
+
+        pointer reallocate(pointer p, size_type old_n, size_type new_n) {
+            if (new_n > max_size()) {
+                throw std::bad_alloc();
+            }
+            return static_cast<pointer>(arena_->reallocate(p, old_n * sizeof(T), new_n * sizeof(T), alignof(T)));
+        }
+
+        arena* get_arena() const noexcept {
+            return arena_;
+        }
+
+    private:
+        arena* arena_;
+    };
+
+    template<class T, class U>
+    bool operator==(const arena_allocator<T>& lhs, const arena_allocator<U>& rhs) noexcept {
+        return lhs.get_arena() == rhs.get_arena();
+    }
+
+    template<class T, class U>
+    bool operator!=(const arena_allocator<T>& lhs, const arena_allocator<U>& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+}
+#endif //ARENA_H
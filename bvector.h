@@ -0,0 +1,1086 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef BVECTOR_H
+#define BVECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include "allocator.h"
+#include "growth_policy.h"
+#include "vector.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LSH_HAS_AVX2 1
+#else
+#define LSH_HAS_AVX2 0
+#endif
+
+namespace Lsh {
+    // vector<bool> 的存储单元：每个字 64 位，第 i 位放在第 i / 64 个字的第 i % 64 位
+    typedef std::uint64_t bit_word;
+
+    constexpr std::size_t bit_word_bits = 64;
+
+    /*
+     * 整字运算核心
+     * -- 编译时开启 AVX2 时一次处理 4 个字（256 位），剩下不足 4 个字的部分逐字处理
+     * -- popcount/ctz 使用编译器内建函数，开启 -mpopcnt 时就是一条 popcnt 指令
+     */
+    struct bit_word_ops {
+        static std::size_t popcount(bit_word w) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<std::size_t>(__builtin_popcountll(w));
+#else
+            w = w - ((w >> 1) & 0x5555555555555555ULL);
+            w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+            w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+            return static_cast<std::size_t>((w * 0x0101010101010101ULL) >> 56);
+#endif
+        }
+
+        // 最低的 1 所在的位置，w 不能为 0
+        static std::size_t countr_zero(bit_word w) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<std::size_t>(__builtin_ctzll(w));
+#else
+            std::size_t n = 0;
+            while (!(w & 1)) {
+                w >>= 1;
+                ++n;
+            }
+            return n;
+#endif
+        }
+
+        // [p, p + n) 中 1 的个数
+        static std::size_t count(const bit_word* p, std::size_t n) noexcept {
+            std::size_t result = 0;
+            std::size_t i      = 0;
+#if LSH_HAS_AVX2
+            // 半字节查表求每个字节的 1 的个数，再用 sad 横向累加到 4 个 64 位计数器
+            const __m256i lookup   = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                      0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            const __m256i low_mask = _mm256_set1_epi8(0x0f);
+            __m256i acc            = _mm256_setzero_si256();
+            for (; i + 4 <= n; i += 4) {
+                const __m256i v   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+                const __m256i lo  = _mm256_and_si256(v, low_mask);
+                const __m256i hi  = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+                const __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                                    _mm256_shuffle_epi8(lookup, hi));
+                acc               = _mm256_add_epi64(acc, _mm256_sad_epu8(cnt, _mm256_setzero_si256()));
+            }
+            result += static_cast<std::size_t>(_mm256_extract_epi64(acc, 0)) +
+                      static_cast<std::size_t>(_mm256_extract_epi64(acc, 1)) +
+                      static_cast<std::size_t>(_mm256_extract_epi64(acc, 2)) +
+                      static_cast<std::size_t>(_mm256_extract_epi64(acc, 3));
+#endif
+            for (; i < n; ++i) {
+                result += popcount(p[i]);
+            }
+            return result;
+        }
+
+        // [p + first, p + n) 中第一个非零字的下标，没有则返回 n
+        static std::size_t find_nonzero(const bit_word* p, std::size_t first, std::size_t n) noexcept {
+            std::size_t i = first;
+#if LSH_HAS_AVX2
+            for (; i + 4 <= n; i += 4) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+                if (!_mm256_testz_si256(v, v)) {
+                    break;
+                }
+            }
+#endif
+            for (; i < n; ++i) {
+                if (p[i]) {
+                    return i;
+                }
+            }
+            return n;
+        }
+
+        static void flip(bit_word* p, std::size_t n) noexcept {
+            std::size_t i = 0;
+#if LSH_HAS_AVX2
+            const __m256i ones = _mm256_set1_epi64x(-1);
+            for (; i + 4 <= n; i += 4) {
+                __m256i* q = reinterpret_cast<__m256i*>(p + i);
+                _mm256_storeu_si256(q, _mm256_xor_si256(_mm256_loadu_si256(q), ones));
+            }
+#endif
+            for (; i < n; ++i) {
+                p[i] = ~p[i];
+            }
+        }
+
+        static void bit_and(bit_word* dst, const bit_word* src, std::size_t n) noexcept {
+            std::size_t i = 0;
+#if LSH_HAS_AVX2
+            for (; i + 4 <= n; i += 4) {
+                __m256i* d       = reinterpret_cast<__m256i*>(dst + i);
+                const __m256i* s = reinterpret_cast<const __m256i*>(src + i);
+                _mm256_storeu_si256(d, _mm256_and_si256(_mm256_loadu_si256(d), _mm256_loadu_si256(s)));
+            }
+#endif
+            for (; i < n; ++i) {
+                dst[i] &= src[i];
+            }
+        }
+
+        static void bit_or(bit_word* dst, const bit_word* src, std::size_t n) noexcept {
+            std::size_t i = 0;
+#if LSH_HAS_AVX2
+            for (; i + 4 <= n; i += 4) {
+                __m256i* d       = reinterpret_cast<__m256i*>(dst + i);
+                const __m256i* s = reinterpret_cast<const __m256i*>(src + i);
+                _mm256_storeu_si256(d, _mm256_or_si256(_mm256_loadu_si256(d), _mm256_loadu_si256(s)));
+            }
+#endif
+            for (; i < n; ++i) {
+                dst[i] |= src[i];
+            }
+        }
+
+        static void bit_xor(bit_word* dst, const bit_word* src, std::size_t n) noexcept {
+            std::size_t i = 0;
+#if LSH_HAS_AVX2
+            for (; i + 4 <= n; i += 4) {
+                __m256i* d       = reinterpret_cast<__m256i*>(dst + i);
+                const __m256i* s = reinterpret_cast<const __m256i*>(src + i);
+                _mm256_storeu_si256(d, _mm256_xor_si256(_mm256_loadu_si256(d), _mm256_loadu_si256(s)));
+            }
+#endif
+            for (; i < n; ++i) {
+                dst[i] ^= src[i];
+            }
+        }
+    };
+
+    // 指向单个位的代理引用
+    class bit_reference {
+    public:
+        bit_reference(bit_word* word, bit_word mask) noexcept : word_(word), mask_(mask) {
+        }
+
+        bit_reference(const bit_reference&) = default;
+
+        operator bool() const noexcept {
+            return (*word_ & mask_) != 0;
+        }
+
+        bit_reference& operator=(bool value) noexcept {
+            if (value) {
+                *word_ |= mask_;
+            } else {
+                *word_ &= ~mask_;
+            }
+            return *this;
+        }
+
+        bit_reference& operator=(const bit_reference& other) noexcept {
+            return *this = bool(other);
+        }
+
+        bool operator~() const noexcept {
+            return !bool(*this);
+        }
+
+        void flip() noexcept {
+            *word_ ^= mask_;
+        }
+
+        // std::swap 不接受代理对象，由 ADL 找到这几个重载
+        friend void swap(bit_reference lhs, bit_reference rhs) noexcept {
+            const bool temp = lhs;
+            lhs             = bool(rhs);
+            rhs             = temp;
+        }
+
+        friend void swap(bit_reference lhs, bool& rhs) noexcept {
+            const bool temp = lhs;
+            lhs             = rhs;
+            rhs             = temp;
+        }
+
+        friend void swap(bool& lhs, bit_reference rhs) noexcept {
+            const bool temp = lhs;
+            lhs             = bool(rhs);
+            rhs             = temp;
+        }
+
+    private:
+        bit_word* word_;
+        bit_word mask_;
+    };
+
+    /*
+     * 位迭代器：字指针 + 字内偏移
+     * -- 随机访问迭代器，可以直接用于 std::copy、std::rotate 等算法
+     */
+    class bit_iterator_base {
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef bool                            value_type;
+        typedef std::ptrdiff_t                  difference_type;
+
+        bit_iterator_base(bit_word* word, unsigned offset) noexcept : word_(word), offset_(offset) {
+        }
+
+        friend bool operator==(const bit_iterator_base& lhs, const bit_iterator_base& rhs) noexcept {
+            return lhs.word_ == rhs.word_ && lhs.offset_ == rhs.offset_;
+        }
+
+        friend bool operator!=(const bit_iterator_base& lhs, const bit_iterator_base& rhs) noexcept {
+            return !(lhs == rhs);
+        }
+
+        friend bool operator<(const bit_iterator_base& lhs, const bit_iterator_base& rhs) noexcept {
+            return lhs.word_ < rhs.word_ || (lhs.word_ == rhs.word_ && lhs.offset_ < rhs.offset_);
+        }
+
+        friend bool operator>(const bit_iterator_base& lhs, const bit_iterator_base& rhs) noexcept {
+            return rhs < lhs;
+        }
+
+        friend bool operator<=(const bit_iterator_base& lhs, const bit_iterator_base& rhs) noexcept {
+            return !(rhs < lhs);
+        }
+
+        friend bool operator>=(const bit_iterator_base& lhs, const bit_iterator_base& rhs) noexcept {
+            return !(lhs < rhs);
+        }
+
+        friend difference_type operator-(const bit_iterator_base& lhs, const bit_iterator_base& rhs) noexcept {
+            return difference_type(bit_word_bits) * (lhs.word_ - rhs.word_) +
+                   difference_type(lhs.offset_) - difference_type(rhs.offset_);
+        }
+
+    protected:
+        void bump_up() noexcept {
+            if (offset_++ == bit_word_bits - 1) {
+                offset_ = 0;
+                ++word_;
+            }
+        }
+
+        void bump_down() noexcept {
+            if (offset_-- == 0) {
+                offset_ = bit_word_bits - 1;
+                --word_;
+            }
+        }
+
+        void advance(difference_type n) noexcept {
+            difference_type m = n + difference_type(offset_);
+            word_ += m / difference_type(bit_word_bits);
+            m %= difference_type(bit_word_bits);
+            if (m < 0) {
+                m += difference_type(bit_word_bits);
+                --word_;
+            }
+            offset_ = static_cast<unsigned>(m);
+        }
+
+        bit_word* word_;
+        unsigned offset_;
+    };
+
+    class bit_iterator : public bit_iterator_base {
+    public:
+        typedef bit_reference  reference;
+        typedef bit_reference* pointer;
+
+        bit_iterator() noexcept : bit_iterator_base(nullptr, 0) {
+        }
+
+        bit_iterator(bit_word* word, unsigned offset) noexcept : bit_iterator_base(word, offset) {
+        }
+
+        reference operator*() const noexcept {
+            return reference(word_, bit_word(1) << offset_);
+        }
+
+        reference operator[](difference_type n) const noexcept {
+            return *(*this + n);
+        }
+
+        bit_iterator& operator++() noexcept {
+            bump_up();
+            return *this;
+        }
+
+        bit_iterator operator++(int) noexcept {
+            bit_iterator temp = *this;
+            bump_up();
+            return temp;
+        }
+
+        bit_iterator& operator--() noexcept {
+            bump_down();
+            return *this;
+        }
+
+        bit_iterator operator--(int) noexcept {
+            bit_iterator temp = *this;
+            bump_down();
+            return temp;
+        }
+
+        bit_iterator& operator+=(difference_type n) noexcept {
+            advance(n);
+            return *this;
+        }
+
+        bit_iterator& operator-=(difference_type n) noexcept {
+            advance(-n);
+            return *this;
+        }
+
+        bit_iterator operator+(difference_type n) const noexcept {
+            bit_iterator temp = *this;
+            return temp += n;
+        }
+
+        bit_iterator operator-(difference_type n) const noexcept {
+            bit_iterator temp = *this;
+            return temp -= n;
+        }
+
+        friend bit_iterator operator+(difference_type n, const bit_iterator& it) noexcept {
+            return it + n;
+        }
+    };
+
+    class bit_const_iterator : public bit_iterator_base {
+    public:
+        typedef bool        reference;
+        typedef const bool* pointer;
+
+        bit_const_iterator() noexcept : bit_iterator_base(nullptr, 0) {
+        }
+
+        bit_const_iterator(const bit_word* word, unsigned offset) noexcept
+            : bit_iterator_base(const_cast<bit_word*>(word), offset) {
+        }
+
+        bit_const_iterator(const bit_iterator& it) noexcept : bit_iterator_base(it) {
+        }
+
+        reference operator*() const noexcept {
+            return (*word_ >> offset_) & 1;
+        }
+
+        reference operator[](difference_type n) const noexcept {
+            return *(*this + n);
+        }
+
+        bit_const_iterator& operator++() noexcept {
+            bump_up();
+            return *this;
+        }
+
+        bit_const_iterator operator++(int) noexcept {
+            bit_const_iterator temp = *this;
+            bump_up();
+            return temp;
+        }
+
+        bit_const_iterator& operator--() noexcept {
+            bump_down();
+            return *this;
+        }
+
+        bit_const_iterator operator--(int) noexcept {
+            bit_const_iterator temp = *this;
+            bump_down();
+            return temp;
+        }
+
+        bit_const_iterator& operator+=(difference_type n) noexcept {
+            advance(n);
+            return *this;
+        }
+
+        bit_const_iterator& operator-=(difference_type n) noexcept {
+            advance(-n);
+            return *this;
+        }
+
+        bit_const_iterator operator+(difference_type n) const noexcept {
+            bit_const_iterator temp = *this;
+            return temp += n;
+        }
+
+        bit_const_iterator operator-(difference_type n) const noexcept {
+            bit_const_iterator temp = *this;
+            return temp -= n;
+        }
+
+        friend bit_const_iterator operator+(difference_type n, const bit_const_iterator& it) noexcept {
+            return it + n;
+        }
+    };
+
+    /*
+     * vector<bool> 特化：每个元素只占一位
+     * -- 按 64 位字存储，内存通过 Allocator rebind 到 bit_word 后分配，容量以字为单位增长
+     * -- operator[] 返回代理引用 bit_reference，迭代器不是 bool*
+     * -- 不变式：最后一个字中 size() 之后的位总是 0，count/find/比较可以直接按整字处理
+     * -- 整字运算：count、find_first/find_next、flip 以及 &=、|=、^=，见 bit_word_ops
+     */
+    template<class Allocator, class GrowthPolicy>
+    class vector<bool, Allocator, GrowthPolicy> {
+    public:
+        using value_type             = bool;
+        using allocator_type         = Allocator;
+        using word_type              = bit_word;
+        using reference              = bit_reference;
+        using const_reference        = bool;
+        using iterator               = bit_iterator;
+        using const_iterator         = bit_const_iterator;
+        using reverse_iterator       = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+        using size_type              = std::size_t;
+        using difference_type        = std::ptrdiff_t;
+
+        // find_first/find_next 找不到时的返回值
+        static constexpr size_type npos = static_cast<size_type>(-1);
+
+    private:
+        using word_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<word_type>;
+        using word_traits    = std::allocator_traits<word_allocator>;
+
+        static constexpr size_type word_bits = bit_word_bits;
+
+        /*
+         * [ word 0 | word 1 | word 2 | ... ]
+         *  |                 |
+         *  words_       size_ 位所在的字        capacity_ 个字
+         */
+        struct bvector_impl : public word_allocator {
+            word_type* words_{nullptr};
+            size_type size_{0};     // 位数
+            size_type capacity_{0}; // 字数
+
+            bvector_impl() = default;
+
+            explicit bvector_impl(const word_allocator& alloc) noexcept : word_allocator(alloc) {
+            }
+
+            explicit bvector_impl(word_allocator&& alloc) noexcept : word_allocator(std::move(alloc)) {
+            }
+
+            ~bvector_impl() {
+                if (words_) {
+                    word_traits::deallocate(*this, words_, capacity_);
+                }
+            }
+        };
+
+        bvector_impl impl_;
+
+    public:
+        //===============================构造函数==============================
+        vector() = default;
+
+        explicit vector(const Allocator& alloc) noexcept : impl_(word_allocator(alloc)) {
+        }
+
+        explicit vector(size_type count, const Allocator& alloc = Allocator()) : vector(count, false, alloc) {
+        }
+
+        vector(size_type count, bool value, const Allocator& alloc = Allocator()) : impl_(word_allocator(alloc)) {
+            create_storage(words_for(check_init_len(count)));
+            grow_size(count);
+            set_range(0, count, value);
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        vector(InputIterator first, InputIterator last, const Allocator& alloc = Allocator())
+            : impl_(word_allocator(alloc)) {
+            range_initialize(first, last, std::__iterator_category(first));
+        }
+
+        vector(std::initializer_list<bool> init, const Allocator& alloc = Allocator())
+            : impl_(word_allocator(alloc)) {
+            range_initialize(init.begin(), init.end(), std::random_access_iterator_tag());
+        }
+
+        vector(const vector& other)
+            : impl_(word_traits::select_on_container_copy_construction(other.get_alloc())) {
+            create_storage(other.word_count());
+            copy_words_from(other);
+        }
+
+        vector(vector&& other) noexcept : impl_(std::move(other.get_alloc())) {
+            steal_storage(other);
+        }
+
+        ~vector() = default;
+
+        //===============================赋值运算符==============================
+        vector& operator=(const vector& other) {
+            if (std::addressof(other) != this) {
+                if (word_traits::propagate_on_container_copy_assignment::value &&
+                    get_alloc() != other.get_alloc()) {
+                    // 新分配器无法释放旧内存，先归还
+                    release_storage();
+                }
+                alloc_on_copy(get_alloc(), other.get_alloc());
+                if (other.word_count() > impl_.capacity_) {
+                    release_storage();
+                    create_storage(other.word_count());
+                }
+                copy_words_from(other);
+            }
+            return *this;
+        }
+
+        vector& operator=(vector&& other) noexcept(word_traits::propagate_on_container_move_assignment::value ||
+                                                   word_traits::is_always_equal::value) {
+            if (word_traits::propagate_on_container_move_assignment::value ||
+                word_traits::is_always_equal::value || get_alloc() == other.get_alloc()) {
+                release_storage();
+                alloc_on_move(get_alloc(), other.get_alloc());
+                steal_storage(other);
+            } else {
+                *this = static_cast<const vector&>(other);
+                other.clear();
+            }
+            return *this;
+        }
+
+        vector& operator=(std::initializer_list<bool> ilist) {
+            this->assign(ilist.begin(), ilist.end());
+            return *this;
+        }
+
+        //=============================== assign ===============================
+        void assign(size_type count, bool value) {
+            clear();
+            reserve(count);
+            grow_size(count);
+            set_range(0, count, value);
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        void assign(InputIterator first, InputIterator last) {
+            clear();
+            range_initialize(first, last, std::__iterator_category(first));
+        }
+
+        void assign(std::initializer_list<bool> ilist) {
+            this->assign(ilist.begin(), ilist.end());
+        }
+
+        allocator_type get_allocator() const noexcept {
+            return allocator_type(get_alloc());
+        }
+
+        //================================ 元素访问 =================================
+        reference at(size_type index) {
+            if (index >= size()) {
+                throw std::out_of_range("vector<bool>::at");
+            }
+            return (*this)[index];
+        }
+
+        const_reference at(size_type index) const {
+            if (index >= size()) {
+                throw std::out_of_range("vector<bool>::at");
+            }
+            return (*this)[index];
+        }
+
+        reference operator[](size_type index) noexcept {
+            return reference(impl_.words_ + index / word_bits, word_type(1) << (index % word_bits));
+        }
+
+        const_reference operator[](size_type index) const noexcept {
+            return (impl_.words_[index / word_bits] >> (index % word_bits)) & 1;
+        }
+
+        reference front() noexcept {
+            return (*this)[0];
+        }
+
+        const_reference front() const noexcept {
+            return (*this)[0];
+        }
+
+        reference back() noexcept {
+            return (*this)[size() - 1];
+        }
+
+        const_reference back() const noexcept {
+            return (*this)[size() - 1];
+        }
+
+        // 底层的字数组，共 word_count() 个字，最后一个字中 size() 之后的位为 0
+        const word_type* words() const noexcept {
+            return impl_.words_;
+        }
+
+        size_type word_count() const noexcept {
+            return words_for(size());
+        }
+
+        //================================ 迭代器 ==================================
+        iterator begin() noexcept {
+            return iterator(impl_.words_, 0);
+        }
+
+        const_iterator begin() const noexcept {
+            return const_iterator(impl_.words_, 0);
+        }
+
+        const_iterator cbegin() const noexcept {
+            return begin();
+        }
+
+        iterator end() noexcept {
+            return bit_at(size());
+        }
+
+        const_iterator end() const noexcept {
+            return const_iterator(impl_.words_ + size() / word_bits, size() % word_bits);
+        }
+
+        const_iterator cend() const noexcept {
+            return end();
+        }
+
+        reverse_iterator rbegin() noexcept {
+            return reverse_iterator(end());
+        }
+
+        const_reverse_iterator rbegin() const noexcept {
+            return const_reverse_iterator(end());
+        }
+
+        const_reverse_iterator crbegin() const noexcept {
+            return rbegin();
+        }
+
+        reverse_iterator rend() noexcept {
+            return reverse_iterator(begin());
+        }
+
+        const_reverse_iterator rend() const noexcept {
+            return const_reverse_iterator(begin());
+        }
+
+        const_reverse_iterator crend() const noexcept {
+            return rend();
+        }
+
+        //==================================== 容量 ================================
+        [[nodiscard]] bool empty() const noexcept {
+            return impl_.size_ == 0;
+        }
+
+        [[nodiscard]] size_type size() const noexcept {
+            return impl_.size_;
+        }
+
+        // 迭代器之差是 ptrdiff_t，位数不能超过它
+        [[nodiscard]] size_type max_size() const noexcept {
+            const size_type diffmax  = static_cast<size_type>(std::numeric_limits<difference_type>::max());
+            const size_type allocmax = word_traits::max_size(get_alloc());
+            return allocmax > diffmax / word_bits ? diffmax : allocmax * word_bits;
+        }
+
+        [[nodiscard]] size_type capacity() const noexcept {
+            return impl_.capacity_ * word_bits;
+        }
+
+        void reserve(size_type new_cap) {
+            if (new_cap > max_size()) {
+                throw std::length_error("vector<bool>::reserve(): new capacity too large");
+            }
+            if (new_cap > capacity()) {
+                reallocate_storage(words_for(new_cap));
+            }
+        }
+
+        void shrink_to_fit() {
+            if (impl_.capacity_ > word_count()) {
+                reallocate_storage(word_count());
+            }
+        }
+
+        //======================================================================
+        //-------------------------------- 修改器 -------------------------------
+        //======================================================================
+        void clear() noexcept {
+            impl_.size_ = 0;
+        }
+
+        void push_back(bool value) {
+            if (size() == capacity()) {
+                reallocate_storage(check_len(1, "vector<bool>::push_back()"));
+            }
+            const size_type index = size();
+            grow_size(index + 1);
+            (*this)[index] = value;
+        }
+
+        template<class... Args>
+        void emplace_back(Args&&... args) {
+            push_back(bool(std::forward<Args>(args)...));
+        }
+
+        void pop_back() noexcept {
+            --impl_.size_;
+            clear_tail();
+        }
+
+        iterator insert(const_iterator pos, bool value) {
+            return insert(pos, size_type(1), value);
+        }
+
+        iterator insert(const_iterator pos, size_type count, bool value) {
+            const size_type index = pos - cbegin();
+            make_gap(index, count, "vector<bool>::insert()");
+            set_range(index, index + count, value);
+            return bit_at(index);
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        iterator insert(const_iterator pos, InputIterator first, InputIterator last) {
+            const size_type index = pos - cbegin();
+            range_insert(index, first, last, std::__iterator_category(first));
+            return bit_at(index);
+        }
+
+        iterator insert(const_iterator pos, std::initializer_list<bool> ilist) {
+            return insert(pos, ilist.begin(), ilist.end());
+        }
+
+        template<class... Args>
+        iterator emplace(const_iterator pos, Args&&... args) {
+            return insert(pos, bool(std::forward<Args>(args)...));
+        }
+
+        iterator erase(const_iterator pos) {
+            return erase(pos, pos + 1);
+        }
+
+        iterator erase(const_iterator first, const_iterator last) {
+            const size_type index = first - cbegin();
+            const size_type count = last - first;
+            if (count != 0) {
+                std::copy(bit_at(index + count), end(), bit_at(index));
+                impl_.size_ -= count;
+                clear_tail();
+            }
+            return bit_at(index);
+        }
+
+        void resize(size_type count, bool value = false) {
+            if (count < size()) {
+                impl_.size_ = count;
+                clear_tail();
+            } else if (count > size()) {
+                insert(cend(), count - size(), value);
+            }
+        }
+
+        // 翻转所有位
+        void flip() noexcept {
+            bit_word_ops::flip(impl_.words_, word_count());
+            clear_tail();
+        }
+
+        void swap(vector& other) noexcept {
+            using std::swap;
+            swap(impl_.words_, other.impl_.words_);
+            swap(impl_.size_, other.impl_.size_);
+            swap(impl_.capacity_, other.impl_.capacity_);
+            alloc_on_swap(get_alloc(), other.get_alloc());
+        }
+
+        static void swap(reference lhs, reference rhs) noexcept {
+            const bool temp = lhs;
+            lhs             = bool(rhs);
+            rhs             = temp;
+        }
+
+        //================================ 整字运算 ================================
+        // 值为 true 的元素个数
+        [[nodiscard]] size_type count() const noexcept {
+            return bit_word_ops::count(impl_.words_, word_count());
+        }
+
+        [[nodiscard]] bool any() const noexcept {
+            return bit_word_ops::find_nonzero(impl_.words_, 0, word_count()) != word_count();
+        }
+
+        [[nodiscard]] bool none() const noexcept {
+            return !any();
+        }
+
+        [[nodiscard]] bool all() const noexcept {
+            return count() == size();
+        }
+
+        // 第一个 true 的下标，没有则返回 npos
+        [[nodiscard]] size_type find_first() const noexcept {
+            return find_from(0);
+        }
+
+        // pos 之后第一个 true 的下标，没有则返回 npos
+        [[nodiscard]] size_type find_next(size_type pos) const noexcept {
+            return pos + 1 >= size() ? npos : find_from(pos + 1);
+        }
+
+        // 按位与/或/异或，两边长度必须相同
+        vector& operator&=(const vector& other) {
+            check_same_size(other);
+            bit_word_ops::bit_and(impl_.words_, other.impl_.words_, word_count());
+            return *this;
+        }
+
+        vector& operator|=(const vector& other) {
+            check_same_size(other);
+            bit_word_ops::bit_or(impl_.words_, other.impl_.words_, word_count());
+            return *this;
+        }
+
+        vector& operator^=(const vector& other) {
+            check_same_size(other);
+            bit_word_ops::bit_xor(impl_.words_, other.impl_.words_, word_count());
+            return *this;
+        }
+
+    private:
+        //==========================工具函数=======================
+        word_allocator& get_alloc() noexcept {
+            return impl_;
+        }
+
+        const word_allocator& get_alloc() const noexcept {
+            return impl_;
+        }
+
+        static size_type words_for(size_type bits) noexcept {
+            return (bits + word_bits - 1) / word_bits;
+        }
+
+        iterator bit_at(size_type index) noexcept {
+            return iterator(impl_.words_ + index / word_bits, index % word_bits);
+        }
+
+        // 分配 count 个字，未初始化
+        void create_storage(size_type count) {
+            if (count != 0) {
+                const auto storage = Lsh::allocate_at_least(get_alloc(), count);
+                impl_.words_       = storage.ptr;
+                impl_.capacity_    = storage.count;
+            }
+        }
+
+        void release_storage() noexcept {
+            if (impl_.words_) {
+                word_traits::deallocate(get_alloc(), impl_.words_, impl_.capacity_);
+            }
+            impl_.words_    = nullptr;
+            impl_.size_     = 0;
+            impl_.capacity_ = 0;
+        }
+
+        void steal_storage(vector& other) noexcept {
+            impl_.words_          = other.impl_.words_;
+            impl_.size_           = other.impl_.size_;
+            impl_.capacity_       = other.impl_.capacity_;
+            other.impl_.words_    = nullptr;
+            other.impl_.size_     = 0;
+            other.impl_.capacity_ = 0;
+        }
+
+        // 容量足够时调用
+        void copy_words_from(const vector& other) noexcept {
+            if (other.word_count() != 0) {
+                std::memcpy(impl_.words_, other.impl_.words_, other.word_count() * sizeof(word_type));
+            }
+            impl_.size_ = other.size();
+        }
+
+        // 换成一块 count 个字的新内存，整字 memcpy
+        void reallocate_storage(size_type count) {
+            word_type* new_words   = nullptr;
+            size_type new_capacity = 0;
+            if (count != 0) {
+                const auto storage = Lsh::allocate_at_least(get_alloc(), count);
+                new_words          = storage.ptr;
+                new_capacity       = storage.count;
+                if (word_count() != 0) {
+                    std::memcpy(new_words, impl_.words_, word_count() * sizeof(word_type));
+                }
+            }
+            if (impl_.words_) {
+                word_traits::deallocate(get_alloc(), impl_.words_, impl_.capacity_);
+            }
+            impl_.words_    = new_words;
+            impl_.capacity_ = new_capacity;
+        }
+
+        /*
+         * 把 size() 增大到 new_size，容量必须足够
+         * -- 新用到的字先清零以维持不变式；新增的位由调用者写入
+         */
+        void grow_size(size_type new_size) noexcept {
+            const size_type old_words = word_count();
+            const size_type new_words = words_for(new_size);
+            if (new_words > old_words) {
+                std::memset(impl_.words_ + old_words, 0, (new_words - old_words) * sizeof(word_type));
+            }
+            impl_.size_ = new_size;
+        }
+
+        // 清掉最后一个字中 size() 之后的位
+        void clear_tail() noexcept {
+            const size_type tail = size() % word_bits;
+            if (tail != 0) {
+                impl_.words_[size() / word_bits] &= (word_type(1) << tail) - 1;
+            }
+        }
+
+        // 把 [first,last) 的位全部置为 value，中间的整字直接 memset
+        void set_range(size_type first, size_type last, bool value) noexcept {
+            if (first == last) {
+                return;
+            }
+            const size_type first_word = first / word_bits;
+            const size_type last_word  = (last - 1) / word_bits;
+            const word_type head       = ~word_type(0) << (first % word_bits);
+            const word_type tail       = ~word_type(0) >> (word_bits - 1 - (last - 1) % word_bits);
+            if (first_word == last_word) {
+                set_masked(impl_.words_[first_word], head & tail, value);
+                return;
+            }
+            set_masked(impl_.words_[first_word], head, value);
+            if (last_word > first_word + 1) {
+                std::memset(impl_.words_ + first_word + 1, value ? 0xff : 0,
+                            (last_word - first_word - 1) * sizeof(word_type));
+            }
+            set_masked(impl_.words_[last_word], tail, value);
+        }
+
+        static void set_masked(word_type& word, word_type mask, bool value) noexcept {
+            if (value) {
+                word |= mask;
+            } else {
+                word &= ~mask;
+            }
+        }
+
+        // 在 index 处腾出 count 位，新位的值未定
+        void make_gap(size_type index, size_type count, const char* s) {
+            if (count == 0) {
+                return;
+            }
+            if (capacity() - size() < count) {
+                reallocate_storage(check_len(count, s));
+            }
+            const size_type old_size = size();
+            grow_size(old_size + count);
+            std::copy_backward(bit_at(index), bit_at(old_size), bit_at(old_size + count));
+        }
+
+        template<class InputIterator>
+        void range_initialize(InputIterator first, InputIterator last, std::input_iterator_tag) {
+            for (; first != last; ++first) {
+                push_back(*first);
+            }
+        }
+
+        template<class ForwardIterator>
+        void range_initialize(ForwardIterator first, ForwardIterator last, std::forward_iterator_tag) {
+            const size_type count = check_init_len(std::distance(first, last));
+            reserve(count);
+            grow_size(count);
+            std::copy(first, last, begin());
+        }
+
+        // 单趟迭代器：先追加到末尾，再转到 index
+        template<class InputIterator>
+        void range_insert(size_type index, InputIterator first, InputIterator last, std::input_iterator_tag) {
+            const size_type old_size = size();
+            for (; first != last; ++first) {
+                push_back(*first);
+            }
+            std::rotate(bit_at(index), bit_at(old_size), end());
+        }
+
+        template<class ForwardIterator>
+        void range_insert(size_type index, ForwardIterator first, ForwardIterator last, std::forward_iterator_tag) {
+            const size_type count = std::distance(first, last);
+            make_gap(index, count, "vector<bool>::insert()");
+            std::copy(first, last, bit_at(index));
+        }
+
+        // 从 pos 开始找第一个 true：先看 pos 所在的字，之后整字跳过 0
+        size_type find_from(size_type pos) const noexcept {
+            if (pos >= size()) {
+                return npos;
+            }
+            size_type word_index  = pos / word_bits;
+            const word_type first = impl_.words_[word_index] & (~word_type(0) << (pos % word_bits));
+            if (first) {
+                return word_index * word_bits + bit_word_ops::countr_zero(first);
+            }
+            word_index = bit_word_ops::find_nonzero(impl_.words_, word_index + 1, word_count());
+            if (word_index == word_count()) {
+                return npos;
+            }
+            return word_index * word_bits + bit_word_ops::countr_zero(impl_.words_[word_index]);
+        }
+
+        void check_same_size(const vector& other) const {
+            if (size() != other.size()) {
+                throw std::invalid_argument("vector<bool>: operands have different sizes");
+            }
+        }
+
+        size_type check_init_len(size_type count) const {
+            if (count > max_size()) {
+                throw std::length_error("vector<bool> size is greater than max_size()");
+            }
+            return count;
+        }
+
+        // 扩容时调用，返回新的字数
+        size_type check_len(size_type count, const char* s) const {
+            if (max_size() - size() < count) {
+                throw std::length_error(s);
+            }
+            const size_type required = words_for(size() + count);
+            const size_type len      = GrowthPolicy::next_capacity(word_count(), required, sizeof(word_type));
+            const size_type max_len  = words_for(max_size());
+            return (len < required || len > max_len) ? max_len : len;
+        }
+    };
+
+    //==================================== 非成员函数 ==========================
+    // 比 vector 的通用版本更特化：不变式保证尾部为 0，直接比较整字
+    template<class Allocator, class GrowthPolicy>
+    bool operator==(const vector<bool, Allocator, GrowthPolicy>& lhs,
+                    const vector<bool, Allocator, GrowthPolicy>& rhs) {
+        return lhs.size() == rhs.size() &&
+               (lhs.word_count() == 0 ||
+                std::memcmp(lhs.words(), rhs.words(), lhs.word_count() * sizeof(bit_word)) == 0);
+    }
+}
+#endif //BVECTOR_H
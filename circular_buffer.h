@@ -0,0 +1,710 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef CIRCULAR_BUFFER_H
+#define CIRCULAR_BUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "allocator.h"
+#include "construct.h"
+
+namespace Lsh {
+    /*
+     * circular_buffer 满时的处理策略
+     * -- overwrite_oldest：覆盖最旧的元素，适合滑动窗口、历史记录
+     * -- reject_when_full：丢弃新元素，push_back 返回 false，适合有界队列
+     */
+    struct overwrite_oldest {
+        static constexpr bool overwrite = true;
+    };
+
+    struct reject_when_full {
+        static constexpr bool overwrite = false;
+    };
+
+    /*
+     * circular_buffer 的迭代器
+     * -- 保存容器指针和逻辑下标（0 是最旧的元素），解引用时才换算成环上的位置
+     * -- 在满的 overwrite_oldest 缓冲区中 push_back 会改变逻辑下标对应的元素
+     */
+    template<class Buffer, class Ref, class Ptr>
+    class circular_buffer_iterator {
+        template<class, class, class>
+        friend class circular_buffer_iterator;
+
+        using mutable_iterator = circular_buffer_iterator<typename std::remove_const<Buffer>::type,
+                                                          typename Buffer::reference, typename Buffer::pointer>;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = typename Buffer::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = Ptr;
+        using reference         = Ref;
+        using size_type         = std::size_t;
+
+        circular_buffer_iterator() noexcept = default;
+
+        circular_buffer_iterator(Buffer* buffer, size_type index) noexcept : buffer_(buffer), index_(index) {
+        }
+
+        // iterator 可以隐式转换为 const_iterator
+        template<class It, typename = typename std::enable_if<
+                               std::is_same<It, mutable_iterator>::value &&
+                               !std::is_same<It, circular_buffer_iterator>::value>::type>
+        circular_buffer_iterator(const It& other) noexcept : buffer_(other.buffer_), index_(other.index_) {
+        }
+
+        reference operator*() const noexcept {
+            return (*buffer_)[index_];
+        }
+
+        pointer operator->() const noexcept {
+            return std::addressof((*buffer_)[index_]);
+        }
+
+        reference operator[](difference_type n) const noexcept {
+            return (*buffer_)[index_ + n];
+        }
+
+        circular_buffer_iterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+
+        circular_buffer_iterator operator++(int) noexcept {
+            circular_buffer_iterator temp = *this;
+            ++index_;
+            return temp;
+        }
+
+        circular_buffer_iterator& operator--() noexcept {
+            --index_;
+            return *this;
+        }
+
+        circular_buffer_iterator operator--(int) noexcept {
+            circular_buffer_iterator temp = *this;
+            --index_;
+            return temp;
+        }
+
+        circular_buffer_iterator& operator+=(difference_type n) noexcept {
+            index_ += n;
+            return *this;
+        }
+
+        circular_buffer_iterator& operator-=(difference_type n) noexcept {
+            index_ -= n;
+            return *this;
+        }
+
+        circular_buffer_iterator operator+(difference_type n) const noexcept {
+            return circular_buffer_iterator(buffer_, index_ + n);
+        }
+
+        circular_buffer_iterator operator-(difference_type n) const noexcept {
+            return circular_buffer_iterator(buffer_, index_ - n);
+        }
+
+        friend circular_buffer_iterator operator+(difference_type n, const circular_buffer_iterator& it) noexcept {
+            return it + n;
+        }
+
+        friend difference_type operator-(const circular_buffer_iterator& lhs,
+                                         const circular_buffer_iterator& rhs) noexcept {
+            return difference_type(lhs.index_) - difference_type(rhs.index_);
+        }
+
+        friend bool operator==(const circular_buffer_iterator& lhs, const circular_buffer_iterator& rhs) noexcept {
+            return lhs.index_ == rhs.index_;
+        }
+
+        friend bool operator!=(const circular_buffer_iterator& lhs, const circular_buffer_iterator& rhs) noexcept {
+            return lhs.index_ != rhs.index_;
+        }
+
+        friend bool operator<(const circular_buffer_iterator& lhs, const circular_buffer_iterator& rhs) noexcept {
+            return lhs.index_ < rhs.index_;
+        }
+
+        friend bool operator>(const circular_buffer_iterator& lhs, const circular_buffer_iterator& rhs) noexcept {
+            return rhs.index_ < lhs.index_;
+        }
+
+        friend bool operator<=(const circular_buffer_iterator& lhs, const circular_buffer_iterator& rhs) noexcept {
+            return !(rhs.index_ < lhs.index_);
+        }
+
+        friend bool operator>=(const circular_buffer_iterator& lhs, const circular_buffer_iterator& rhs) noexcept {
+            return !(lhs.index_ < rhs.index_);
+        }
+
+    private:
+        Buffer* buffer_{nullptr};
+        size_type index_{0};
+    };
+
+    /*
+     *  [3 4 5 . . . 0 1 2]
+     *         |     |
+     *       tail   head
+     *
+     * -- 容量在构造时确定，整个生命周期只有一块内存，分配方式与 vector::create_storage 相同
+     *    （allocate_at_least，多出来的空间不计入容量，容量始终是请求的值）
+     * -- head 指向最旧的元素，新元素放在 head + size 处（超过容量时回绕到开头）
+     * -- 两端 push/pop 都是 O(1)，不移动任何元素
+     * -- array_one()/array_two() 按从旧到新的顺序给出两段连续内存，可直接用于 memcpy、writev
+     */
+    template<class T, class Allocator = allocator<T>, class OverflowPolicy = overwrite_oldest>
+    class circular_buffer {
+        static_assert(std::is_same<typename Allocator::value_type, T>::value,
+                      "circular_buffer must have the same value_type as its allocator");
+
+    public:
+        using value_type             = T;
+        using allocator_type         = Allocator;
+        using overflow_policy        = OverflowPolicy;
+        using pointer                = T*;
+        using const_pointer          = const T*;
+        using reference              = T&;
+        using const_reference        = const T&;
+        using iterator               = circular_buffer_iterator<circular_buffer, T&, T*>;
+        using const_iterator         = circular_buffer_iterator<const circular_buffer, const T&, const T*>;
+        using reverse_iterator       = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+        using size_type              = std::size_t;
+        using difference_type        = std::ptrdiff_t;
+
+        // 一段连续的元素：起始地址和元素个数
+        using array_range       = std::pair<pointer, size_type>;
+        using const_array_range = std::pair<const_pointer, size_type>;
+
+    private:
+        using alloc_traits = std::allocator_traits<Allocator>;
+
+        // 析构时按 storage_count_ 归还整块存储；环上的元素由 circular_buffer 析构
+        struct buffer_impl : public Allocator {
+            pointer start_{nullptr};
+            size_type storage_count_{0}; // allocate_at_least 实际给出的元素个数，归还时要用
+            size_type capacity_{0};
+            size_type head_{0};
+            size_type size_{0};
+
+            buffer_impl() = default;
+
+            explicit buffer_impl(const Allocator& alloc) noexcept : Allocator(alloc) {
+            }
+
+            explicit buffer_impl(Allocator&& alloc) noexcept : Allocator(std::move(alloc)) {
+            }
+
+            ~buffer_impl() {
+                if (start_) {
+                    alloc_traits::deallocate(*this, start_, storage_count_);
+                }
+            }
+        };
+
+        buffer_impl impl_;
+
+    public:
+        //===============================构造函数==============================
+        // 容量为 0，push_back 总是失败
+        circular_buffer() = default;
+
+        explicit circular_buffer(const Allocator& alloc) noexcept : impl_(alloc) {
+        }
+
+        explicit circular_buffer(size_type capacity, const Allocator& alloc = Allocator()) : impl_(alloc) {
+            create_storage(check_init_len(capacity));
+        }
+
+        // 容量为 capacity，依次 push_back [first,last) 的元素
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        circular_buffer(size_type capacity, InputIterator first, InputIterator last,
+                        const Allocator& alloc = Allocator())
+            : impl_(alloc) {
+            create_storage(check_init_len(capacity));
+            try {
+                append(first, last);
+            } catch (...) {
+                clear();
+                throw;
+            }
+        }
+
+        circular_buffer(size_type capacity, std::initializer_list<T> init, const Allocator& alloc = Allocator())
+            : impl_(alloc) {
+            create_storage(check_init_len(capacity));
+            try {
+                append(init.begin(), init.end());
+            } catch (...) {
+                clear();
+                throw;
+            }
+        }
+
+        // 拷贝后元素从存储的开头连续存放，容量不变
+        circular_buffer(const circular_buffer& other)
+            : impl_(alloc_traits::select_on_container_copy_construction(other.get_alloc())) {
+            create_storage(other.capacity());
+            copy_from(other);
+        }
+
+        circular_buffer(const circular_buffer& other, const Allocator& alloc) : impl_(alloc) {
+            create_storage(other.capacity());
+            copy_from(other);
+        }
+
+        circular_buffer(circular_buffer&& other) noexcept : impl_(std::move(other.get_alloc())) {
+            steal_storage(other);
+        }
+
+        circular_buffer(circular_buffer&& other, const Allocator& alloc) : impl_(alloc) {
+            if (alloc_traits::is_always_equal::value || get_alloc() == other.get_alloc()) {
+                steal_storage(other);
+            } else {
+                create_storage(other.capacity());
+                move_from(other);
+            }
+        }
+
+        //===============================析构函数==================================
+        ~circular_buffer() {
+            clear();
+        }
+
+        //============================ operator= ==================================
+        circular_buffer& operator=(const circular_buffer& other) {
+            if (std::addressof(other) != this) {
+                clear();
+                // 容量不同，或需要换成 other 的分配器时，旧内存先交给旧分配器释放
+                const bool reallocate = capacity() != other.capacity() ||
+                                        (alloc_traits::propagate_on_container_copy_assignment::value &&
+                                         !alloc_traits::is_always_equal::value &&
+                                         get_alloc() != other.get_alloc());
+                if (reallocate) {
+                    release_storage();
+                }
+                alloc_on_copy(get_alloc(), other.get_alloc());
+                if (reallocate) {
+                    create_storage(other.capacity());
+                }
+                copy_from(other);
+            }
+            return *this;
+        }
+
+        circular_buffer& operator=(circular_buffer&& other) noexcept(
+            alloc_traits::propagate_on_container_move_assignment::value ||
+            alloc_traits::is_always_equal::value) {
+            if (std::addressof(other) != this) {
+                move_assign(std::move(other), std::integral_constant<bool,
+                            alloc_traits::propagate_on_container_move_assignment::value ||
+                            alloc_traits::is_always_equal::value>());
+            }
+            return *this;
+        }
+
+        allocator_type get_allocator() const noexcept {
+            return allocator_type(get_alloc());
+        }
+
+        //================================ 元素访问 =================================
+        // 下标 0 是最旧的元素
+        reference at(size_type index) {
+            if (index >= size()) {
+                throw std::out_of_range("circular_buffer::at");
+            }
+            return (*this)[index];
+        }
+
+        const_reference at(size_type index) const {
+            if (index >= size()) {
+                throw std::out_of_range("circular_buffer::at");
+            }
+            return (*this)[index];
+        }
+
+        reference operator[](size_type index) {
+            return impl_.start_[wrap(impl_.head_ + index)];
+        }
+
+        const_reference operator[](size_type index) const {
+            return impl_.start_[wrap(impl_.head_ + index)];
+        }
+
+        reference front() {
+            return impl_.start_[impl_.head_];
+        }
+
+        const_reference front() const {
+            return impl_.start_[impl_.head_];
+        }
+
+        reference back() {
+            return (*this)[impl_.size_ - 1];
+        }
+
+        const_reference back() const {
+            return (*this)[impl_.size_ - 1];
+        }
+
+        // 从 head 开始的第一段连续元素
+        array_range array_one() noexcept {
+            return array_range(impl_.start_ + impl_.head_, first_span_size());
+        }
+
+        const_array_range array_one() const noexcept {
+            return const_array_range(impl_.start_ + impl_.head_, first_span_size());
+        }
+
+        // 回绕到存储开头的第二段，没有回绕时为空
+        array_range array_two() noexcept {
+            return array_range(impl_.start_, impl_.size_ - first_span_size());
+        }
+
+        const_array_range array_two() const noexcept {
+            return const_array_range(impl_.start_, impl_.size_ - first_span_size());
+        }
+
+        //================================ 迭代器 ==================================
+        iterator begin() noexcept {
+            return iterator(this, 0);
+        }
+
+        const_iterator begin() const noexcept {
+            return const_iterator(this, 0);
+        }
+
+        const_iterator cbegin() const noexcept {
+            return const_iterator(this, 0);
+        }
+
+        iterator end() noexcept {
+            return iterator(this, impl_.size_);
+        }
+
+        const_iterator end() const noexcept {
+            return const_iterator(this, impl_.size_);
+        }
+
+        const_iterator cend() const noexcept {
+            return const_iterator(this, impl_.size_);
+        }
+
+        reverse_iterator rbegin() noexcept {
+            return reverse_iterator(end());
+        }
+
+        const_reverse_iterator rbegin() const noexcept {
+            return const_reverse_iterator(end());
+        }
+
+        const_reverse_iterator crbegin() const noexcept {
+            return const_reverse_iterator(end());
+        }
+
+        reverse_iterator rend() noexcept {
+            return reverse_iterator(begin());
+        }
+
+        const_reverse_iterator rend() const noexcept {
+            return const_reverse_iterator(begin());
+        }
+
+        const_reverse_iterator crend() const noexcept {
+            return const_reverse_iterator(begin());
+        }
+
+        //================================ 容量 ====================================
+        [[nodiscard]] bool empty() const noexcept {
+            return impl_.size_ == 0;
+        }
+
+        bool full() const noexcept {
+            return impl_.size_ == impl_.capacity_;
+        }
+
+        size_type size() const noexcept {
+            return impl_.size_;
+        }
+
+        size_type capacity() const noexcept {
+            return impl_.capacity_;
+        }
+
+        // 还能放入多少个元素而不覆盖或拒绝
+        size_type available() const noexcept {
+            return impl_.capacity_ - impl_.size_;
+        }
+
+        size_type max_size() const noexcept {
+            size_type diffmax  = std::numeric_limits<difference_type>::max() / sizeof(T);
+            size_type allocmax = alloc_traits::max_size(get_alloc());
+            return std::min(diffmax, allocmax);
+        }
+
+        /*
+         * 改变容量，重新分配存储并把元素移到新存储的开头
+         * -- 新容量小于 size() 时只保留最新的 new_capacity 个元素
+         * -- 移动元素时抛出异常，缓冲区保持原来的容量，元素个数不变（可能处于被移动后的状态）
+         */
+        void set_capacity(size_type new_capacity) {
+            if (new_capacity == capacity()) {
+                return;
+            }
+            circular_buffer temp(check_init_len(new_capacity), get_alloc());
+            const size_type keep = std::min(size(), new_capacity);
+            for (size_type i = size() - keep; i < size(); ++i) {
+                temp.emplace_back(std::move_if_noexcept((*this)[i]));
+            }
+            clear();
+            release_storage();
+            steal_storage(temp);
+        }
+
+        //================================ 修改器 ==================================
+        void clear() noexcept {
+            const size_type first = first_span_size();
+            destroy_a(impl_.start_ + impl_.head_, impl_.start_ + impl_.head_ + first, get_alloc());
+            destroy_a(impl_.start_, impl_.start_ + (impl_.size_ - first), get_alloc());
+            impl_.head_ = 0;
+            impl_.size_ = 0;
+        }
+
+        bool push_back(const value_type& value) {
+            return emplace_back(value);
+        }
+
+        bool push_back(value_type&& value) {
+            return emplace_back(std::move(value));
+        }
+
+        /*
+         * 在尾部构造一个元素，返回是否放入了缓冲区
+         * -- 未满：直接在尾部构造
+         * -- 满且为 overwrite_oldest：先构造临时对象再移动赋值给最旧的元素，head 前移一格；
+         *    构造抛出异常时缓冲区不变
+         * -- 满且为 reject_when_full，或容量为 0：不构造，返回 false
+         */
+        template<class... Args>
+        bool emplace_back(Args&&... args) {
+            if (impl_.size_ != impl_.capacity_) {
+                alloc_traits::construct(get_alloc(), impl_.start_ + wrap(impl_.head_ + impl_.size_),
+                                        std::forward<Args>(args)...);
+                ++impl_.size_;
+                return true;
+            }
+            return overwrite_back(std::integral_constant<bool, OverflowPolicy::overwrite>(),
+                                  std::forward<Args>(args)...);
+        }
+
+        // 依次 push_back [first,last) 的元素，返回放入的个数
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        size_type append(InputIterator first, InputIterator last) {
+            size_type count = 0;
+            for (; first != last; ++first) {
+                if (!emplace_back(*first)) {
+                    break;
+                }
+                ++count;
+            }
+            return count;
+        }
+
+        void pop_front() {
+            alloc_traits::destroy(get_alloc(), impl_.start_ + impl_.head_);
+            impl_.head_ = wrap(impl_.head_ + 1);
+            --impl_.size_;
+        }
+
+        void pop_back() {
+            alloc_traits::destroy(get_alloc(), impl_.start_ + wrap(impl_.head_ + impl_.size_ - 1));
+            --impl_.size_;
+        }
+
+        // 删除最旧的 count 个元素
+        void pop_front(size_type count) {
+            count = std::min(count, impl_.size_);
+            const size_type first = std::min(count, first_span_size());
+            destroy_a(impl_.start_ + impl_.head_, impl_.start_ + impl_.head_ + first, get_alloc());
+            destroy_a(impl_.start_, impl_.start_ + (count - first), get_alloc());
+            impl_.head_ = impl_.size_ == count ? 0 : wrap(impl_.head_ + count);
+            impl_.size_ -= count;
+        }
+
+        //====================================== swap ============================================
+        // 分配器只在 propagate_on_container_swap 为真时交换
+        void swap(circular_buffer& other) noexcept {
+            using std::swap;
+            swap(impl_.start_, other.impl_.start_);
+            swap(impl_.storage_count_, other.impl_.storage_count_);
+            swap(impl_.capacity_, other.impl_.capacity_);
+            swap(impl_.head_, other.impl_.head_);
+            swap(impl_.size_, other.impl_.size_);
+            alloc_on_swap(get_alloc(), other.get_alloc());
+        }
+
+    private:
+        //==========================工具函数=======================
+        Allocator& get_alloc() noexcept {
+            return impl_;
+        }
+
+        const Allocator& get_alloc() const noexcept {
+            return impl_;
+        }
+
+        // index < 2 * capacity 时把 index 折回 [0, capacity)，用比较代替取模
+        size_type wrap(size_type index) const noexcept {
+            return index >= impl_.capacity_ ? index - impl_.capacity_ : index;
+        }
+
+        // 第一段连续元素的个数
+        size_type first_span_size() const noexcept {
+            return std::min(impl_.size_, impl_.capacity_ - impl_.head_);
+        }
+
+        size_type check_init_len(size_type count) const {
+            if (count > max_size()) {
+                throw std::length_error("circular_buffer capacity is greater than max_size()");
+            }
+            return count;
+        }
+
+        // 与 vector::create_storage 相同，但容量保持 count，不把多出来的空间算进去：
+        // 容量决定了什么时候开始覆盖，不能随分配器的取整变化
+        void create_storage(size_type count) {
+            if (count != 0) {
+                const auto storage    = Lsh::allocate_at_least(get_alloc(), count);
+                impl_.start_          = storage.ptr;
+                impl_.storage_count_  = storage.count;
+            }
+            impl_.capacity_ = count;
+            impl_.head_     = 0;
+            impl_.size_     = 0;
+        }
+
+        // 元素已全部析构时调用
+        void release_storage() noexcept {
+            if (impl_.start_) {
+                alloc_traits::deallocate(get_alloc(), impl_.start_, impl_.storage_count_);
+            }
+            impl_.start_         = nullptr;
+            impl_.storage_count_ = 0;
+            impl_.capacity_      = 0;
+        }
+
+        void steal_storage(circular_buffer& other) noexcept {
+            impl_.start_               = other.impl_.start_;
+            impl_.storage_count_       = other.impl_.storage_count_;
+            impl_.capacity_            = other.impl_.capacity_;
+            impl_.head_                = other.impl_.head_;
+            impl_.size_                = other.impl_.size_;
+            other.impl_.start_         = nullptr;
+            other.impl_.storage_count_ = 0;
+            other.impl_.capacity_      = 0;
+            other.impl_.head_          = 0;
+            other.impl_.size_          = 0;
+        }
+
+        // 空缓冲区、容量不小于 other 时，把 other 的两段依次复制到开头
+        void copy_from(const circular_buffer& other) {
+            const const_array_range one = other.array_one();
+            const const_array_range two = other.array_two();
+            uninitialized_copy_a(one.first, one.first + one.second, impl_.start_, get_alloc());
+            try {
+                uninitialized_copy_a(two.first, two.first + two.second, impl_.start_ + one.second, get_alloc());
+            } catch (...) {
+                destroy_a(impl_.start_, impl_.start_ + one.second, get_alloc());
+                throw;
+            }
+            impl_.size_ = other.size();
+        }
+
+        void move_from(circular_buffer& other) {
+            const array_range one = other.array_one();
+            const array_range two = other.array_two();
+            uninitialized_move_a(one.first, one.first + one.second, impl_.start_, get_alloc());
+            try {
+                uninitialized_move_a(two.first, two.first + two.second, impl_.start_ + one.second, get_alloc());
+            } catch (...) {
+                destroy_a(impl_.start_, impl_.start_ + one.second, get_alloc());
+                throw;
+            }
+            impl_.size_ = other.size();
+            other.clear();
+        }
+
+        void move_assign(circular_buffer&& other, std::true_type) noexcept {
+            clear();
+            release_storage();
+            alloc_on_move(get_alloc(), other.get_alloc());
+            steal_storage(other);
+        }
+
+        // 分配器不相等时只能逐个移动元素，容量跟随 other
+        void move_assign(circular_buffer&& other, std::false_type) {
+            if (get_alloc() == other.get_alloc()) {
+                move_assign(std::move(other), std::true_type());
+            } else {
+                clear();
+                if (capacity() != other.capacity()) {
+                    release_storage();
+                    create_storage(other.capacity());
+                }
+                move_from(other);
+            }
+        }
+
+        template<class... Args>
+        bool overwrite_back(std::true_type, Args&&... args) {
+            if (impl_.capacity_ == 0) {
+                return false;
+            }
+            // 满时尾部的下一个位置就是 head；参数可能引用最旧的元素（如 push_back(front())），
+            // 先构造出临时对象，再移动赋值给最旧的元素
+            value_type value(std::forward<Args>(args)...);
+            impl_.start_[impl_.head_] = std::move(value);
+            impl_.head_ = wrap(impl_.head_ + 1);
+            return true;
+        }
+
+        template<class... Args>
+        bool overwrite_back(std::false_type, Args&&...) noexcept {
+            return false;
+        }
+    };
+
+    //==================================== 非成员函数 ==========================
+    template<class T, class Allocator, class OverflowPolicy>
+    bool operator==(const circular_buffer<T, Allocator, OverflowPolicy>& lhs,
+                    const circular_buffer<T, Allocator, OverflowPolicy>& rhs) {
+        return (lhs.size() == rhs.size()) &&
+               std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+
+    template<class T, class Allocator, class OverflowPolicy>
+    bool operator!=(const circular_buffer<T, Allocator, OverflowPolicy>& lhs,
+                    const circular_buffer<T, Allocator, OverflowPolicy>& rhs) {
+        return !(lhs == rhs);
+    }
+
+    template<class T, class Allocator, class OverflowPolicy>
+    void swap(circular_buffer<T, Allocator, OverflowPolicy>& lhs,
+              circular_buffer<T, Allocator, OverflowPolicy>& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+}
+#endif //CIRCULAR_BUFFER_H
@@ -5,7 +5,11 @@
 #ifndef CONSTRUCT_H
 #define CONSTRUCT_H
 
+#include <cstddef>
+#include <cstring>
 #include <iterator>
+#include <memory>
+#include <type_traits>
 #include <utility>
 
 /*
@@ -18,58 +22,356 @@
  * 2. `destroy`: Functions for safely destroying objects.
  *    - Handles single objects and ranges of objects using iterators.
  *    - Optimized for trivial types (e.g., POD types), avoiding unnecessary destructor calls.
+ *
+ * 3. Allocator-aware range utilities (`uninitialized_*_a`, `destroy_a`).
+ *    - Construct and destroy ranges through `std::allocator_traits`, so that containers honour
+ *      allocators with their own `construct`/`destroy`.
+ *    - Fall back to the `std::uninitialized_*` algorithms when the allocator would only do
+ *      placement new anyway, which keeps their memmove fast paths for trivial types.
+ *
+ * 4. Relocation (`is_trivially_relocatable`, `relocate_a`).
+ *    - Moves a range into uninitialized storage and ends the lifetime of the source objects.
+ *    - For trivially relocatable types this is a single memcpy with no move or destroy calls.
+ */
+
+/*
+ * C++20 constant evaluation.
+ * - With transient constexpr allocation (P0784), `LSH_CONSTEXPR20` expands to `constexpr` and
+ *   Lsh::vector, Lsh::allocator and the helpers below can run at compile time; otherwise it
+ *   expands to nothing.
+ * - `Lsh::is_constant_evaluated()` lets the byte-wise fast paths (memcpy, memmove, the
+ *   std::uninitialized_* algorithms) fall back to element-wise code during constant evaluation.
  */
+#if defined(__cpp_constexpr_dynamic_alloc) && __cpp_constexpr_dynamic_alloc >= 201907L && \
+    defined(__cpp_lib_is_constant_evaluated) && __cpp_lib_is_constant_evaluated >= 201811L
+#define LSH_HAS_CONSTEXPR_ALLOCATION 1
+#define LSH_CONSTEXPR20 constexpr
+#else
+#define LSH_HAS_CONSTEXPR_ALLOCATION 0
+#define LSH_CONSTEXPR20
+#endif
 
 namespace Lsh {
+    constexpr bool is_constant_evaluated() noexcept {
+#if LSH_HAS_CONSTEXPR_ALLOCATION
+        return std::is_constant_evaluated();
+#else
+        return false;
+#endif
+    }
+
     // Construct utilities:
     // - Supports default, copy, and custom argument-based construction.
+    // - Placement new is not allowed in constant evaluation; std::construct_at is.
     template<typename T>
-    void construct(T* p) {
+    LSH_CONSTEXPR20 void construct(T* p) {
+#if LSH_HAS_CONSTEXPR_ALLOCATION
+        std::construct_at(p);
+#else
         ::new((void*)p) T();
+#endif
     }
 
     template<typename T, typename U>
-    void construct(T* p, const U& value) {
+    LSH_CONSTEXPR20 void construct(T* p, const U& value) {
+#if LSH_HAS_CONSTEXPR_ALLOCATION
+        std::construct_at(p, value);
+#else
         ::new((void*)p) T(value);
+#endif
     }
 
     template<typename T, typename... Args>
-    void construct(T* p, Args&&... args) {
+    LSH_CONSTEXPR20 void construct(T* p, Args&&... args) {
+#if LSH_HAS_CONSTEXPR_ALLOCATION
+        std::construct_at(p, std::forward<Args>(args)...);
+#else
         ::new((void*)p) T(std::forward<Args>(args)...);
+#endif
     }
 
     // Destroy utilities:
     // - Handles single objects and iterator ranges.
     // - Leverages type traits to optimize destruction of trivially destructible types.
     template<typename T>
-    void destroy_1(T* p, std::true_type) {
+    LSH_CONSTEXPR20 void destroy_1(T* p, std::true_type) {
     }
 
     template<typename T>
-    void destroy_1(T* p, std::false_type) {
+    LSH_CONSTEXPR20 void destroy_1(T* p, std::false_type) {
         p->~T();
     }
 
+    template<typename T>
+    LSH_CONSTEXPR20 void destroy(T* p) {
+        destroy_1(p, std::is_trivially_destructible<T>());
+    }
+
     template<typename ForwardIter>
-    void destroy_2(ForwardIter, ForwardIter, std::true_type) {
+    LSH_CONSTEXPR20 void destroy_2(ForwardIter, ForwardIter, std::true_type) {
     }
 
     template<typename ForwardIter>
-    void destroy_2(ForwardIter first, ForwardIter last, std::false_type) {
+    LSH_CONSTEXPR20 void destroy_2(ForwardIter first, ForwardIter last, std::false_type) {
         for (; first != last; ++first) {
             destroy(&*first);
         }
     }
 
-    template<typename T>
-    void destroy(T* p) {
-        destroy_1(p, std::is_trivially_destructible<T>());
-    }
-
     template<typename ForwardIter>
-    void destroy(ForwardIter first, ForwardIter last) {
+    LSH_CONSTEXPR20 void destroy(ForwardIter first, ForwardIter last) {
         destroy_2(first, last, std::is_trivially_destructible<
                       typename std::iterator_traits<ForwardIter>::value_type>());
     }
+
+    // Allocator-aware utilities:
+    // - `uses_default_construct<Alloc>` is true when Alloc's construct/destroy are plain
+    //   placement new and destructor calls, either because Alloc does not declare them
+    //   (allocator_traits falls back) or because Alloc is known to forward to them.
+    // - Other allocators get an element-by-element loop that rolls back on exceptions.
+    template<typename Alloc, typename = void>
+    struct has_member_construct : std::false_type {
+    };
+
+    template<typename Alloc>
+    struct has_member_construct<Alloc, std::void_t<decltype(std::declval<Alloc&>().construct(
+                                           std::declval<typename Alloc::value_type*>()))>>
+        : std::true_type {
+    };
+
+    template<typename Alloc, typename = void>
+    struct has_member_destroy : std::false_type {
+    };
+
+    template<typename Alloc>
+    struct has_member_destroy<Alloc, std::void_t<decltype(std::declval<Alloc&>().destroy(
+                                         std::declval<typename Alloc::value_type*>()))>>
+        : std::true_type {
+    };
+
+    template<typename Alloc>
+    struct uses_default_construct
+        : std::integral_constant<bool, !has_member_construct<Alloc>::value &&
+                                       !has_member_destroy<Alloc>::value> {
+    };
+
+    template<typename T>
+    struct uses_default_construct<std::allocator<T>> : std::true_type {
+    };
+
+    template<typename ForwardIter, typename Alloc>
+    LSH_CONSTEXPR20 void destroy_a_aux(ForwardIter first, ForwardIter last, Alloc&, std::true_type) {
+        Lsh::destroy(first, last);
+    }
+
+    template<typename ForwardIter, typename Alloc>
+    LSH_CONSTEXPR20 void destroy_a_aux(ForwardIter first, ForwardIter last, Alloc& alloc, std::false_type) {
+        for (; first != last; ++first) {
+            std::allocator_traits<Alloc>::destroy(alloc, std::addressof(*first));
+        }
+    }
+
+    template<typename ForwardIter, typename Alloc>
+    LSH_CONSTEXPR20 void destroy_a(ForwardIter first, ForwardIter last, Alloc& alloc) {
+        destroy_a_aux(first, last, alloc, uses_default_construct<Alloc>());
+    }
+
+    template<typename InputIter, typename ForwardIter, typename Alloc>
+    ForwardIter uninitialized_copy_a_aux(InputIter first, InputIter last, ForwardIter result,
+                                         Alloc&, std::true_type) {
+        return std::uninitialized_copy(first, last, result);
+    }
+
+    template<typename InputIter, typename ForwardIter, typename Alloc>
+    LSH_CONSTEXPR20 ForwardIter uninitialized_copy_a_aux(InputIter first, InputIter last, ForwardIter result,
+                                                         Alloc& alloc, std::false_type) {
+        ForwardIter cur = result;
+        try {
+            for (; first != last; ++first, (void) ++cur) {
+                std::allocator_traits<Alloc>::construct(alloc, std::addressof(*cur), *first);
+            }
+            return cur;
+        } catch (...) {
+            destroy_a(result, cur, alloc);
+            throw;
+        }
+    }
+
+    template<typename InputIter, typename ForwardIter, typename Alloc>
+    LSH_CONSTEXPR20 ForwardIter uninitialized_copy_a(InputIter first, InputIter last, ForwardIter result,
+                                                     Alloc& alloc) {
+        if (Lsh::is_constant_evaluated()) {
+            return uninitialized_copy_a_aux(first, last, result, alloc, std::false_type());
+        }
+        return uninitialized_copy_a_aux(first, last, result, alloc, uses_default_construct<Alloc>());
+    }
+
+    template<typename InputIter, typename ForwardIter, typename Alloc>
+    LSH_CONSTEXPR20 ForwardIter uninitialized_move_a(InputIter first, InputIter last, ForwardIter result,
+                                                     Alloc& alloc) {
+        return uninitialized_copy_a(std::make_move_iterator(first), std::make_move_iterator(last),
+                                    result, alloc);
+    }
+
+    template<typename ForwardIter, typename Size, typename T, typename Alloc>
+    ForwardIter uninitialized_fill_n_a_aux(ForwardIter first, Size n, const T& value,
+                                           Alloc&, std::true_type) {
+        return std::uninitialized_fill_n(first, n, value);
+    }
+
+    template<typename ForwardIter, typename Size, typename T, typename Alloc>
+    LSH_CONSTEXPR20 ForwardIter uninitialized_fill_n_a_aux(ForwardIter first, Size n, const T& value,
+                                                           Alloc& alloc, std::false_type) {
+        ForwardIter cur = first;
+        try {
+            for (; n > 0; --n, (void) ++cur) {
+                std::allocator_traits<Alloc>::construct(alloc, std::addressof(*cur), value);
+            }
+            return cur;
+        } catch (...) {
+            destroy_a(first, cur, alloc);
+            throw;
+        }
+    }
+
+    template<typename ForwardIter, typename Size, typename T, typename Alloc>
+    LSH_CONSTEXPR20 ForwardIter uninitialized_fill_n_a(ForwardIter first, Size n, const T& value, Alloc& alloc) {
+        if (Lsh::is_constant_evaluated()) {
+            return uninitialized_fill_n_a_aux(first, n, value, alloc, std::false_type());
+        }
+        return uninitialized_fill_n_a_aux(first, n, value, alloc, uses_default_construct<Alloc>());
+    }
+
+    // Value-initializes n elements, i.e. construct(p) for each position.
+    template<typename ForwardIter, typename Size, typename Alloc>
+    ForwardIter uninitialized_value_n_a_aux(ForwardIter first, Size n, Alloc&, std::true_type) {
+        return std::uninitialized_value_construct_n(first, n);
+    }
+
+    template<typename ForwardIter, typename Size, typename Alloc>
+    LSH_CONSTEXPR20 ForwardIter uninitialized_value_n_a_aux(ForwardIter first, Size n, Alloc& alloc, std::false_type) {
+        ForwardIter cur = first;
+        try {
+            for (; n > 0; --n, (void) ++cur) {
+                std::allocator_traits<Alloc>::construct(alloc, std::addressof(*cur));
+            }
+            return cur;
+        } catch (...) {
+            destroy_a(first, cur, alloc);
+            throw;
+        }
+    }
+
+    template<typename ForwardIter, typename Size, typename Alloc>
+    LSH_CONSTEXPR20 ForwardIter uninitialized_value_n_a(ForwardIter first, Size n, Alloc& alloc) {
+        if (Lsh::is_constant_evaluated()) {
+            return uninitialized_value_n_a_aux(first, n, alloc, std::false_type());
+        }
+        return uninitialized_value_n_a_aux(first, n, alloc, uses_default_construct<Alloc>());
+    }
+
+    // Tag selecting default-initialization (`new (p) T`) instead of value-initialization
+    // (`new (p) T()`): class types still run their default constructor, trivial types are
+    // left unzeroed for the caller to overwrite.
+    struct default_init_t {
+        explicit default_init_t() = default;
+    };
+
+    inline constexpr default_init_t default_init{};
+
+    // Default-initializes n elements. allocator_traits has no default-initializing construct,
+    // so allocators with their own construct() still get value-initialization, and so does
+    // constant evaluation.
+    template<typename ForwardIter, typename Size, typename Alloc>
+    ForwardIter uninitialized_default_n_a_aux(ForwardIter first, Size n, Alloc&, std::true_type) {
+        return std::uninitialized_default_construct_n(first, n);
+    }
+
+    template<typename ForwardIter, typename Size, typename Alloc>
+    LSH_CONSTEXPR20 ForwardIter uninitialized_default_n_a_aux(ForwardIter first, Size n, Alloc& alloc,
+                                                              std::false_type) {
+        return uninitialized_value_n_a_aux(first, n, alloc, std::false_type());
+    }
+
+    template<typename ForwardIter, typename Size, typename Alloc>
+    LSH_CONSTEXPR20 ForwardIter uninitialized_default_n_a(ForwardIter first, Size n, Alloc& alloc) {
+        if (Lsh::is_constant_evaluated()) {
+            return uninitialized_default_n_a_aux(first, n, alloc, std::false_type());
+        }
+        return uninitialized_default_n_a_aux(first, n, alloc, uses_default_construct<Alloc>());
+    }
+
+    // Relocation utilities:
+    // - `is_trivially_relocatable<T>` is true when moving a T to new storage and destroying the
+    //   original is equivalent to copying its bytes. It defaults to trivially copyable types.
+    // - Specialize it for your own types that own resources but never store their own address
+    //   (handles, owning pointers, most PODs holding heap memory).
+    template<typename T>
+    struct is_trivially_relocatable : std::is_trivially_copyable<T> {
+    };
+
+    template<typename T, typename D>
+    struct is_trivially_relocatable<std::unique_ptr<T, D>> : is_trivially_relocatable<D> {
+    };
+
+    template<typename T>
+    struct is_trivially_relocatable<const T> : is_trivially_relocatable<T> {
+    };
+
+    // std::pair has user-provided assignment and is never trivially copyable, but moving its
+    // bytes is fine whenever both members can be moved that way.
+    template<typename T1, typename T2>
+    struct is_trivially_relocatable<std::pair<T1, T2>>
+        : std::integral_constant<bool, is_trivially_relocatable<T1>::value &&
+                                       is_trivially_relocatable<T2>::value> {
+    };
+
+    // Whether a value-initialized T is all zero bytes, so that memory known to be zero
+    // (fresh calloc or mmap pages) already holds value-initialized objects. True for
+    // arithmetic, enumeration and object pointer types and arrays of them; specialize it for
+    // trivial aggregates whose members all qualify.
+    template<typename T>
+    struct is_zero_initializable
+        : std::integral_constant<bool, std::is_arithmetic<T>::value || std::is_enum<T>::value ||
+                                       std::is_pointer<T>::value || std::is_null_pointer<T>::value> {
+    };
+
+    template<typename T, std::size_t N>
+    struct is_zero_initializable<T[N]> : is_zero_initializable<T> {
+    };
+
+    // Relocation may only use memcpy when the allocator would not observe the
+    // individual construct/destroy calls.
+    template<typename T, typename Alloc>
+    struct use_memcpy_relocate
+        : std::integral_constant<bool, is_trivially_relocatable<T>::value &&
+                                       uses_default_construct<Alloc>::value> {
+    };
+
+    template<typename T, typename Alloc>
+    T* relocate_a_aux(T* first, T* last, T* result, Alloc&, std::true_type) {
+        const std::ptrdiff_t count = last - first;
+        if (count > 0) {
+            std::memcpy(static_cast<void*>(result), static_cast<const void*>(first), count * sizeof(T));
+        }
+        return result + count;
+    }
+
+    template<typename T, typename Alloc>
+    LSH_CONSTEXPR20 T* relocate_a_aux(T* first, T* last, T* result, Alloc& alloc, std::false_type) {
+        T* cur = uninitialized_move_a(first, last, result, alloc);
+        destroy_a(first, last, alloc);
+        return cur;
+    }
+
+    // Relocates [first,last) into the uninitialized storage at result and returns the end of
+    // the new range. The source range is left as raw storage.
+    template<typename T, typename Alloc>
+    LSH_CONSTEXPR20 T* relocate_a(T* first, T* last, T* result, Alloc& alloc) {
+        if (Lsh::is_constant_evaluated()) {
+            return relocate_a_aux(first, last, result, alloc, std::false_type());
+        }
+        return relocate_a_aux(first, last, result, alloc, use_memcpy_relocate<T, Alloc>());
+    }
 }
 #endif //CONSTRUCT_H
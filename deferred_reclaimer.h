@@ -0,0 +1,249 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef DEFERRED_RECLAIMER_H
+#define DEFERRED_RECLAIMER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include "construct.h"
+
+namespace Lsh {
+    // Tag selecting a deferred_reclaimer that owns a background thread.
+    struct background_t {
+        explicit background_t() = default;
+    };
+
+    inline constexpr background_t background{};
+
+    /**
+    * @brief Takes over container storage and destroys and frees it later, off the hot path.
+    *
+    * Containers hand over their buffer with release_to(reclaimer), which only moves three
+    * pointers and an allocator copy. The elements are then destroyed in batches and the
+    * block is returned to its allocator by one of:
+    * - a background thread, when constructed with Lsh::background;
+    * - reclaim_some(budget), called at idle points, which does at most about `budget`
+    *   units of work (one per element destroyed, one per block freed);
+    * - reclaim_all() or the destructor, which finish everything still queued.
+    *
+    * The allocator copy is used from whichever thread reclaims, so it must tolerate that,
+    * and any arena or resource behind it must outlive the reclaimer's work.
+    */
+    class deferred_reclaimer {
+    public:
+        static constexpr std::size_t default_batch_size = 4096;
+
+        // Manual mode: nothing is reclaimed until reclaim_some / reclaim_all.
+        deferred_reclaimer() noexcept = default;
+
+        // Background mode: a worker thread reclaims batch_size units at a time.
+        explicit deferred_reclaimer(background_t, std::size_t batch_size = default_batch_size)
+            : batch_size_(batch_size ? batch_size : 1) {
+            worker_ = std::thread([this] { run(); });
+        }
+
+        deferred_reclaimer(const deferred_reclaimer&) = delete;
+
+        deferred_reclaimer& operator=(const deferred_reclaimer&) = delete;
+
+        ~deferred_reclaimer() {
+            if (worker_.joinable()) {
+                {
+                    std::lock_guard<std::mutex> guard(lock_);
+                    stopping_ = true;
+                }
+                work_.notify_one();
+                worker_.join();
+            }
+            reclaim_all();
+        }
+
+        /**
+        * @brief Takes ownership of [first, last) in a block of `capacity` objects from alloc.
+        *
+        * If this throws (the bookkeeping node could not be allocated), ownership stays with
+        * the caller.
+        */
+        template<class Alloc, class T>
+        void adopt(const Alloc& alloc, T* first, T* last, std::size_t capacity) {
+            if (!first) {
+                return;
+            }
+            push(new block_task<Alloc, T>(alloc, first, last, capacity));
+        }
+
+        // Reclaims up to about `budget` units on the calling thread; returns the units done.
+        std::size_t reclaim_some(std::size_t budget);
+
+        // Reclaims everything queued, then waits for work the worker thread has in hand.
+        void reclaim_all();
+
+        // Number of blocks not yet freed.
+        std::size_t pending() const {
+            std::lock_guard<std::mutex> guard(lock_);
+            return pending_;
+        }
+
+    private:
+        struct task {
+            task* next = nullptr;
+
+            virtual ~task() = default;
+
+            // Does at most `budget` units of work and returns how many were done.
+            virtual std::size_t reclaim(std::size_t budget) = 0;
+
+            virtual bool finished() const noexcept = 0;
+        };
+
+        template<class Alloc, class T>
+        struct block_task final : task {
+            using alloc_traits = typename std::allocator_traits<Alloc>::template rebind_traits<T>;
+            using alloc_type   = typename alloc_traits::allocator_type;
+
+            alloc_type alloc;
+            T* start;
+            T* cur; // next element to destroy
+            T* last;
+            std::size_t capacity;
+
+            block_task(const Alloc& a, T* first, T* finish, std::size_t n)
+                : alloc(a), start(first), cur(first), last(finish), capacity(n) {
+            }
+
+            std::size_t reclaim(std::size_t budget) override {
+                std::size_t done = 0;
+                if (!std::is_trivially_destructible<T>::value || !uses_default_construct<alloc_type>::value) {
+                    const std::size_t count = std::size_t(last - cur) < budget ? std::size_t(last - cur) : budget;
+                    destroy_a(cur, cur + count, alloc);
+                    cur += count;
+                    done = count;
+                } else {
+                    cur = last;
+                }
+                if (cur == last && done < budget) {
+                    alloc_traits::deallocate(alloc, start, capacity);
+                    start = nullptr;
+                    ++done;
+                }
+                return done;
+            }
+
+            bool finished() const noexcept override {
+                return !start;
+            }
+        };
+
+        void push(task* t) {
+            {
+                std::lock_guard<std::mutex> guard(lock_);
+                if (tail_) {
+                    tail_->next = t;
+                } else {
+                    head_ = t;
+                }
+                tail_ = t;
+                ++pending_;
+            }
+            work_.notify_one();
+        }
+
+        // Pops the oldest task and marks it in hand; null when the queue is empty.
+        task* take() {
+            std::lock_guard<std::mutex> guard(lock_);
+            task* t = head_;
+            if (t) {
+                head_ = t->next;
+                if (!head_) {
+                    tail_ = nullptr;
+                }
+                t->next = nullptr;
+                ++in_hand_;
+            }
+            return t;
+        }
+
+        // Returns an unfinished task to the front, or drops a finished one.
+        void give_back(task* t) {
+            const bool finished = t->finished();
+            if (finished) {
+                delete t;
+            }
+            std::lock_guard<std::mutex> guard(lock_);
+            --in_hand_;
+            if (finished) {
+                --pending_;
+            } else {
+                t->next = head_;
+                head_   = t;
+                if (!tail_) {
+                    tail_ = t;
+                }
+            }
+            if (!in_hand_) {
+                idle_.notify_all();
+            }
+        }
+
+        void run();
+
+        mutable std::mutex lock_;
+        std::condition_variable work_;
+        std::condition_variable idle_;
+        task* head_ = nullptr;
+        task* tail_ = nullptr;
+        std::size_t pending_ = 0;
+        std::size_t in_hand_ = 0;
+        bool stopping_ = false;
+        std::size_t batch_size_ = default_batch_size;
+        std::thread worker_;
+    };
+
+    inline std::size_t deferred_reclaimer::reclaim_some(std::size_t budget) {
+        std::size_t done = 0;
+        while (done < budget) {
+            task* t = take();
+            if (!t) {
+                break;
+            }
+            done += t->reclaim(budget - done);
+            give_back(t);
+        }
+        return done;
+    }
+
+    inline void deferred_reclaimer::reclaim_all() {
+        for (;;) {
+            while (reclaim_some(batch_size_)) {
+            }
+            // The worker may hand back an unfinished task after our queue looked empty.
+            std::unique_lock<std::mutex> guard(lock_);
+            idle_.wait(guard, [this] { return !in_hand_; });
+            if (!head_) {
+                return;
+            }
+        }
+    }
+
+    // Takes one batch at a time so reclaim_some callers and new adopters are never blocked
+    // for long; stops once asked to, leaving the rest to the destructor.
+    inline void deferred_reclaimer::run() {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> guard(lock_);
+                work_.wait(guard, [this] { return stopping_ || head_; });
+                if (stopping_) {
+                    return;
+                }
+            }
+            reclaim_some(batch_size_);
+        }
+    }
+}
+#endif //DEFERRED_RECLAIMER_H
@@ -0,0 +1,1105 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "allocator.h"
+#include "construct.h"
+
+namespace Lsh {
+    // 每个块的元素个数：块大小约 4 KiB，元素很大时至少放 16 个
+    template<class T>
+    constexpr std::size_t deque_block_size() noexcept {
+        return sizeof(T) < 256 ? 4096 / sizeof(T) : 16;
+    }
+
+    /*
+     * deque 的迭代器
+     * -- cur_ 指向当前元素，[first_, last_) 是当前块，node_ 指向中控器(map)中当前块的指针
+     * -- 跨块时只需要 node_ 前后移动一格，整体上仍是随机访问迭代器
+     */
+    template<class T, class Ref, class Ptr>
+    struct deque_iterator {
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = Ptr;
+        using reference         = Ref;
+        using map_pointer       = T**;
+
+        using iterator       = deque_iterator<T, T&, T*>;
+        using const_iterator = deque_iterator<T, const T&, const T*>;
+
+        T* cur_{nullptr};
+        T* first_{nullptr};
+        T* last_{nullptr};
+        map_pointer node_{nullptr};
+
+        static constexpr difference_type block_size() noexcept {
+            return static_cast<difference_type>(deque_block_size<T>());
+        }
+
+        deque_iterator() noexcept = default;
+
+        deque_iterator(T* cur, map_pointer node) noexcept
+            : cur_(cur), first_(*node), last_(*node + block_size()), node_(node) {
+        }
+
+        // iterator 可以隐式转换为 const_iterator
+        template<class It, typename = typename std::enable_if<
+                               std::is_same<It, iterator>::value &&
+                               !std::is_same<deque_iterator, iterator>::value>::type>
+        deque_iterator(const It& other) noexcept
+            : cur_(other.cur_), first_(other.first_), last_(other.last_), node_(other.node_) {
+        }
+
+        // 切换到 new_node 指向的块，cur_ 由调用者设置
+        void set_node(map_pointer new_node) noexcept {
+            node_  = new_node;
+            first_ = *new_node;
+            last_  = first_ + block_size();
+        }
+
+        reference operator*() const noexcept {
+            return *cur_;
+        }
+
+        pointer operator->() const noexcept {
+            return cur_;
+        }
+
+        reference operator[](difference_type n) const noexcept {
+            return *(*this + n);
+        }
+
+        deque_iterator& operator++() noexcept {
+            ++cur_;
+            if (cur_ == last_) {
+                set_node(node_ + 1);
+                cur_ = first_;
+            }
+            return *this;
+        }
+
+        deque_iterator operator++(int) noexcept {
+            deque_iterator temp = *this;
+            ++*this;
+            return temp;
+        }
+
+        deque_iterator& operator--() noexcept {
+            if (cur_ == first_) {
+                set_node(node_ - 1);
+                cur_ = last_;
+            }
+            --cur_;
+            return *this;
+        }
+
+        deque_iterator operator--(int) noexcept {
+            deque_iterator temp = *this;
+            --*this;
+            return temp;
+        }
+
+        deque_iterator& operator+=(difference_type n) noexcept {
+            const difference_type offset = n + (cur_ - first_);
+            if (offset >= 0 && offset < block_size()) {
+                // 仍在当前块内
+                cur_ += n;
+            } else {
+                const difference_type node_offset = offset > 0 ? offset / block_size()
+                                                               : -((-offset - 1) / block_size()) - 1;
+                set_node(node_ + node_offset);
+                cur_ = first_ + (offset - node_offset * block_size());
+            }
+            return *this;
+        }
+
+        deque_iterator& operator-=(difference_type n) noexcept {
+            return *this += -n;
+        }
+
+        deque_iterator operator+(difference_type n) const noexcept {
+            deque_iterator temp = *this;
+            return temp += n;
+        }
+
+        deque_iterator operator-(difference_type n) const noexcept {
+            deque_iterator temp = *this;
+            return temp -= n;
+        }
+
+        friend deque_iterator operator+(difference_type n, const deque_iterator& it) noexcept {
+            return it + n;
+        }
+
+        // 两个空迭代器（空 deque 的 begin/end）相减也得到 0
+        friend difference_type operator-(const deque_iterator& lhs, const deque_iterator& rhs) noexcept {
+            return block_size() * (lhs.node_ - rhs.node_) + (lhs.cur_ - lhs.first_) - (rhs.cur_ - rhs.first_);
+        }
+
+        friend bool operator==(const deque_iterator& lhs, const deque_iterator& rhs) noexcept {
+            return lhs.cur_ == rhs.cur_;
+        }
+
+        friend bool operator!=(const deque_iterator& lhs, const deque_iterator& rhs) noexcept {
+            return lhs.cur_ != rhs.cur_;
+        }
+
+        friend bool operator<(const deque_iterator& lhs, const deque_iterator& rhs) noexcept {
+            return lhs.node_ == rhs.node_ ? lhs.cur_ < rhs.cur_ : lhs.node_ < rhs.node_;
+        }
+
+        friend bool operator>(const deque_iterator& lhs, const deque_iterator& rhs) noexcept {
+            return rhs < lhs;
+        }
+
+        friend bool operator<=(const deque_iterator& lhs, const deque_iterator& rhs) noexcept {
+            return !(rhs < lhs);
+        }
+
+        friend bool operator>=(const deque_iterator& lhs, const deque_iterator& rhs) noexcept {
+            return !(lhs < rhs);
+        }
+    };
+
+    /*
+     *   map_ : [ - | - | * | * | * | - | - ]
+     *                   |   |   |
+     *                   v   v   v
+     *         block: [ . . 1 1 ] [ 1 1 1 1 ] [ 1 1 . . ]
+     *                      |                       |
+     *                    start                   finish
+     *
+     * -- 元素存放在固定大小的块中，中控器 map_ 是块指针数组，两端都留有空位
+     * -- 两端插入/删除只在首尾块内移动指针，块用完时分配一个新块，均摊 O(1)
+     * -- map_ 两端空位用完时只搬迁块指针（空位足够时居中，否则分配更大的 map_），
+     *    元素本身从不搬迁：两端插入不会使元素的引用和指针失效
+     * -- finish 所在的块总是已分配，finish.cur_ 总在块内，end() 不需要特殊处理
+     * -- 默认构造不分配内存，第一次插入时才创建 map_
+     */
+    template<class T, class Allocator = allocator<T>>
+    class deque {
+        static_assert(std::is_same<typename Allocator::value_type, T>::value,
+                      "deque must have the same value_type as its allocator");
+
+    public:
+        using value_type             = T;
+        using allocator_type         = Allocator;
+        using pointer                = T*;
+        using const_pointer          = const T*;
+        using reference              = T&;
+        using const_reference        = const T&;
+        using iterator               = deque_iterator<T, T&, T*>;
+        using const_iterator         = deque_iterator<T, const T&, const T*>;
+        using reverse_iterator       = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+        using size_type              = std::size_t;
+        using difference_type        = std::ptrdiff_t;
+
+    private:
+        using alloc_traits     = std::allocator_traits<Allocator>;
+        using map_pointer      = pointer*;
+        using map_alloc_type   = typename alloc_traits::template rebind_alloc<pointer>;
+        using map_alloc_traits = std::allocator_traits<map_alloc_type>;
+
+        static constexpr size_type block_size = deque_block_size<T>();
+
+        // map_ 的最小长度
+        static constexpr size_type initial_map_size = 8;
+
+        /*
+         * -- 与 vector_impl 一样继承自 Allocator，无状态分配器不占空间
+         * -- deque_impl 析构时归还所有块和 map_（不析构元素）
+         * -- spare_ 缓存一个空闲块：队列在块边界来回时不会反复分配、释放同一个块
+         */
+        struct deque_impl : public Allocator {
+            map_pointer map_{nullptr};
+            size_type map_size_{0};
+            iterator start_;
+            iterator finish_;
+            pointer spare_{nullptr};
+
+            deque_impl() = default;
+
+            explicit deque_impl(const Allocator& alloc) noexcept : Allocator(alloc) {
+            }
+
+            explicit deque_impl(Allocator&& alloc) noexcept : Allocator(std::move(alloc)) {
+            }
+
+            ~deque_impl() {
+                release();
+            }
+
+            void release() noexcept {
+                if (map_) {
+                    for (map_pointer node = start_.node_; node <= finish_.node_; ++node) {
+                        alloc_traits::deallocate(*this, *node, block_size);
+                    }
+                    map_alloc_type map_alloc(*this);
+                    map_alloc_traits::deallocate(map_alloc, map_, map_size_);
+                }
+                if (spare_) {
+                    alloc_traits::deallocate(*this, spare_, block_size);
+                }
+                map_      = nullptr;
+                map_size_ = 0;
+                start_    = iterator();
+                finish_   = iterator();
+                spare_    = nullptr;
+            }
+
+            void steal(deque_impl& other) noexcept {
+                map_            = other.map_;
+                map_size_       = other.map_size_;
+                start_          = other.start_;
+                finish_         = other.finish_;
+                spare_          = other.spare_;
+                other.map_      = nullptr;
+                other.map_size_ = 0;
+                other.start_    = iterator();
+                other.finish_   = iterator();
+                other.spare_    = nullptr;
+            }
+        };
+
+        deque_impl impl_;
+
+    public:
+        //===============================构造函数==============================
+        deque() = default;
+
+        explicit deque(const Allocator& alloc) noexcept : impl_(alloc) {
+        }
+
+        // 构造拥有 count 个默认插入的 T 对象的 deque
+        explicit deque(size_type count, const Allocator& alloc = Allocator()) : impl_(alloc) {
+            initialize_map(check_init_len(count));
+            uninitialized_value_n_a(impl_.start_, count, get_alloc());
+        }
+
+        deque(size_type count, const_reference value, const Allocator& alloc = Allocator()) : impl_(alloc) {
+            initialize_map(check_init_len(count));
+            uninitialized_fill_n_a(impl_.start_, count, value, get_alloc());
+        }
+
+        // 迭代器类型检查的原因见 vector 的同名构造函数
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        deque(InputIterator first, InputIterator last, const Allocator& alloc = Allocator()) : impl_(alloc) {
+            range_initialize(first, last, std::__iterator_category(first));
+        }
+
+        deque(const deque& other)
+            : impl_(alloc_traits::select_on_container_copy_construction(other.get_alloc())) {
+            range_initialize(other.begin(), other.end(), std::random_access_iterator_tag());
+        }
+
+        deque(const deque& other, const Allocator& alloc) : impl_(alloc) {
+            range_initialize(other.begin(), other.end(), std::random_access_iterator_tag());
+        }
+
+        // 只接管 map_ 和块，源对象变为不占内存的空 deque
+        deque(deque&& other) noexcept : impl_(std::move(other.get_alloc())) {
+            impl_.steal(other.impl_);
+        }
+
+        deque(deque&& other, const Allocator& alloc) : impl_(alloc) {
+            if (alloc_traits::is_always_equal::value || get_alloc() == other.get_alloc()) {
+                impl_.steal(other.impl_);
+            } else {
+                range_initialize(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()),
+                                 std::random_access_iterator_tag());
+                other.clear();
+            }
+        }
+
+        deque(std::initializer_list<T> init, const Allocator& alloc = Allocator()) : impl_(alloc) {
+            range_initialize(init.begin(), init.end(), std::random_access_iterator_tag());
+        }
+
+        //===============================析构函数==================================
+        ~deque() {
+            // 析构元素，内存由 deque_impl 的析构函数释放
+            destroy_a(impl_.start_, impl_.finish_, get_alloc());
+        }
+
+        //============================ operator= ==================================
+        deque& operator=(const deque& other) {
+            if (std::addressof(other) != this) {
+                // 分配器需要传播且两者不相等时，旧内存必须先交给旧分配器释放
+                if (alloc_traits::propagate_on_container_copy_assignment::value) {
+                    if (!alloc_traits::is_always_equal::value && get_alloc() != other.get_alloc()) {
+                        clear();
+                        impl_.release();
+                    }
+                    alloc_on_copy(get_alloc(), other.get_alloc());
+                }
+                range_assign(other.begin(), other.end());
+            }
+            return *this;
+        }
+
+        deque& operator=(deque&& other) noexcept(
+            alloc_traits::propagate_on_container_move_assignment::value ||
+            alloc_traits::is_always_equal::value) {
+            if (std::addressof(other) != this) {
+                move_assign(std::move(other), std::integral_constant<bool,
+                            alloc_traits::propagate_on_container_move_assignment::value ||
+                            alloc_traits::is_always_equal::value>());
+            }
+            return *this;
+        }
+
+        deque& operator=(std::initializer_list<value_type> ilist) {
+            range_assign(ilist.begin(), ilist.end());
+            return *this;
+        }
+
+        //=============================== assign ===============================
+        void assign(size_type count, const value_type& value) {
+            iterator cur = begin();
+            for (; count > 0 && cur != end(); --count, (void) ++cur) {
+                *cur = value;
+            }
+            if (count == 0) {
+                erase_at_end(cur);
+            } else {
+                fill_append(count, value);
+            }
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        void assign(InputIterator first, InputIterator last) {
+            range_assign(first, last);
+        }
+
+        void assign(std::initializer_list<value_type> ilist) {
+            range_assign(ilist.begin(), ilist.end());
+        }
+
+        allocator_type get_allocator() const noexcept {
+            return allocator_type(get_alloc());
+        }
+
+        //================================ 元素访问 =================================
+        reference at(size_type index) {
+            if (index >= size()) {
+                throw std::out_of_range("deque::at");
+            }
+            return impl_.start_[difference_type(index)];
+        }
+
+        const_reference at(size_type index) const {
+            if (index >= size()) {
+                throw std::out_of_range("deque::at");
+            }
+            return impl_.start_[difference_type(index)];
+        }
+
+        reference operator[](size_type index) {
+            return impl_.start_[difference_type(index)];
+        }
+
+        const_reference operator[](size_type index) const {
+            return impl_.start_[difference_type(index)];
+        }
+
+        reference front() {
+            return *impl_.start_;
+        }
+
+        const_reference front() const {
+            return *impl_.start_;
+        }
+
+        reference back() {
+            iterator temp = impl_.finish_;
+            --temp;
+            return *temp;
+        }
+
+        const_reference back() const {
+            iterator temp = impl_.finish_;
+            --temp;
+            return *temp;
+        }
+
+        //================================ 迭代器 ==================================
+        iterator begin() noexcept {
+            return impl_.start_;
+        }
+
+        const_iterator begin() const noexcept {
+            return impl_.start_;
+        }
+
+        const_iterator cbegin() const noexcept {
+            return impl_.start_;
+        }
+
+        iterator end() noexcept {
+            return impl_.finish_;
+        }
+
+        const_iterator end() const noexcept {
+            return impl_.finish_;
+        }
+
+        const_iterator cend() const noexcept {
+            return impl_.finish_;
+        }
+
+        reverse_iterator rbegin() noexcept {
+            return reverse_iterator(end());
+        }
+
+        const_reverse_iterator rbegin() const noexcept {
+            return const_reverse_iterator(end());
+        }
+
+        const_reverse_iterator crbegin() const noexcept {
+            return const_reverse_iterator(end());
+        }
+
+        reverse_iterator rend() noexcept {
+            return reverse_iterator(begin());
+        }
+
+        const_reverse_iterator rend() const noexcept {
+            return const_reverse_iterator(begin());
+        }
+
+        const_reverse_iterator crend() const noexcept {
+            return const_reverse_iterator(begin());
+        }
+
+        //================================ 容量 ====================================
+        [[nodiscard]] bool empty() const noexcept {
+            return impl_.finish_ == impl_.start_;
+        }
+
+        size_type size() const noexcept {
+            return size_type(impl_.finish_ - impl_.start_);
+        }
+
+        size_type max_size() const noexcept {
+            size_type diffmax  = std::numeric_limits<difference_type>::max() / sizeof(T);
+            size_type allocmax = alloc_traits::max_size(get_alloc());
+            return std::min(diffmax, allocmax);
+        }
+
+        /*
+         * 非强制性请求：归还缓存的空闲块，并在 map_ 远大于所需时换一个小的 map_
+         * -- 元素所在的块不会搬迁，所有迭代器仍然失效（map_ 可能更换）
+         */
+        void shrink_to_fit() {
+            if (impl_.spare_) {
+                alloc_traits::deallocate(get_alloc(), impl_.spare_, block_size);
+                impl_.spare_ = nullptr;
+            }
+            if (!impl_.map_) {
+                return;
+            }
+            const size_type num_nodes    = size_type(impl_.finish_.node_ - impl_.start_.node_) + 1;
+            const size_type new_map_size = std::max(initial_map_size, num_nodes + 2);
+            if (new_map_size >= impl_.map_size_) {
+                return;
+            }
+            map_pointer new_map    = allocate_map(new_map_size);
+            map_pointer new_nstart = new_map + (new_map_size - num_nodes) / 2;
+            std::copy(impl_.start_.node_, impl_.finish_.node_ + 1, new_nstart);
+            deallocate_map(impl_.map_, impl_.map_size_);
+            impl_.map_      = new_map;
+            impl_.map_size_ = new_map_size;
+            impl_.start_.set_node(new_nstart);
+            impl_.finish_.set_node(new_nstart + num_nodes - 1);
+        }
+
+        //================================ 修改器 ==================================
+        // 保留 start 所在的块，其余块归还
+        void clear() noexcept {
+            erase_at_end(begin());
+        }
+
+        iterator insert(const_iterator pos, const value_type& value) {
+            return emplace(pos, value);
+        }
+
+        iterator insert(const_iterator pos, value_type&& value) {
+            return emplace(pos, std::move(value));
+        }
+
+        iterator insert(const_iterator pos, size_type count, const value_type& value) {
+            const difference_type index = pos - cbegin();
+            if (size_type(index) < size() / 2) {
+                // value 的引用不会因为在两端插入而失效，不需要先复制一份
+                fill_prepend(count, value);
+                std::rotate(begin(), begin() + difference_type(count), begin() + difference_type(count) + index);
+            } else {
+                const difference_type old_size = difference_type(size());
+                fill_append(count, value);
+                std::rotate(begin() + index, begin() + old_size, end());
+            }
+            return begin() + index;
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        iterator insert(const_iterator pos, InputIterator first, InputIterator last) {
+            return range_insert(pos, first, last, std::__iterator_category(first));
+        }
+
+        iterator insert(const_iterator pos, std::initializer_list<value_type> ilist) {
+            return range_insert(pos, ilist.begin(), ilist.end(), std::random_access_iterator_tag());
+        }
+
+        /*
+         * 在 pos 前就地构造元素
+         * -- 靠近哪一端就平移哪一端，最多移动 size() / 2 个元素
+         * -- 在两端插入时只构造一个元素，不移动任何元素
+         */
+        template<class... Args>
+        iterator emplace(const_iterator pos, Args&&... args) {
+            if (pos.cur_ == impl_.start_.cur_) {
+                emplace_front(std::forward<Args>(args)...);
+                return begin();
+            }
+            if (pos.cur_ == impl_.finish_.cur_) {
+                emplace_back(std::forward<Args>(args)...);
+                return end() - 1;
+            }
+            return insert_aux(pos - cbegin(), std::forward<Args>(args)...);
+        }
+
+        iterator erase(const_iterator pos) {
+            const difference_type index = pos - cbegin();
+            iterator position           = begin() + index;
+            iterator next               = position + 1;
+            if (size_type(index) < size() / 2) {
+                std::move_backward(begin(), position, next);
+                pop_front();
+            } else {
+                std::move(next, end(), position);
+                pop_back();
+            }
+            return begin() + index;
+        }
+
+        iterator erase(const_iterator first, const_iterator last) {
+            if (first == last) {
+                return begin() + (first - cbegin());
+            }
+            const difference_type count        = last - first;
+            const difference_type elems_before = first - cbegin();
+            if (size_type(elems_before) < (size() - size_type(count)) / 2) {
+                // 前半段向后平移，再从头部删除
+                std::move_backward(begin(), begin() + elems_before, begin() + elems_before + count);
+                erase_at_begin(begin() + count);
+            } else {
+                std::move(begin() + elems_before + count, end(), begin() + elems_before);
+                erase_at_end(end() - count);
+            }
+            return begin() + elems_before;
+        }
+
+        void push_back(const value_type& value) {
+            emplace_back(value);
+        }
+
+        void push_back(value_type&& value) {
+            emplace_back(std::move(value));
+        }
+
+        template<class... Args>
+        reference emplace_back(Args&&... args) {
+            // 空 deque 的迭代器全为空指针，差为 0，同样走慢速路径
+            if (impl_.finish_.last_ - impl_.finish_.cur_ > 1) {
+                alloc_traits::construct(get_alloc(), impl_.finish_.cur_, std::forward<Args>(args)...);
+                ++impl_.finish_.cur_;
+            } else {
+                realloc_emplace_back(std::forward<Args>(args)...);
+            }
+            return back();
+        }
+
+        void pop_back() {
+            if (impl_.finish_.cur_ != impl_.finish_.first_) {
+                --impl_.finish_.cur_;
+                alloc_traits::destroy(get_alloc(), impl_.finish_.cur_);
+            } else {
+                // finish 在块首，最后一个元素在前一块的末尾，finish 所在的块不再需要
+                deallocate_node(impl_.finish_.first_);
+                impl_.finish_.set_node(impl_.finish_.node_ - 1);
+                impl_.finish_.cur_ = impl_.finish_.last_ - 1;
+                alloc_traits::destroy(get_alloc(), impl_.finish_.cur_);
+            }
+        }
+
+        void push_front(const value_type& value) {
+            emplace_front(value);
+        }
+
+        void push_front(value_type&& value) {
+            emplace_front(std::move(value));
+        }
+
+        template<class... Args>
+        reference emplace_front(Args&&... args) {
+            if (impl_.start_.cur_ != impl_.start_.first_) {
+                alloc_traits::construct(get_alloc(), impl_.start_.cur_ - 1, std::forward<Args>(args)...);
+                --impl_.start_.cur_;
+            } else {
+                realloc_emplace_front(std::forward<Args>(args)...);
+            }
+            return front();
+        }
+
+        void pop_front() {
+            alloc_traits::destroy(get_alloc(), impl_.start_.cur_);
+            if (impl_.start_.cur_ != impl_.start_.last_ - 1) {
+                ++impl_.start_.cur_;
+            } else {
+                // 块中最后一个元素已删除，归还该块
+                deallocate_node(impl_.start_.first_);
+                impl_.start_.set_node(impl_.start_.node_ + 1);
+                impl_.start_.cur_ = impl_.start_.first_;
+            }
+        }
+
+        void resize(size_type count) {
+            const size_type len = size();
+            if (count > len) {
+                default_append(count - len);
+            } else if (count < len) {
+                erase_at_end(begin() + difference_type(count));
+            }
+        }
+
+        void resize(size_type count, const value_type& value) {
+            const size_type len = size();
+            if (count > len) {
+                fill_append(count - len, value);
+            } else if (count < len) {
+                erase_at_end(begin() + difference_type(count));
+            }
+        }
+
+        //====================================== swap ============================================
+        // 分配器只在 propagate_on_container_swap 为真时交换
+        void swap(deque& other) noexcept {
+            using std::swap;
+            swap(impl_.map_, other.impl_.map_);
+            swap(impl_.map_size_, other.impl_.map_size_);
+            swap(impl_.start_, other.impl_.start_);
+            swap(impl_.finish_, other.impl_.finish_);
+            swap(impl_.spare_, other.impl_.spare_);
+            alloc_on_swap(get_alloc(), other.get_alloc());
+        }
+
+    private:
+        //==========================工具函数=======================
+        Allocator& get_alloc() noexcept {
+            return impl_;
+        }
+
+        const Allocator& get_alloc() const noexcept {
+            return impl_;
+        }
+
+        // 优先复用缓存的空闲块
+        pointer allocate_node() {
+            if (impl_.spare_) {
+                pointer p    = impl_.spare_;
+                impl_.spare_ = nullptr;
+                return p;
+            }
+            return alloc_traits::allocate(get_alloc(), block_size);
+        }
+
+        void deallocate_node(pointer p) noexcept {
+            if (!impl_.spare_) {
+                impl_.spare_ = p;
+            } else {
+                alloc_traits::deallocate(get_alloc(), p, block_size);
+            }
+        }
+
+        map_pointer allocate_map(size_type count) {
+            map_alloc_type map_alloc(get_alloc());
+            return map_alloc_traits::allocate(map_alloc, count);
+        }
+
+        void deallocate_map(map_pointer p, size_type count) noexcept {
+            map_alloc_type map_alloc(get_alloc());
+            map_alloc_traits::deallocate(map_alloc, p, count);
+        }
+
+        size_type check_init_len(size_type count) const {
+            if (count > max_size()) {
+                throw std::length_error("deque size is greater than max_size()");
+            }
+            return count;
+        }
+
+        /*
+         * 为 count 个元素分配 map_ 和块，start 指向第一个块的块首，finish = start + count
+         * -- 只能在 map_ 为空时调用；元素由调用者构造
+         * -- 分配块时抛出异常会归还已分配的块和 map_
+         */
+        void initialize_map(size_type count) {
+            const size_type num_nodes = count / block_size + 1;
+            const size_type map_size  = std::max(initial_map_size, num_nodes + 2);
+            map_pointer map           = allocate_map(map_size);
+            map_pointer nstart        = map + (map_size - num_nodes) / 2;
+            map_pointer nfinish       = nstart + num_nodes;
+            map_pointer cur           = nstart;
+            try {
+                for (; cur < nfinish; ++cur) {
+                    *cur = allocate_node();
+                }
+            } catch (...) {
+                for (map_pointer node = nstart; node < cur; ++node) {
+                    alloc_traits::deallocate(get_alloc(), *node, block_size);
+                }
+                deallocate_map(map, map_size);
+                throw;
+            }
+            impl_.map_      = map;
+            impl_.map_size_ = map_size;
+            impl_.start_.set_node(nstart);
+            impl_.finish_.set_node(nfinish - 1);
+            impl_.start_.cur_  = impl_.start_.first_;
+            impl_.finish_.cur_ = impl_.finish_.first_ + count % block_size;
+        }
+
+        template<class InputIterator>
+        void range_initialize(InputIterator first, InputIterator last, std::input_iterator_tag) {
+            try {
+                for (; first != last; ++first) {
+                    emplace_back(*first);
+                }
+            } catch (...) {
+                clear();
+                throw;
+            }
+        }
+
+        // 元素构造失败时 uninitialized_copy_a 析构已构造的部分，块和 map_ 由 deque_impl 归还
+        template<class ForwardIterator>
+        void range_initialize(ForwardIterator first, ForwardIterator last, std::forward_iterator_tag) {
+            const size_type count = check_init_len(size_type(std::distance(first, last)));
+            initialize_map(count);
+            uninitialized_copy_a(first, last, impl_.start_, get_alloc());
+        }
+
+        // 复用已有元素逐个赋值，多余的删除，不足的追加
+        template<class InputIterator>
+        void range_assign(InputIterator first, InputIterator last) {
+            iterator cur = begin();
+            for (; first != last && cur != end(); ++cur, (void) ++first) {
+                *cur = *first;
+            }
+            if (first == last) {
+                erase_at_end(cur);
+            } else {
+                range_append(first, last);
+            }
+        }
+
+        void move_assign(deque&& other, std::true_type) noexcept {
+            clear();
+            impl_.release();
+            impl_.steal(other.impl_);
+            alloc_on_move(get_alloc(), other.get_alloc());
+        }
+
+        void move_assign(deque&& other, std::false_type) {
+            if (get_alloc() == other.get_alloc()) {
+                move_assign(std::move(other), std::true_type());
+            } else {
+                range_assign(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+                other.clear();
+            }
+        }
+
+        /*
+         * 确保 map_ 尾部还有 nodes_to_add 个空位
+         * -- 注意 finish 所在的块已分配，所以要求的是 finish.node_ 之后的空位
+         */
+        void reserve_map_at_back(size_type nodes_to_add = 1) {
+            if (nodes_to_add + 1 > impl_.map_size_ - size_type(impl_.finish_.node_ - impl_.map_)) {
+                reallocate_map(nodes_to_add, false);
+            }
+        }
+
+        void reserve_map_at_front(size_type nodes_to_add = 1) {
+            if (nodes_to_add > size_type(impl_.start_.node_ - impl_.map_)) {
+                reallocate_map(nodes_to_add, true);
+            }
+        }
+
+        /*
+         * 在 map_ 的一端腾出 nodes_to_add 个空位
+         * -- map_ 的总长度超过所需的两倍时，把块指针挪回中间，不分配内存
+         * -- 否则分配更大的 map_，只复制块指针；元素和块都不移动
+         */
+        void reallocate_map(size_type nodes_to_add, bool add_at_front) {
+            const size_type old_num_nodes = size_type(impl_.finish_.node_ - impl_.start_.node_) + 1;
+            const size_type new_num_nodes = old_num_nodes + nodes_to_add;
+
+            map_pointer new_nstart;
+            if (impl_.map_size_ > 2 * new_num_nodes) {
+                new_nstart = impl_.map_ + (impl_.map_size_ - new_num_nodes) / 2 + (add_at_front ? nodes_to_add : 0);
+                if (new_nstart < impl_.start_.node_) {
+                    std::copy(impl_.start_.node_, impl_.finish_.node_ + 1, new_nstart);
+                } else {
+                    std::copy_backward(impl_.start_.node_, impl_.finish_.node_ + 1, new_nstart + old_num_nodes);
+                }
+            } else {
+                const size_type new_map_size = impl_.map_size_ + std::max(impl_.map_size_, nodes_to_add) + 2;
+                map_pointer new_map          = allocate_map(new_map_size);
+                new_nstart = new_map + (new_map_size - new_num_nodes) / 2 + (add_at_front ? nodes_to_add : 0);
+                std::copy(impl_.start_.node_, impl_.finish_.node_ + 1, new_nstart);
+                deallocate_map(impl_.map_, impl_.map_size_);
+                impl_.map_      = new_map;
+                impl_.map_size_ = new_map_size;
+            }
+            // 块指针的值没有变，set_node 之后 cur_ 仍然有效
+            impl_.start_.set_node(new_nstart);
+            impl_.finish_.set_node(new_nstart + old_num_nodes - 1);
+        }
+
+        // finish 所在块只剩最后一个位置：在该位置构造元素，再为 finish 分配下一块
+        template<class... Args>
+        void realloc_emplace_back(Args&&... args) {
+            if (!impl_.map_) {
+                initialize_map(0);
+                alloc_traits::construct(get_alloc(), impl_.finish_.cur_, std::forward<Args>(args)...);
+                ++impl_.finish_.cur_;
+                return;
+            }
+            if (size() == max_size()) {
+                throw std::length_error("cannot create deque larger than max_size()");
+            }
+            reserve_map_at_back();
+            *(impl_.finish_.node_ + 1) = allocate_node();
+            try {
+                alloc_traits::construct(get_alloc(), impl_.finish_.cur_, std::forward<Args>(args)...);
+            } catch (...) {
+                deallocate_node(*(impl_.finish_.node_ + 1));
+                throw;
+            }
+            impl_.finish_.set_node(impl_.finish_.node_ + 1);
+            impl_.finish_.cur_ = impl_.finish_.first_;
+        }
+
+        // start 在块首：分配前一块，在其末尾构造元素
+        template<class... Args>
+        void realloc_emplace_front(Args&&... args) {
+            if (!impl_.map_) {
+                initialize_map(0);
+            }
+            if (size() == max_size()) {
+                throw std::length_error("cannot create deque larger than max_size()");
+            }
+            reserve_map_at_front();
+            *(impl_.start_.node_ - 1) = allocate_node();
+            try {
+                alloc_traits::construct(get_alloc(), *(impl_.start_.node_ - 1) + (block_size - 1),
+                                        std::forward<Args>(args)...);
+            } catch (...) {
+                deallocate_node(*(impl_.start_.node_ - 1));
+                throw;
+            }
+            impl_.start_.set_node(impl_.start_.node_ - 1);
+            impl_.start_.cur_ = impl_.start_.last_ - 1;
+        }
+
+        /*
+         * 在下标 index 处插入一个元素（不在两端）
+         * -- 先构造临时对象：参数可能引用 deque 中将被移动的元素
+         * -- 把靠近的一端的端点元素复制到新位置，再平移 index 两侧较短的一段
+         */
+        template<class... Args>
+        iterator insert_aux(difference_type index, Args&&... args) {
+            value_type value(std::forward<Args>(args)...);
+            if (size_type(index) < size() / 2) {
+                emplace_front(std::move(front()));
+                iterator front1 = begin() + 1;
+                std::move(front1 + 1, front1 + index, front1);
+            } else {
+                emplace_back(std::move(back()));
+                iterator back1 = end() - 1;
+                std::move_backward(begin() + index, back1 - 1, back1);
+            }
+            iterator pos = begin() + index;
+            *pos         = std::move(value);
+            return pos;
+        }
+
+        /*
+         * 插入一段元素
+         * -- 先追加到靠近的一端，再用 std::rotate 转到 pos，移动次数为 count 加上较短一侧的长度
+         * -- 追加中途抛出异常时删除已追加的元素，deque 恢复原样
+         */
+        template<class InputIterator>
+        iterator range_insert(const_iterator pos, InputIterator first, InputIterator last, std::input_iterator_tag) {
+            const difference_type index    = pos - cbegin();
+            const difference_type old_size = difference_type(size());
+            range_append(first, last);
+            std::rotate(begin() + index, begin() + old_size, end());
+            return begin() + index;
+        }
+
+        template<class ForwardIterator>
+        iterator range_insert(const_iterator pos, ForwardIterator first, ForwardIterator last,
+                              std::forward_iterator_tag) {
+            const difference_type index = pos - cbegin();
+            if (size_type(index) >= size() / 2) {
+                return range_insert(pos, first, last, std::input_iterator_tag());
+            }
+            size_type count = 0;
+            try {
+                for (; first != last; ++first, (void) ++count) {
+                    emplace_front(*first);
+                }
+            } catch (...) {
+                for (; count > 0; --count) {
+                    pop_front();
+                }
+                throw;
+            }
+            // 逐个插到头部后顺序是反的
+            const difference_type n = difference_type(count);
+            std::reverse(begin(), begin() + n);
+            std::rotate(begin(), begin() + n, begin() + n + index);
+            return begin() + index;
+        }
+
+        template<class InputIterator>
+        void range_append(InputIterator first, InputIterator last) {
+            const size_type old_size = size();
+            try {
+                for (; first != last; ++first) {
+                    emplace_back(*first);
+                }
+            } catch (...) {
+                erase_at_end(begin() + difference_type(old_size));
+                throw;
+            }
+        }
+
+        void fill_append(size_type count, const value_type& value) {
+            const size_type old_size = size();
+            try {
+                for (; count > 0; --count) {
+                    emplace_back(value);
+                }
+            } catch (...) {
+                erase_at_end(begin() + difference_type(old_size));
+                throw;
+            }
+        }
+
+        void fill_prepend(size_type count, const value_type& value) {
+            size_type added = 0;
+            try {
+                for (; added < count; ++added) {
+                    emplace_front(value);
+                }
+            } catch (...) {
+                for (; added > 0; --added) {
+                    pop_front();
+                }
+                throw;
+            }
+        }
+
+        void default_append(size_type count) {
+            const size_type old_size = size();
+            try {
+                for (; count > 0; --count) {
+                    emplace_back();
+                }
+            } catch (...) {
+                erase_at_end(begin() + difference_type(old_size));
+                throw;
+            }
+        }
+
+        // 删除 [pos, end())，归还 pos 所在块之后的块
+        void erase_at_end(iterator pos) noexcept {
+            if (pos == impl_.finish_) {
+                return;
+            }
+            destroy_a(pos, impl_.finish_, get_alloc());
+            for (map_pointer node = pos.node_ + 1; node <= impl_.finish_.node_; ++node) {
+                deallocate_node(*node);
+            }
+            impl_.finish_ = pos;
+        }
+
+        // 删除 [begin(), pos)，归还 pos 所在块之前的块
+        void erase_at_begin(iterator pos) noexcept {
+            if (pos == impl_.start_) {
+                return;
+            }
+            destroy_a(impl_.start_, pos, get_alloc());
+            for (map_pointer node = impl_.start_.node_; node < pos.node_; ++node) {
+                deallocate_node(*node);
+            }
+            impl_.start_ = pos;
+        }
+    };
+
+    //==================================== 非成员函数 ==========================
+    template<class T, class Allocator>
+    bool operator==(const deque<T, Allocator>& lhs, const deque<T, Allocator>& rhs) {
+        return (lhs.size() == rhs.size()) &&
+               std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+
+    template<class T, class Allocator>
+    bool operator!=(const deque<T, Allocator>& lhs, const deque<T, Allocator>& rhs) {
+        return !(lhs == rhs);
+    }
+
+    template<class T, class Allocator>
+    bool operator<(const deque<T, Allocator>& lhs, const deque<T, Allocator>& rhs) {
+        return std::lexicographical_compare(lhs.begin(), lhs.end(),
+                                            rhs.begin(), rhs.end());
+    }
+
+    template<class T, class Allocator>
+    bool operator<=(const deque<T, Allocator>& lhs, const deque<T, Allocator>& rhs) {
+        return !(rhs < lhs);
+    }
+
+    template<class T, class Allocator>
+    bool operator>(const deque<T, Allocator>& lhs, const deque<T, Allocator>& rhs) {
+        return rhs < lhs;
+    }
+
+    template<class T, class Allocator>
+    bool operator>=(const deque<T, Allocator>& lhs, const deque<T, Allocator>& rhs) {
+        return !(lhs < rhs);
+    }
+
+    template<class T, class Allocator>
+    void swap(deque<T, Allocator>& lhs, deque<T, Allocator>& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+}
+#endif //DEQUE_H
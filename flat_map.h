@@ -0,0 +1,785 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "flat_set.h"
+#include "vector.h"
+
+namespace Lsh {
+    /*
+     * flat_map 的迭代器：同时移动键和值两个容器的迭代器
+     * -- 解引用得到 pair<const Key&, T&>（代理对象），不是 pair<Key, T>&，
+     *    所以 operator-> 返回一个保存该 pair 的小对象
+     */
+    template<class KeyIter, class MappedIter>
+    class flat_map_iterator {
+        template<class, class>
+        friend class flat_map_iterator;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type        = std::pair<typename std::iterator_traits<KeyIter>::value_type,
+                                            typename std::iterator_traits<MappedIter>::value_type>;
+        using difference_type   = std::ptrdiff_t;
+        using reference         = std::pair<typename std::iterator_traits<KeyIter>::reference,
+                                            typename std::iterator_traits<MappedIter>::reference>;
+
+        struct arrow_proxy {
+            reference ref;
+
+            reference* operator->() noexcept {
+                return std::addressof(ref);
+            }
+        };
+
+        using pointer = arrow_proxy;
+
+        flat_map_iterator() = default;
+
+        flat_map_iterator(KeyIter key_it, MappedIter mapped_it) : key_it_(key_it), mapped_it_(mapped_it) {
+        }
+
+        // iterator 可以隐式转换为 const_iterator
+        template<class OtherMappedIter, typename = typename std::enable_if<
+                                            !std::is_same<OtherMappedIter, MappedIter>::value &&
+                                            std::is_convertible<OtherMappedIter, MappedIter>::value>::type>
+        flat_map_iterator(const flat_map_iterator<KeyIter, OtherMappedIter>& other)
+            : key_it_(other.key_it_), mapped_it_(other.mapped_it_) {
+        }
+
+        reference operator*() const {
+            return reference(*key_it_, *mapped_it_);
+        }
+
+        pointer operator->() const {
+            return pointer{**this};
+        }
+
+        reference operator[](difference_type n) const {
+            return *(*this + n);
+        }
+
+        flat_map_iterator& operator++() {
+            ++key_it_;
+            ++mapped_it_;
+            return *this;
+        }
+
+        flat_map_iterator operator++(int) {
+            flat_map_iterator temp = *this;
+            ++*this;
+            return temp;
+        }
+
+        flat_map_iterator& operator--() {
+            --key_it_;
+            --mapped_it_;
+            return *this;
+        }
+
+        flat_map_iterator operator--(int) {
+            flat_map_iterator temp = *this;
+            --*this;
+            return temp;
+        }
+
+        flat_map_iterator& operator+=(difference_type n) {
+            key_it_ += n;
+            mapped_it_ += n;
+            return *this;
+        }
+
+        flat_map_iterator& operator-=(difference_type n) {
+            return *this += -n;
+        }
+
+        flat_map_iterator operator+(difference_type n) const {
+            flat_map_iterator temp = *this;
+            return temp += n;
+        }
+
+        flat_map_iterator operator-(difference_type n) const {
+            flat_map_iterator temp = *this;
+            return temp -= n;
+        }
+
+        friend flat_map_iterator operator+(difference_type n, const flat_map_iterator& it) {
+            return it + n;
+        }
+
+        // 两个迭代器同步移动，只比较键的迭代器即可
+        friend difference_type operator-(const flat_map_iterator& lhs, const flat_map_iterator& rhs) {
+            return lhs.key_it_ - rhs.key_it_;
+        }
+
+        friend bool operator==(const flat_map_iterator& lhs, const flat_map_iterator& rhs) {
+            return lhs.key_it_ == rhs.key_it_;
+        }
+
+        friend bool operator!=(const flat_map_iterator& lhs, const flat_map_iterator& rhs) {
+            return lhs.key_it_ != rhs.key_it_;
+        }
+
+        friend bool operator<(const flat_map_iterator& lhs, const flat_map_iterator& rhs) {
+            return lhs.key_it_ < rhs.key_it_;
+        }
+
+        friend bool operator>(const flat_map_iterator& lhs, const flat_map_iterator& rhs) {
+            return rhs.key_it_ < lhs.key_it_;
+        }
+
+        friend bool operator<=(const flat_map_iterator& lhs, const flat_map_iterator& rhs) {
+            return !(rhs.key_it_ < lhs.key_it_);
+        }
+
+        friend bool operator>=(const flat_map_iterator& lhs, const flat_map_iterator& rhs) {
+            return !(lhs.key_it_ < rhs.key_it_);
+        }
+
+    private:
+        KeyIter key_it_{};
+        MappedIter mapped_it_{};
+    };
+
+    /*
+     * 基于有序 vector 的映射
+     *
+     *   keys_   : [k0 k1 k2 k3 ...]   有序、无重复
+     *   values_ : [v0 v1 v2 v3 ...]   values_[i] 对应 keys_[i]
+     *
+     * -- 键和值分两个容器（默认 Lsh::vector）存放：查找只扫描键数组，
+     *    一条缓存行能放下的键比 pair<Key, T> 多，值很大时差别更明显
+     * -- 查找用 flat_lower_bound（无分支二分）；单个插入/删除要平移两个数组的后半段，是 O(n)
+     * -- 批量 insert(first, last)：追加到末尾，对新元素的下标排序，再一趟把新旧两部分归并、去重
+     *    到新的数组中，整体 O(n + m log m)
+     * -- 任何插入/删除都会使迭代器失效
+     */
+    template<class Key, class T, class Compare = std::less<Key>,
+             class KeyContainer = vector<Key>, class MappedContainer = vector<T>>
+    class flat_map {
+        static_assert(std::is_same<typename KeyContainer::value_type, Key>::value,
+                      "flat_map must have the same key_type as its key container");
+        static_assert(std::is_same<typename MappedContainer::value_type, T>::value,
+                      "flat_map must have the same mapped_type as its mapped container");
+
+    public:
+        using key_type               = Key;
+        using mapped_type            = T;
+        using value_type             = std::pair<key_type, mapped_type>;
+        using key_compare            = Compare;
+        using reference              = std::pair<const key_type&, typename MappedContainer::reference>;
+        using const_reference        = std::pair<const key_type&, typename MappedContainer::const_reference>;
+        using size_type              = std::size_t;
+        using difference_type        = std::ptrdiff_t;
+        using iterator               = flat_map_iterator<typename KeyContainer::const_iterator,
+                                                         typename MappedContainer::iterator>;
+        using const_iterator         = flat_map_iterator<typename KeyContainer::const_iterator,
+                                                         typename MappedContainer::const_iterator>;
+        using reverse_iterator       = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+        using key_container_type     = KeyContainer;
+        using mapped_container_type  = MappedContainer;
+
+        // 按键比较两个元素
+        class value_compare {
+            friend class flat_map;
+
+        public:
+            template<class L, class R>
+            bool operator()(const L& lhs, const R& rhs) const {
+                return comp_(lhs.first, rhs.first);
+            }
+
+        private:
+            explicit value_compare(const key_compare& comp) : comp_(comp) {
+            }
+
+            key_compare comp_;
+        };
+
+        // extract() 的返回值
+        struct containers {
+            key_container_type keys;
+            mapped_container_type values;
+        };
+
+        //===============================构造函数==============================
+        flat_map() = default;
+
+        explicit flat_map(const key_compare& comp) : compare_(comp) {
+        }
+
+        // 接管两个任意顺序的容器，按键排序并去重（重复的键保留先出现的）
+        flat_map(key_container_type keys, mapped_container_type values, const key_compare& comp = key_compare())
+            : keys_(std::move(keys)), values_(std::move(values)), compare_(comp) {
+            check_sizes();
+            sort_and_unique(0);
+        }
+
+        // 接管两个已经按键有序且键无重复的容器
+        flat_map(sorted_unique_t, key_container_type keys, mapped_container_type values,
+                 const key_compare& comp = key_compare())
+            : keys_(std::move(keys)), values_(std::move(values)), compare_(comp) {
+            check_sizes();
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        flat_map(InputIterator first, InputIterator last, const key_compare& comp = key_compare()) : compare_(comp) {
+            insert(first, last);
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        flat_map(sorted_unique_t, InputIterator first, InputIterator last, const key_compare& comp = key_compare())
+            : compare_(comp) {
+            append(first, last, 0);
+        }
+
+        flat_map(std::initializer_list<value_type> ilist, const key_compare& comp = key_compare()) : compare_(comp) {
+            insert(ilist.begin(), ilist.end());
+        }
+
+        flat_map& operator=(std::initializer_list<value_type> ilist) {
+            clear();
+            insert(ilist.begin(), ilist.end());
+            return *this;
+        }
+
+        //================================ 迭代器 ==================================
+        iterator begin() noexcept {
+            return iterator(keys_.cbegin(), values_.begin());
+        }
+
+        const_iterator begin() const noexcept {
+            return const_iterator(keys_.cbegin(), values_.begin());
+        }
+
+        const_iterator cbegin() const noexcept {
+            return begin();
+        }
+
+        iterator end() noexcept {
+            return iterator(keys_.cend(), values_.end());
+        }
+
+        const_iterator end() const noexcept {
+            return const_iterator(keys_.cend(), values_.end());
+        }
+
+        const_iterator cend() const noexcept {
+            return end();
+        }
+
+        reverse_iterator rbegin() noexcept {
+            return reverse_iterator(end());
+        }
+
+        const_reverse_iterator rbegin() const noexcept {
+            return const_reverse_iterator(end());
+        }
+
+        const_reverse_iterator crbegin() const noexcept {
+            return const_reverse_iterator(end());
+        }
+
+        reverse_iterator rend() noexcept {
+            return reverse_iterator(begin());
+        }
+
+        const_reverse_iterator rend() const noexcept {
+            return const_reverse_iterator(begin());
+        }
+
+        const_reverse_iterator crend() const noexcept {
+            return const_reverse_iterator(begin());
+        }
+
+        //================================ 容量 ====================================
+        [[nodiscard]] bool empty() const noexcept {
+            return keys_.empty();
+        }
+
+        size_type size() const noexcept {
+            return keys_.size();
+        }
+
+        size_type max_size() const noexcept {
+            return std::min<size_type>(keys_.max_size(), values_.max_size());
+        }
+
+        void reserve(size_type new_cap) {
+            keys_.reserve(new_cap);
+            values_.reserve(new_cap);
+        }
+
+        void shrink_to_fit() {
+            keys_.shrink_to_fit();
+            values_.shrink_to_fit();
+        }
+
+        //================================ 元素访问 =================================
+        typename mapped_container_type::reference operator[](const key_type& key) {
+            return try_emplace(key).first->second;
+        }
+
+        typename mapped_container_type::reference operator[](key_type&& key) {
+            return try_emplace(std::move(key)).first->second;
+        }
+
+        typename mapped_container_type::reference at(const key_type& key) {
+            const size_type index = find_index(key);
+            if (index == size()) {
+                throw std::out_of_range("flat_map::at");
+            }
+            return values_[index];
+        }
+
+        typename mapped_container_type::const_reference at(const key_type& key) const {
+            const size_type index = find_index(key);
+            if (index == size()) {
+                throw std::out_of_range("flat_map::at");
+            }
+            return values_[index];
+        }
+
+        //================================ 修改器 ==================================
+        template<class... Args>
+        std::pair<iterator, bool> emplace(Args&&... args) {
+            value_type value(std::forward<Args>(args)...);
+            return try_emplace(std::move(value.first), std::move(value.second));
+        }
+
+        std::pair<iterator, bool> insert(const value_type& value) {
+            return try_emplace(value.first, value.second);
+        }
+
+        std::pair<iterator, bool> insert(value_type&& value) {
+            return try_emplace(std::move(value.first), std::move(value.second));
+        }
+
+        // 提示位置正确（键应该恰好放在 hint 之前）时不再二分查找
+        iterator insert(const_iterator hint, const value_type& value) {
+            return insert_hint(hint, value.first, value.second);
+        }
+
+        iterator insert(const_iterator hint, value_type&& value) {
+            return insert_hint(hint, std::move(value.first), std::move(value.second));
+        }
+
+        /*
+         * 批量插入
+         * -- 追加到两个容器末尾，对新元素的下标排序，再一趟归并新旧两部分并去重；
+         *    重复的键保留原有的值，新元素之间重复时保留先出现的，与逐个 insert 的结果相同
+         * -- 新元素已经有序且都大于原有的键时（例如按顺序批量加载），排序后直接返回
+         * -- 追加时抛出异常会删除追加的元素，映射恢复原样；归并时抛出异常只保证不泄漏
+         */
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        void insert(InputIterator first, InputIterator last) {
+            const size_type old_size = size();
+            append(first, last, old_size);
+            sort_and_unique(old_size);
+        }
+
+        // 输入已经按键有序且无重复：省去排序
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        void insert(sorted_unique_t, InputIterator first, InputIterator last) {
+            const size_type old_size = size();
+            append(first, last, old_size);
+            merge_and_unique(old_size, nullptr);
+        }
+
+        void insert(std::initializer_list<value_type> ilist) {
+            insert(ilist.begin(), ilist.end());
+        }
+
+        // 键不存在时才构造值；键存在时 args 不会被移动
+        template<class... Args>
+        std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args) {
+            return try_emplace_impl(key, std::forward<Args>(args)...);
+        }
+
+        template<class... Args>
+        std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args) {
+            return try_emplace_impl(std::move(key), std::forward<Args>(args)...);
+        }
+
+        template<class M>
+        std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj) {
+            return insert_or_assign_impl(key, std::forward<M>(obj));
+        }
+
+        template<class M>
+        std::pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj) {
+            return insert_or_assign_impl(std::move(key), std::forward<M>(obj));
+        }
+
+        // 取出两个底层容器，flat_map 变为空
+        containers extract() && {
+            containers result{std::move(keys_), std::move(values_)};
+            clear();
+            return result;
+        }
+
+        // 换上两个按键有序且键无重复的容器
+        void replace(key_container_type&& keys, mapped_container_type&& values) {
+            if (keys.size() != values.size()) {
+                throw std::invalid_argument("flat_map::replace: keys and values differ in size");
+            }
+            keys_   = std::move(keys);
+            values_ = std::move(values);
+        }
+
+        iterator erase(iterator pos) {
+            return erase(const_iterator(pos));
+        }
+
+        iterator erase(const_iterator pos) {
+            const difference_type index = pos - cbegin();
+            keys_.erase(keys_.begin() + index);
+            values_.erase(values_.begin() + index);
+            return begin() + index;
+        }
+
+        iterator erase(const_iterator first, const_iterator last) {
+            const difference_type index = first - cbegin();
+            const difference_type count = last - first;
+            keys_.erase(keys_.begin() + index, keys_.begin() + index + count);
+            values_.erase(values_.begin() + index, values_.begin() + index + count);
+            return begin() + index;
+        }
+
+        size_type erase(const key_type& key) {
+            const size_type index = find_index(key);
+            if (index == size()) {
+                return 0;
+            }
+            erase(cbegin() + difference_type(index));
+            return 1;
+        }
+
+        void swap(flat_map& other) noexcept {
+            using std::swap;
+            keys_.swap(other.keys_);
+            values_.swap(other.values_);
+            swap(compare_, other.compare_);
+        }
+
+        void clear() noexcept {
+            keys_.clear();
+            values_.clear();
+        }
+
+        //================================ 查找 ====================================
+        // 比较器带 is_transparent 时，K 可以是任何能与 Key 比较的类型，不必构造 Key
+        iterator find(const key_type& key) {
+            return begin() + difference_type(find_index(key));
+        }
+
+        const_iterator find(const key_type& key) const {
+            return begin() + difference_type(find_index(key));
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        iterator find(const K& key) {
+            return begin() + difference_type(find_index(key));
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        const_iterator find(const K& key) const {
+            return begin() + difference_type(find_index(key));
+        }
+
+        size_type count(const key_type& key) const {
+            return find_index(key) != size() ? 1 : 0;
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        size_type count(const K& key) const {
+            return find_index(key) != size() ? 1 : 0;
+        }
+
+        bool contains(const key_type& key) const {
+            return find_index(key) != size();
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        bool contains(const K& key) const {
+            return find_index(key) != size();
+        }
+
+        iterator lower_bound(const key_type& key) {
+            return begin() + difference_type(lower_bound_index(key));
+        }
+
+        const_iterator lower_bound(const key_type& key) const {
+            return begin() + difference_type(lower_bound_index(key));
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        iterator lower_bound(const K& key) {
+            return begin() + difference_type(lower_bound_index(key));
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        const_iterator lower_bound(const K& key) const {
+            return begin() + difference_type(lower_bound_index(key));
+        }
+
+        iterator upper_bound(const key_type& key) {
+            return begin() + difference_type(upper_bound_index(key));
+        }
+
+        const_iterator upper_bound(const key_type& key) const {
+            return begin() + difference_type(upper_bound_index(key));
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        iterator upper_bound(const K& key) {
+            return begin() + difference_type(upper_bound_index(key));
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        const_iterator upper_bound(const K& key) const {
+            return begin() + difference_type(upper_bound_index(key));
+        }
+
+        std::pair<iterator, iterator> equal_range(const key_type& key) {
+            return equal_range_impl(*this, key);
+        }
+
+        std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const {
+            return equal_range_impl(*this, key);
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        std::pair<iterator, iterator> equal_range(const K& key) {
+            return equal_range_impl(*this, key);
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        std::pair<const_iterator, const_iterator> equal_range(const K& key) const {
+            return equal_range_impl(*this, key);
+        }
+
+        //================================ 观察器 ==================================
+        key_compare key_comp() const {
+            return compare_;
+        }
+
+        value_compare value_comp() const {
+            return value_compare(compare_);
+        }
+
+        const key_container_type& keys() const noexcept {
+            return keys_;
+        }
+
+        const mapped_container_type& values() const noexcept {
+            return values_;
+        }
+
+    private:
+        //==========================工具函数=======================
+        void check_sizes() const {
+            if (keys_.size() != values_.size()) {
+                throw std::invalid_argument("flat_map: keys and values differ in size");
+            }
+        }
+
+        template<class K>
+        size_type lower_bound_index(const K& key) const {
+            return size_type(flat_lower_bound(keys_.begin(), keys_.end(), key, compare_) - keys_.begin());
+        }
+
+        template<class K>
+        size_type upper_bound_index(const K& key) const {
+            return size_type(flat_upper_bound(keys_.begin(), keys_.end(), key, compare_) - keys_.begin());
+        }
+
+        // 找不到时返回 size()
+        template<class K>
+        size_type find_index(const K& key) const {
+            const size_type index = lower_bound_index(key);
+            return (index != size() && !compare_(key, keys_[index])) ? index : size();
+        }
+
+        template<class Self, class K>
+        static auto equal_range_impl(Self& self, const K& key) -> std::pair<decltype(self.begin()),
+                                                                            decltype(self.begin())> {
+            const size_type index = self.lower_bound_index(key);
+            const size_type last  = (index != self.size() && !self.compare_(key, self.keys_[index])) ? index + 1
+                                                                                                     : index;
+            return {self.begin() + difference_type(index), self.begin() + difference_type(last)};
+        }
+
+        // 在 index 处插入一对键值；值插入失败时撤销键的插入，两个容器保持等长
+        template<class K, class... Args>
+        iterator insert_at(size_type index, K&& key, Args&&... args) {
+            keys_.insert(keys_.begin() + difference_type(index), std::forward<K>(key));
+            try {
+                values_.emplace(values_.begin() + difference_type(index), std::forward<Args>(args)...);
+            } catch (...) {
+                keys_.erase(keys_.begin() + difference_type(index));
+                throw;
+            }
+            return begin() + difference_type(index);
+        }
+
+        template<class K, class... Args>
+        std::pair<iterator, bool> try_emplace_impl(K&& key, Args&&... args) {
+            const size_type index = lower_bound_index(key);
+            if (index != size() && !compare_(key, keys_[index])) {
+                return {begin() + difference_type(index), false};
+            }
+            return {insert_at(index, std::forward<K>(key), std::forward<Args>(args)...), true};
+        }
+
+        template<class K, class M>
+        std::pair<iterator, bool> insert_or_assign_impl(K&& key, M&& obj) {
+            const size_type index = lower_bound_index(key);
+            if (index != size() && !compare_(key, keys_[index])) {
+                values_[index] = std::forward<M>(obj);
+                return {begin() + difference_type(index), false};
+            }
+            return {insert_at(index, std::forward<K>(key), std::forward<M>(obj)), true};
+        }
+
+        template<class K, class M>
+        iterator insert_hint(const_iterator hint, K&& key, M&& obj) {
+            const size_type index = size_type(hint - cbegin());
+            // 要求 keys_[index - 1] < key < keys_[index]
+            if ((index == 0 || compare_(keys_[index - 1], key)) && (index == size() || compare_(key, keys_[index]))) {
+                return insert_at(index, std::forward<K>(key), std::forward<M>(obj));
+            }
+            return try_emplace_impl(std::forward<K>(key), std::forward<M>(obj)).first;
+        }
+
+        // 把 [first,last) 的键值对追加到两个容器末尾；抛出异常时删除已追加的部分
+        template<class InputIterator>
+        void append(InputIterator first, InputIterator last, size_type old_size) {
+            try {
+                for (; first != last; ++first) {
+                    // *first 可能是 pair，也可能是 flat_map 迭代器给出的 pair 引用代理
+                    auto&& value = *first;
+                    keys_.emplace_back(std::get<0>(std::forward<decltype(value)>(value)));
+                    values_.emplace_back(std::get<1>(std::forward<decltype(value)>(value)));
+                }
+            } catch (...) {
+                keys_.erase(keys_.begin() + difference_type(old_size), keys_.end());
+                values_.erase(values_.begin() + difference_type(old_size), values_.end());
+                throw;
+            }
+        }
+
+        // 对 [old_size, size()) 按键排序（只排下标），再归并
+        void sort_and_unique(size_type old_size) {
+            const size_type count = size() - old_size;
+            if (count == 0) {
+                return;
+            }
+            vector<size_type> order(count);
+            std::iota(order.begin(), order.end(), size_type(0));
+            auto tail = keys_.cbegin() + difference_type(old_size);
+            // 稳定排序：相等的键保持输入顺序，去重时保留先出现的
+            std::stable_sort(order.begin(), order.end(), [this, tail](size_type lhs, size_type rhs) {
+                return compare_(tail[lhs], tail[rhs]);
+            });
+            merge_and_unique(old_size, order.begin());
+        }
+
+        /*
+         * 归并 [0, old_size) 与新追加的部分，order 是新部分排好序的下标（为空表示已经有序）
+         * -- 结果写入新的两个容器，每个元素只移动一次，最后整体换入
+         * -- 新部分严格递增且大于原有的最后一个键时，已经是最终结果
+         */
+        void merge_and_unique(size_type old_size, const size_type* order) {
+            const size_type count = size() - old_size;
+            if (count == 0) {
+                return;
+            }
+            auto tail    = keys_.cbegin() + difference_type(old_size);
+            auto new_key = [tail, order](size_type j) -> const key_type& {
+                return tail[order ? order[j] : j];
+            };
+
+            bool sorted = old_size == 0 || compare_(keys_[old_size - 1], new_key(0));
+            for (size_type j = 1; sorted && j < count; ++j) {
+                sorted = compare_(new_key(j - 1), new_key(j));
+            }
+            if (sorted && !order) {
+                return;
+            }
+            if (sorted && std::is_sorted(order, order + count)) {
+                return;
+            }
+
+            key_container_type keys;
+            mapped_container_type values;
+            keys.reserve(old_size + count);
+            values.reserve(old_size + count);
+            // 与上一个写入的键相等时丢弃：原有的先于新的写入，新的之间先出现的先写入
+            auto take = [&](size_type from) {
+                if (!keys.empty() && !compare_(keys.back(), keys_[from])) {
+                    return;
+                }
+                keys.emplace_back(std::move(keys_[from]));
+                values.emplace_back(std::move(values_[from]));
+            };
+            size_type i = 0;
+            size_type j = 0;
+            while (i < old_size && j < count) {
+                if (compare_(new_key(j), keys_[i])) {
+                    take(old_size + (order ? order[j] : j));
+                    ++j;
+                } else {
+                    take(i);
+                    ++i;
+                }
+            }
+            for (; i < old_size; ++i) {
+                take(i);
+            }
+            for (; j < count; ++j) {
+                take(old_size + (order ? order[j] : j));
+            }
+            keys_.swap(keys);
+            values_.swap(values);
+        }
+
+        key_container_type keys_;
+        mapped_container_type values_;
+        Compare compare_;
+    };
+
+    //==================================== 非成员函数 ==========================
+    template<class Key, class T, class Compare, class KeyContainer, class MappedContainer>
+    bool operator==(const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& lhs,
+                    const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& rhs) {
+        return lhs.keys() == rhs.keys() && lhs.values() == rhs.values();
+    }
+
+    template<class Key, class T, class Compare, class KeyContainer, class MappedContainer>
+    bool operator!=(const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& lhs,
+                    const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& rhs) {
+        return !(lhs == rhs);
+    }
+
+    template<class Key, class T, class Compare, class KeyContainer, class MappedContainer>
+    void swap(flat_map<Key, T, Compare, KeyContainer, MappedContainer>& lhs,
+              flat_map<Key, T, Compare, KeyContainer, MappedContainer>& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+}
+#endif //FLAT_MAP_H
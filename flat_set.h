@@ -0,0 +1,450 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef FLAT_SET_H
+#define FLAT_SET_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include "vector.h"
+
+namespace Lsh {
+    // 标记参数：调用者保证输入已按比较器排好序且没有重复键，跳过排序和去重
+    struct sorted_unique_t {
+        explicit sorted_unique_t() = default;
+    };
+
+    inline constexpr sorted_unique_t sorted_unique{};
+
+    /*
+     * 有序区间上的二分查找
+     * -- 循环体里没有分支，比较结果只决定 base 是否前移，编译器生成 cmov，
+     *    不会因为分支预测失败清空流水线；每轮都访问区间中点，前几轮的位置对所有查找相同，常驻缓存
+     * -- 结果与 std::lower_bound / std::upper_bound 相同
+     */
+    template<class RandomIt, class K, class Compare>
+    RandomIt flat_lower_bound(RandomIt first, RandomIt last, const K& key, Compare& comp) {
+        auto len = last - first;
+        if (len == 0) {
+            return first;
+        }
+        while (len > 1) {
+            const auto half = len / 2;
+            first = comp(first[half], key) ? first + half : first;
+            len -= half;
+        }
+        return first + (comp(*first, key) ? 1 : 0);
+    }
+
+    template<class RandomIt, class K, class Compare>
+    RandomIt flat_upper_bound(RandomIt first, RandomIt last, const K& key, Compare& comp) {
+        auto len = last - first;
+        if (len == 0) {
+            return first;
+        }
+        while (len > 1) {
+            const auto half = len / 2;
+            first = comp(key, first[half]) ? first : first + half;
+            len -= half;
+        }
+        return first + (comp(key, *first) ? 0 : 1);
+    }
+
+    /*
+     * 基于有序 vector 的集合
+     * -- 所有键连续存放在一个 KeyContainer（默认 Lsh::vector）中，查找是一次二分，没有节点指针可追
+     * -- 单个插入/删除要平移后半段，是 O(n)；适合读多写少、或者批量构建的场景
+     * -- 批量 insert(first, last)：追加到末尾，只对新元素排序，再与原有部分归并、去重，
+     *    整体 O(n + m log m)，而不是 m 次 O(n) 的中间插入
+     * -- 迭代器就是 KeyContainer 的 const_iterator，插入/删除后失效
+     */
+    template<class Key, class Compare = std::less<Key>, class KeyContainer = vector<Key>>
+    class flat_set {
+        static_assert(std::is_same<typename KeyContainer::value_type, Key>::value,
+                      "flat_set must have the same value_type as its container");
+
+    public:
+        using key_type               = Key;
+        using value_type             = Key;
+        using key_compare            = Compare;
+        using value_compare          = Compare;
+        using reference              = value_type&;
+        using const_reference        = const value_type&;
+        using size_type              = typename KeyContainer::size_type;
+        using difference_type        = typename KeyContainer::difference_type;
+        using iterator               = typename KeyContainer::const_iterator;
+        using const_iterator         = typename KeyContainer::const_iterator;
+        using reverse_iterator       = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+        using container_type         = KeyContainer;
+
+        //===============================构造函数==============================
+        flat_set() = default;
+
+        explicit flat_set(const key_compare& comp) : compare_(comp) {
+        }
+
+        // 接管一个任意顺序的容器，排序并去重
+        explicit flat_set(container_type cont, const key_compare& comp = key_compare())
+            : keys_(std::move(cont)), compare_(comp) {
+            sort_and_unique(0);
+        }
+
+        // 接管一个已经有序且无重复的容器
+        flat_set(sorted_unique_t, container_type cont, const key_compare& comp = key_compare())
+            : keys_(std::move(cont)), compare_(comp) {
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        flat_set(InputIterator first, InputIterator last, const key_compare& comp = key_compare()) : compare_(comp) {
+            insert(first, last);
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        flat_set(sorted_unique_t, InputIterator first, InputIterator last, const key_compare& comp = key_compare())
+            : keys_(first, last), compare_(comp) {
+        }
+
+        flat_set(std::initializer_list<value_type> ilist, const key_compare& comp = key_compare()) : compare_(comp) {
+            insert(ilist.begin(), ilist.end());
+        }
+
+        flat_set& operator=(std::initializer_list<value_type> ilist) {
+            clear();
+            insert(ilist.begin(), ilist.end());
+            return *this;
+        }
+
+        //================================ 迭代器 ==================================
+        iterator begin() const noexcept {
+            return keys_.begin();
+        }
+
+        const_iterator cbegin() const noexcept {
+            return keys_.begin();
+        }
+
+        iterator end() const noexcept {
+            return keys_.end();
+        }
+
+        const_iterator cend() const noexcept {
+            return keys_.end();
+        }
+
+        reverse_iterator rbegin() const noexcept {
+            return reverse_iterator(end());
+        }
+
+        const_reverse_iterator crbegin() const noexcept {
+            return const_reverse_iterator(end());
+        }
+
+        reverse_iterator rend() const noexcept {
+            return reverse_iterator(begin());
+        }
+
+        const_reverse_iterator crend() const noexcept {
+            return const_reverse_iterator(begin());
+        }
+
+        //================================ 容量 ====================================
+        [[nodiscard]] bool empty() const noexcept {
+            return keys_.empty();
+        }
+
+        size_type size() const noexcept {
+            return keys_.size();
+        }
+
+        size_type max_size() const noexcept {
+            return keys_.max_size();
+        }
+
+        void reserve(size_type new_cap) {
+            keys_.reserve(new_cap);
+        }
+
+        void shrink_to_fit() {
+            keys_.shrink_to_fit();
+        }
+
+        //================================ 修改器 ==================================
+        template<class... Args>
+        std::pair<iterator, bool> emplace(Args&&... args) {
+            value_type key(std::forward<Args>(args)...);
+            return insert_unique(std::move(key));
+        }
+
+        std::pair<iterator, bool> insert(const value_type& value) {
+            return insert_unique(value);
+        }
+
+        std::pair<iterator, bool> insert(value_type&& value) {
+            return insert_unique(std::move(value));
+        }
+
+        // 提示位置正确（value 应该恰好放在 hint 之前）时不再二分查找
+        iterator insert(const_iterator hint, const value_type& value) {
+            return insert_hint(hint, value);
+        }
+
+        iterator insert(const_iterator hint, value_type&& value) {
+            return insert_hint(hint, std::move(value));
+        }
+
+        /*
+         * 批量插入：追加到末尾 -> 对新追加的部分排序 -> 与原有部分原地归并 -> 去重
+         * -- 归并是稳定的，相等的键中原有的排在前面，去重时保留下来，与逐个 insert 的结果相同
+         * -- 中途抛出异常时删除追加的元素，集合恢复原样（排序、归并阶段抛出时除外）
+         */
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        void insert(InputIterator first, InputIterator last) {
+            const size_type old_size = keys_.size();
+            append(first, last, old_size);
+            sort_and_unique(old_size);
+        }
+
+        // 输入已经有序且无重复：省去排序，只做归并和去重
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        void insert(sorted_unique_t, InputIterator first, InputIterator last) {
+            const size_type old_size = keys_.size();
+            append(first, last, old_size);
+            merge_and_unique(old_size);
+        }
+
+        void insert(std::initializer_list<value_type> ilist) {
+            insert(ilist.begin(), ilist.end());
+        }
+
+        // 取出底层容器，flat_set 变为空
+        container_type extract() && {
+            container_type result = std::move(keys_);
+            keys_.clear();
+            return result;
+        }
+
+        // 换上一个有序且无重复的容器
+        void replace(container_type&& cont) {
+            keys_ = std::move(cont);
+        }
+
+        iterator erase(const_iterator pos) {
+            return keys_.erase(pos);
+        }
+
+        iterator erase(const_iterator first, const_iterator last) {
+            return keys_.erase(first, last);
+        }
+
+        size_type erase(const key_type& key) {
+            const_iterator it = find(key);
+            if (it == end()) {
+                return 0;
+            }
+            keys_.erase(it);
+            return 1;
+        }
+
+        void swap(flat_set& other) noexcept {
+            using std::swap;
+            keys_.swap(other.keys_);
+            swap(compare_, other.compare_);
+        }
+
+        void clear() noexcept {
+            keys_.clear();
+        }
+
+        //================================ 查找 ====================================
+        // 比较器带 is_transparent 时，K 可以是任何能与 Key 比较的类型，不必构造 Key
+        iterator find(const key_type& key) const {
+            return find_impl(key);
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        iterator find(const K& key) const {
+            return find_impl(key);
+        }
+
+        size_type count(const key_type& key) const {
+            return find(key) != end() ? 1 : 0;
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        size_type count(const K& key) const {
+            return find(key) != end() ? 1 : 0;
+        }
+
+        bool contains(const key_type& key) const {
+            return find(key) != end();
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        bool contains(const K& key) const {
+            return find(key) != end();
+        }
+
+        iterator lower_bound(const key_type& key) const {
+            return flat_lower_bound(keys_.begin(), keys_.end(), key, compare_);
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        iterator lower_bound(const K& key) const {
+            return flat_lower_bound(keys_.begin(), keys_.end(), key, compare_);
+        }
+
+        iterator upper_bound(const key_type& key) const {
+            return flat_upper_bound(keys_.begin(), keys_.end(), key, compare_);
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        iterator upper_bound(const K& key) const {
+            return flat_upper_bound(keys_.begin(), keys_.end(), key, compare_);
+        }
+
+        std::pair<iterator, iterator> equal_range(const key_type& key) const {
+            return equal_range_impl(key);
+        }
+
+        template<class K, class C = Compare, typename = typename C::is_transparent>
+        std::pair<iterator, iterator> equal_range(const K& key) const {
+            return equal_range_impl(key);
+        }
+
+        //================================ 观察器 ==================================
+        key_compare key_comp() const {
+            return compare_;
+        }
+
+        value_compare value_comp() const {
+            return compare_;
+        }
+
+        const container_type& keys() const noexcept {
+            return keys_;
+        }
+
+    private:
+        //==========================工具函数=======================
+        template<class K>
+        iterator find_impl(const K& key) const {
+            iterator it = flat_lower_bound(keys_.begin(), keys_.end(), key, compare_);
+            return (it != keys_.end() && !compare_(key, *it)) ? it : keys_.end();
+        }
+
+        template<class K>
+        std::pair<iterator, iterator> equal_range_impl(const K& key) const {
+            iterator it = flat_lower_bound(keys_.begin(), keys_.end(), key, compare_);
+            if (it != keys_.end() && !compare_(key, *it)) {
+                return {it, it + 1};
+            }
+            return {it, it};
+        }
+
+        template<class V>
+        std::pair<iterator, bool> insert_unique(V&& value) {
+            iterator it = flat_lower_bound(keys_.begin(), keys_.end(), value, compare_);
+            if (it != keys_.end() && !compare_(value, *it)) {
+                return {it, false};
+            }
+            return {keys_.insert(it, std::forward<V>(value)), true};
+        }
+
+        template<class V>
+        iterator insert_hint(const_iterator hint, V&& value) {
+            // 要求 *(hint - 1) < value < *hint
+            if ((hint == keys_.begin() || compare_(*(hint - 1), value)) &&
+                (hint == keys_.end() || compare_(value, *hint))) {
+                return keys_.insert(hint, std::forward<V>(value));
+            }
+            return insert_unique(std::forward<V>(value)).first;
+        }
+
+        template<class InputIterator>
+        void append(InputIterator first, InputIterator last, size_type old_size) {
+            try {
+                for (; first != last; ++first) {
+                    keys_.emplace_back(*first);
+                }
+            } catch (...) {
+                keys_.erase(keys_.begin() + difference_type(old_size), keys_.end());
+                throw;
+            }
+        }
+
+        // 对 [old_size, size()) 排序，再与前面已有序的部分归并、去重
+        void sort_and_unique(size_type old_size) {
+            std::stable_sort(keys_.begin() + difference_type(old_size), keys_.end(), compare_);
+            merge_and_unique(old_size);
+        }
+
+        void merge_and_unique(size_type old_size) {
+            auto first  = keys_.begin();
+            auto middle = first + difference_type(old_size);
+            if (middle == keys_.end()) {
+                return;
+            }
+            if (old_size != 0) {
+                if (compare_(*(middle - 1), *middle)) {
+                    // 新元素全部大于原有元素（例如逐批追加有序数据）：不必归并，原有部分也没有重复
+                    first = middle - 1;
+                } else {
+                    std::inplace_merge(first, middle, keys_.end(), compare_);
+                }
+            }
+            auto new_end = std::unique(first, keys_.end(), [this](const Key& lhs, const Key& rhs) {
+                return !compare_(lhs, rhs);
+            });
+            keys_.erase(new_end, keys_.end());
+        }
+
+        KeyContainer keys_;
+        Compare compare_;
+    };
+
+    //==================================== 非成员函数 ==========================
+    template<class Key, class Compare, class KeyContainer>
+    bool operator==(const flat_set<Key, Compare, KeyContainer>& lhs, const flat_set<Key, Compare, KeyContainer>& rhs) {
+        return (lhs.size() == rhs.size()) &&
+               std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+
+    template<class Key, class Compare, class KeyContainer>
+    bool operator!=(const flat_set<Key, Compare, KeyContainer>& lhs, const flat_set<Key, Compare, KeyContainer>& rhs) {
+        return !(lhs == rhs);
+    }
+
+    template<class Key, class Compare, class KeyContainer>
+    bool operator<(const flat_set<Key, Compare, KeyContainer>& lhs, const flat_set<Key, Compare, KeyContainer>& rhs) {
+        return std::lexicographical_compare(lhs.begin(), lhs.end(),
+                                            rhs.begin(), rhs.end());
+    }
+
+    template<class Key, class Compare, class KeyContainer>
+    bool operator<=(const flat_set<Key, Compare, KeyContainer>& lhs, const flat_set<Key, Compare, KeyContainer>& rhs) {
+        return !(rhs < lhs);
+    }
+
+    template<class Key, class Compare, class KeyContainer>
+    bool operator>(const flat_set<Key, Compare, KeyContainer>& lhs, const flat_set<Key, Compare, KeyContainer>& rhs) {
+        return rhs < lhs;
+    }
+
+    template<class Key, class Compare, class KeyContainer>
+    bool operator>=(const flat_set<Key, Compare, KeyContainer>& lhs, const flat_set<Key, Compare, KeyContainer>& rhs) {
+        return !(lhs < rhs);
+    }
+
+    template<class Key, class Compare, class KeyContainer>
+    void swap(flat_set<Key, Compare, KeyContainer>& lhs, flat_set<Key, Compare, KeyContainer>& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+}
+#endif //FLAT_SET_H
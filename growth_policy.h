@@ -0,0 +1,102 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef GROWTH_POLICY_H
+#define GROWTH_POLICY_H
+
+#include <algorithm>
+#include <cstddef>
+
+/*
+ * Growth policies decide the new capacity of a container that has run out of room.
+ *
+ * Every policy provides
+ *
+ *     static constexpr std::size_t next_capacity(std::size_t size, std::size_t required, std::size_t elem_size);
+ *
+ * where `size` is the current number of elements, `required` (> size) is the minimum capacity
+ * the pending operation needs and `elem_size` is sizeof(value_type). The result must be at
+ * least `required`; the container clamps it to max_size() and treats a wrapped-around result
+ * as overflow.
+ */
+
+namespace Lsh {
+    /**
+    * @brief Doubles the capacity: size + max(size, count).
+    *
+    * Fewest reallocations, but up to half of the reservation may stay unused.
+    */
+    struct growth_2x {
+        static constexpr std::size_t next_capacity(std::size_t size, std::size_t required, std::size_t) noexcept {
+            return std::max(required, size + size);
+        }
+    };
+
+    /**
+    * @brief Grows by half of the current size.
+    *
+    * With a factor below the golden ratio, the blocks freed by earlier reallocations eventually
+    * add up to more than the next request, so an allocator that coalesces neighbours can hand
+    * the same memory back instead of always extending the heap. Over-reservation is at most 1/3.
+    */
+    struct growth_1_5x {
+        static constexpr std::size_t next_capacity(std::size_t size, std::size_t required, std::size_t) noexcept {
+            return std::max(required, size + size / 2);
+        }
+    };
+
+    /**
+    * @brief Applies Base, then rounds the byte size up to the next malloc-style size class.
+    *
+    * Size classes follow the jemalloc/tcmalloc layout: multiples of 16 bytes up to 128 bytes,
+    * then four classes per power of two. Requesting exactly a class size means the slack the
+    * allocator would have added anyway becomes usable capacity.
+    */
+    template<class Base = growth_2x>
+    struct size_class_growth {
+        static constexpr std::size_t next_capacity(std::size_t size, std::size_t required,
+                                                   std::size_t elem_size) noexcept {
+            const std::size_t len = Base::next_capacity(size, required, elem_size);
+            if (len > static_cast<std::size_t>(-1) / elem_size / 2) {
+                return len;
+            }
+            return round_to_size_class(len * elem_size) / elem_size;
+        }
+
+        static constexpr std::size_t round_to_size_class(std::size_t bytes) noexcept {
+            if (bytes <= 128) {
+                return (bytes + 15) & ~std::size_t(15);
+            }
+            // Four classes in (2^k, 2^(k+1)]: spacing is 2^(k-2).
+            std::size_t power = 128;
+            while (power * 2 < bytes) {
+                power <<= 1;
+            }
+            const std::size_t spacing = power / 4;
+            return (bytes + spacing - 1) / spacing * spacing;
+        }
+    };
+
+    /**
+    * @brief Doubles below ThresholdBytes, then grows by a fixed StepBytes.
+    *
+    * Huge vectors stop reserving up to twice what they hold: past the threshold the unused tail
+    * never exceeds one step. Pair it with an allocator that can grow in place
+    * (malloc_allocator) so the extra reallocations stay cheap.
+    */
+    template<std::size_t ThresholdBytes = std::size_t(1) << 30, std::size_t StepBytes = std::size_t(1) << 28>
+    struct linear_growth {
+        static_assert(StepBytes > 0, "linear_growth needs a non-zero step");
+
+        static constexpr std::size_t next_capacity(std::size_t size, std::size_t required,
+                                                   std::size_t elem_size) noexcept {
+            if (size < ThresholdBytes / elem_size) {
+                return std::max(required, size + size);
+            }
+            const std::size_t step = std::max<std::size_t>(StepBytes / elem_size, 1);
+            return std::max(required, size + step);
+        }
+    };
+}
+#endif //GROWTH_POLICY_H
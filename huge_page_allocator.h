@@ -0,0 +1,268 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef HUGE_PAGE_ALLOCATOR_H
+#define HUGE_PAGE_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include "allocator.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define LSH_HAS_HUGE_PAGES 1
+#else
+#define LSH_HAS_HUGE_PAGES 0
+#endif
+
+namespace Lsh {
+    // Size and alignment of a transparent or hugetlbfs huge page on x86-64 and most arm64 kernels.
+    constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+
+    /**
+    * @brief Options for huge_page_allocator, combined with |.
+    *
+    * - huge_page_hugetlb: try MAP_HUGETLB first. It only succeeds when huge pages have been
+    *   reserved (vm.nr_hugepages); otherwise the allocator falls back to transparent huge pages.
+    * - huge_page_populate: fault in every page during allocate, so the first touch on the hot
+    *   path does not pay for page faults or zeroing.
+    */
+    enum huge_page_options : unsigned {
+        huge_page_default  = 0,
+        huge_page_hugetlb  = 1u << 0,
+        huge_page_populate = 1u << 1,
+    };
+
+    /**
+    * @brief An allocator that backs large blocks with 2 MiB pages.
+    *
+    * - Blocks of at least Threshold bytes are mapped with mmap, rounded up to a multiple of
+    *   huge_page_size and aligned to it, then marked with madvise(MADV_HUGEPAGE) so the kernel
+    *   can use transparent huge pages. One TLB entry then covers 2 MiB instead of 4 KiB.
+    * - With huge_page_hugetlb, MAP_HUGETLB is tried first.
+    * - With huge_page_populate, every page is faulted in before allocate returns.
+    * - Smaller blocks come from ::operator new, as with Lsh::allocator, honouring alignof(T).
+    * - allocate_zeroed relies on mapped blocks being fresh zero pages and only clears
+    *   smaller blocks explicitly.
+    * - On systems without mmap every block comes from ::operator new.
+    *
+    * Whether a block is mapped depends only on its size in bytes, so deallocate must be passed
+    * the element count that allocated the block (or the count from allocate_at_least).
+    *
+    * @tparam T The type of objects this allocator will manage.
+    * @tparam Threshold Blocks of at least this many bytes use huge pages.
+    * @tparam Options A combination of huge_page_options.
+    */
+    template<class T, std::size_t Threshold = huge_page_size, unsigned Options = huge_page_default>
+    class huge_page_allocator {
+    public:
+        typedef T              value_type;
+        typedef T*             pointer;
+        typedef const T*       const_pointer;
+        typedef T&             reference;
+        typedef const T&       const_reference;
+        typedef std::size_t    size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type is_always_equal;
+
+        template<class U>
+        struct rebind {
+            typedef huge_page_allocator<U, Threshold, Options> other;
+        };
+
+    public:
+        huge_page_allocator() noexcept = default;
+
+        huge_page_allocator(const huge_page_allocator&) noexcept = default;
+
+        template<class U>
+        huge_page_allocator(const huge_page_allocator<U, Threshold, Options>&) noexcept {
+        }
+
+        ~huge_page_allocator() = default;
+
+        [[nodiscard]] static size_type max_size() noexcept;
+
+        static pointer allocate(size_type n);
+
+        static allocation_result<pointer, size_type> allocate_at_least(size_type n);
+
+        static pointer allocate_zeroed(size_type n);
+
+        static void deallocate(pointer p, size_type n) noexcept;
+
+    private:
+        static bool is_mapped(size_type bytes) noexcept;
+
+        static size_type huge_round(size_type bytes) noexcept;
+
+        static void* map(size_type bytes);
+
+        static void prefault(void* p, size_type bytes) noexcept;
+    };
+
+    template<class T, std::size_t Threshold, unsigned Options>
+    typename huge_page_allocator<T, Threshold, Options>::size_type
+    huge_page_allocator<T, Threshold, Options>::max_size() noexcept {
+        return (std::numeric_limits<size_type>::max() - huge_page_size) / sizeof(value_type);
+    }
+
+    template<class T, std::size_t Threshold, unsigned Options>
+    typename huge_page_allocator<T, Threshold, Options>::pointer
+    huge_page_allocator<T, Threshold, Options>::allocate(size_type n) {
+        if (n > max_size()) {
+            throw std::bad_alloc();
+        }
+        const size_type bytes = n * sizeof(T);
+        if (is_mapped(bytes)) {
+            return static_cast<pointer>(map(huge_round(bytes)));
+        }
+        return static_cast<pointer>(aligned_operator_new(bytes, alignof(T)));
+    }
+
+    template<class T, std::size_t Threshold, unsigned Options>
+    allocation_result<typename huge_page_allocator<T, Threshold, Options>::pointer,
+                      typename huge_page_allocator<T, Threshold, Options>::size_type>
+    huge_page_allocator<T, Threshold, Options>::allocate_at_least(size_type n) {
+        if (n <= max_size()) {
+            const size_type bytes = n * sizeof(T);
+            if (is_mapped(bytes)) {
+                // The rest of the last huge page is mapped anyway.
+                n = huge_round(bytes) / sizeof(T);
+            } else {
+                // Round up to the malloc size class, but never up to Threshold: deallocate picks
+                // munmap or operator delete from the count, so it must stay on the operator new side.
+                const size_type count = malloc_good_size(bytes) / sizeof(T);
+                if (!is_mapped(count * sizeof(T))) {
+                    n = count;
+                }
+            }
+        }
+        return {allocate(n), n};
+    }
+
+    template<class T, std::size_t Threshold, unsigned Options>
+    typename huge_page_allocator<T, Threshold, Options>::pointer
+    huge_page_allocator<T, Threshold, Options>::allocate_zeroed(size_type n) {
+        pointer p = allocate(n);
+        if (!is_mapped(n * sizeof(T))) {
+            std::memset(static_cast<void*>(p), 0, n * sizeof(T));
+        }
+        return p;
+    }
+
+    template<class T, std::size_t Threshold, unsigned Options>
+    void huge_page_allocator<T, Threshold, Options>::deallocate(pointer p, size_type n) noexcept {
+#if LSH_HAS_HUGE_PAGES
+        if (is_mapped(n * sizeof(T))) {
+            ::munmap(p, huge_round(n * sizeof(T)));
+            return;
+        }
+#endif
+        aligned_operator_delete(p, n * sizeof(T), alignof(T));
+    }
+
+    template<class T, std::size_t Threshold, unsigned Options>
+    bool huge_page_allocator<T, Threshold, Options>::is_mapped(size_type bytes) noexcept {
+        return LSH_HAS_HUGE_PAGES && bytes >= Threshold;
+    }
+
+    template<class T, std::size_t Threshold, unsigned Options>
+    typename huge_page_allocator<T, Threshold, Options>::size_type
+    huge_page_allocator<T, Threshold, Options>::huge_round(size_type bytes) noexcept {
+        return (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+    }
+
+    /*
+     * bytes is a multiple of huge_page_size.
+     * - MAP_HUGETLB returns huge-page-aligned memory directly.
+     * - Otherwise over-map by one huge page, trim both ends so the block starts on a 2 MiB
+     *   boundary, and advise the kernel to back it with transparent huge pages.
+     */
+    template<class T, std::size_t Threshold, unsigned Options>
+    void* huge_page_allocator<T, Threshold, Options>::map(size_type bytes) {
+#if LSH_HAS_HUGE_PAGES
+#if defined(MAP_HUGETLB)
+        if (Options & huge_page_hugetlb) {
+            int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#if defined(MAP_POPULATE)
+            if (Options & huge_page_populate) {
+                flags |= MAP_POPULATE;
+            }
+#endif
+            void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (p != MAP_FAILED) {
+                return p;
+            }
+        }
+#endif
+        void* raw = ::mmap(nullptr, bytes + huge_page_size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        const std::uintptr_t start   = reinterpret_cast<std::uintptr_t>(raw);
+        const std::uintptr_t aligned = (start + huge_page_size - 1) & ~std::uintptr_t(huge_page_size - 1);
+        const size_type head         = aligned - start;
+        const size_type tail         = huge_page_size - head;
+        if (head) {
+            ::munmap(raw, head);
+        }
+        if (tail) {
+            ::munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+        }
+        void* p = reinterpret_cast<void*>(aligned);
+#if defined(MADV_HUGEPAGE)
+        ::madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+        if (Options & huge_page_populate) {
+            // MAP_POPULATE at mmap time would fault in 4 KiB pages before the advice applies.
+            prefault(p, bytes);
+        }
+        return p;
+#else
+        return aligned_operator_new(bytes, alignof(T));
+#endif
+    }
+
+    // Writes one byte per base page so every page is backed before the hot path touches it.
+    template<class T, std::size_t Threshold, unsigned Options>
+    void huge_page_allocator<T, Threshold, Options>::prefault(void* p, size_type bytes) noexcept {
+#if LSH_HAS_HUGE_PAGES
+#if defined(MADV_POPULATE_WRITE)
+        if (::madvise(p, bytes, MADV_POPULATE_WRITE) == 0) {
+            return;
+        }
+#endif
+        static const size_type page = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+        volatile char* bytes_ptr    = static_cast<volatile char*>(p);
+        for (size_type offset = 0; offset < bytes; offset += page) {
+            bytes_ptr[offset] = 0;
+        }
+#else
+        (void) p;
+        (void) bytes;
+#endif
+    }
+
+    template<class T, class U, std::size_t Threshold, unsigned Options>
+    bool operator==(const huge_page_allocator<T, Threshold, Options>&,
+                    const huge_page_allocator<U, Threshold, Options>&) noexcept {
+        return true;
+    }
+
+    template<class T, class U, std::size_t Threshold, unsigned Options>
+    bool operator!=(const huge_page_allocator<T, Threshold, Options>&,
+                    const huge_page_allocator<U, Threshold, Options>&) noexcept {
+        return false;
+    }
+}
+#endif //HUGE_PAGE_ALLOCATOR_H
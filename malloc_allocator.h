@@ -0,0 +1,254 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef MALLOC_ALLOCATOR_H
+#define MALLOC_ALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include "allocator.h"
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define LSH_HAS_MREMAP 1
+#else
+#define LSH_HAS_MREMAP 0
+#endif
+
+namespace Lsh {
+    /**
+    * @brief An allocator backed by malloc/realloc that can grow a block in place.
+    *
+    * Besides the usual allocate/deallocate, it provides `reallocate(p, old_n, new_n)`.
+    * The call keeps the first min(old_n, new_n) objects' bytes and may return a different
+    * address. Containers call it only for element types that can be relocated byte-wise.
+    *
+    * - Blocks smaller than MmapThreshold bytes come from malloc and grow with realloc,
+    *   which extends them in place whenever the heap allows.
+    * - Larger blocks get their own anonymous mapping (Linux only) and grow with
+    *   mremap(MREMAP_MAYMOVE): the kernel moves page table entries and copies nothing.
+    *
+    * Whether a block is mapped depends only on its size in bytes, so deallocate and reallocate
+    * must be passed the same element count that allocated the block.
+    *
+    * allocate_at_least reports malloc_usable_size (glibc) for heap blocks and the whole last
+    * page for mapped ones.
+    *
+    * allocate_zeroed returns a zero-filled block without writing it when it can: mapped blocks
+    * are fresh anonymous pages, and calloc skips the memset for chunks it knows are fresh.
+    *
+    * @tparam T The type of objects this allocator will manage.
+    * @tparam MmapThreshold Blocks of at least this many bytes are mapped with mmap.
+    */
+    template<class T, std::size_t MmapThreshold = std::size_t(1) << 20>
+    class malloc_allocator {
+        static_assert(alignof(T) <= alignof(std::max_align_t),
+                      "malloc_allocator cannot serve over-aligned types");
+
+    public:
+        typedef T              value_type;
+        typedef T*             pointer;
+        typedef const T*       const_pointer;
+        typedef T&             reference;
+        typedef const T&       const_reference;
+        typedef std::size_t    size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type is_always_equal;
+
+        template<class U>
+        struct rebind {
+            typedef malloc_allocator<U, MmapThreshold> other;
+        };
+
+    public:
+        malloc_allocator() noexcept = default;
+
+        malloc_allocator(const malloc_allocator&) noexcept = default;
+
+        template<class U>
+        malloc_allocator(const malloc_allocator<U, MmapThreshold>&) noexcept {
+        }
+
+        ~malloc_allocator() = default;
+
+        [[nodiscard]] static size_type max_size() noexcept;
+
+        static pointer allocate(size_type n);
+
+        static allocation_result<pointer, size_type> allocate_at_least(size_type n);
+
+        static pointer allocate_zeroed(size_type n);
+
+        static void deallocate(pointer p, size_type n);
+
+        // Resizes the block at p from old_n to new_n objects. p may be null.
+        static pointer reallocate(pointer p, size_type old_n, size_type new_n);
+
+    private:
+        static bool is_mapped(size_type bytes) noexcept;
+
+        static size_type page_round(size_type bytes) noexcept;
+    };
+
+    template<class T, std::size_t MmapThreshold>
+    typename malloc_allocator<T, MmapThreshold>::size_type
+    malloc_allocator<T, MmapThreshold>::max_size() noexcept {
+        return std::numeric_limits<size_type>::max() / sizeof(value_type);
+    }
+
+    template<class T, std::size_t MmapThreshold>
+    typename malloc_allocator<T, MmapThreshold>::pointer
+    malloc_allocator<T, MmapThreshold>::allocate(size_type n) {
+        if (n > max_size()) {
+            throw std::bad_alloc();
+        }
+        const size_type bytes = n * sizeof(T);
+        void* p;
+#if LSH_HAS_MREMAP
+        if (is_mapped(bytes)) {
+            p = ::mmap(nullptr, page_round(bytes), PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) {
+                p = nullptr;
+            }
+        } else
+#endif
+        {
+            p = std::malloc(bytes);
+        }
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return static_cast<pointer>(p);
+    }
+
+    template<class T, std::size_t MmapThreshold>
+    allocation_result<typename malloc_allocator<T, MmapThreshold>::pointer,
+                      typename malloc_allocator<T, MmapThreshold>::size_type>
+    malloc_allocator<T, MmapThreshold>::allocate_at_least(size_type n) {
+        pointer p             = allocate(n);
+        const size_type bytes = n * sizeof(T);
+        size_type count       = n;
+        if (is_mapped(bytes)) {
+            count = page_round(bytes) / sizeof(T);
+        } else {
+#if defined(__GLIBC__)
+            // Stay below the threshold: the count decides how the block is freed.
+            count = ::malloc_usable_size(p) / sizeof(T);
+            count = std::min(count, (MmapThreshold - 1) / sizeof(T));
+            count = std::max(count, n);
+#endif
+        }
+        return {p, count};
+    }
+
+    template<class T, std::size_t MmapThreshold>
+    typename malloc_allocator<T, MmapThreshold>::pointer
+    malloc_allocator<T, MmapThreshold>::allocate_zeroed(size_type n) {
+        if (n > max_size()) {
+            throw std::bad_alloc();
+        }
+        if (is_mapped(n * sizeof(T))) {
+            return allocate(n);
+        }
+        void* p = std::calloc(n, sizeof(T));
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return static_cast<pointer>(p);
+    }
+
+    template<class T, std::size_t MmapThreshold>
+    void malloc_allocator<T, MmapThreshold>::deallocate(pointer p, size_type n) {
+#if LSH_HAS_MREMAP
+        if (is_mapped(n * sizeof(T))) {
+            ::munmap(p, page_round(n * sizeof(T)));
+            return;
+        }
+#endif
+        std::free(p);
+    }
+
+    template<class T, std::size_t MmapThreshold>
+    typename malloc_allocator<T, MmapThreshold>::pointer
+    malloc_allocator<T, MmapThreshold>::reallocate(pointer p, size_type old_n, size_type new_n) {
+        if (!p) {
+            return allocate(new_n);
+        }
+        if (new_n == 0) {
+            deallocate(p, old_n);
+            return nullptr;
+        }
+        if (new_n > max_size()) {
+            throw std::bad_alloc();
+        }
+        const size_type old_bytes = old_n * sizeof(T);
+        const size_type new_bytes = new_n * sizeof(T);
+        const bool old_mapped     = is_mapped(old_bytes);
+        const bool new_mapped     = is_mapped(new_bytes);
+
+        void* result;
+        if (!old_mapped && !new_mapped) {
+            result = std::realloc(static_cast<void*>(p), new_bytes);
+        }
+#if LSH_HAS_MREMAP
+        else if (old_mapped && new_mapped) {
+            result = ::mremap(p, page_round(old_bytes), page_round(new_bytes), MREMAP_MAYMOVE);
+            if (result == MAP_FAILED) {
+                result = nullptr;
+            }
+        }
+#endif
+        else {
+            // Crossing the threshold changes the kind of block, so copy once.
+            pointer q = allocate(new_n);
+            std::memcpy(static_cast<void*>(q), static_cast<const void*>(p), std::min(old_bytes, new_bytes));
+            deallocate(p, old_n);
+            return q;
+        }
+        if (!result) {
+            throw std::bad_alloc();
+        }
+        return static_cast<pointer>(result);
+    }
+
+    template<class T, std::size_t MmapThreshold>
+    bool malloc_allocator<T, MmapThreshold>::is_mapped(size_type bytes) noexcept {
+        return LSH_HAS_MREMAP && bytes >= MmapThreshold;
+    }
+
+    template<class T, std::size_t MmapThreshold>
+    typename malloc_allocator<T, MmapThreshold>::size_type
+    malloc_allocator<T, MmapThreshold>::page_round(size_type bytes) noexcept {
+#if LSH_HAS_MREMAP
+        static const size_type page = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+        return (bytes + page - 1) / page * page;
+#else
+        return bytes;
+#endif
+    }
+
+    template<class T, class U, std::size_t MmapThreshold>
+    bool operator==(const malloc_allocator<T, MmapThreshold>&, const malloc_allocator<U, MmapThreshold>&) noexcept {
+        return true;
+    }
+
+    template<class T, class U, std::size_t MmapThreshold>
+    bool operator!=(const malloc_allocator<T, MmapThreshold>&, const malloc_allocator<U, MmapThreshold>&) noexcept {
+        return false;
+    }
+}
+#endif //MALLOC_ALLOCATOR_H
@@ -0,0 +1,566 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef MEMORY_RESOURCE_H
+#define MEMORY_RESOURCE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include "allocator.h"
+#include "pool_allocator.h"
+#include "vector.h"
+
+namespace Lsh {
+    namespace pmr {
+        /**
+        * @brief Abstract interface to a source of memory, chosen at run time.
+        *
+        * Containers hold a polymorphic_allocator that points at a memory_resource, so one
+        * container instantiation serves every allocation strategy.
+        */
+        class memory_resource {
+        public:
+            virtual ~memory_resource() = default;
+
+            [[nodiscard]] void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+                return do_allocate(bytes, alignment);
+            }
+
+            void deallocate(void* p, std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+                do_deallocate(p, bytes, alignment);
+            }
+
+            // Whether memory allocated from *this can be freed through other, and vice versa.
+            bool is_equal(const memory_resource& other) const noexcept {
+                return do_is_equal(other);
+            }
+
+        private:
+            virtual void* do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+
+            virtual void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) = 0;
+
+            virtual bool do_is_equal(const memory_resource& other) const noexcept = 0;
+        };
+
+        inline bool operator==(const memory_resource& lhs, const memory_resource& rhs) noexcept {
+            return std::addressof(lhs) == std::addressof(rhs) || lhs.is_equal(rhs);
+        }
+
+        inline bool operator!=(const memory_resource& lhs, const memory_resource& rhs) noexcept {
+            return !(lhs == rhs);
+        }
+
+        // Forwards to ::operator new/delete, honouring the alignment (see aligned_operator_new).
+        class new_delete_memory_resource final : public memory_resource {
+        private:
+            void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+                return aligned_operator_new(bytes, alignment);
+            }
+
+            void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+                aligned_operator_delete(p, bytes, alignment);
+            }
+
+            bool do_is_equal(const memory_resource& other) const noexcept override {
+                return this == std::addressof(other);
+            }
+        };
+
+        // Fails every allocation; useful as the upstream of a resource that must never grow.
+        class null_memory_resource_impl final : public memory_resource {
+        private:
+            void* do_allocate(std::size_t, std::size_t) override {
+                throw std::bad_alloc();
+            }
+
+            void do_deallocate(void*, std::size_t, std::size_t) override {
+            }
+
+            bool do_is_equal(const memory_resource& other) const noexcept override {
+                return this == std::addressof(other);
+            }
+        };
+
+        // The process-wide resources are never destroyed, so containers may use them during
+        // static destruction.
+        template<class Resource>
+        memory_resource* immortal_resource() noexcept {
+            alignas(Resource) static unsigned char storage[sizeof(Resource)];
+            static Resource* resource = ::new(static_cast<void*>(storage)) Resource();
+            return resource;
+        }
+
+        inline memory_resource* new_delete_resource() noexcept {
+            return immortal_resource<new_delete_memory_resource>();
+        }
+
+        inline memory_resource* null_memory_resource() noexcept {
+            return immortal_resource<null_memory_resource_impl>();
+        }
+
+        inline std::atomic<memory_resource*>& default_resource_slot() noexcept {
+            static std::atomic<memory_resource*> slot{new_delete_resource()};
+            return slot;
+        }
+
+        inline memory_resource* get_default_resource() noexcept {
+            return default_resource_slot().load(std::memory_order_acquire);
+        }
+
+        // Installs r (new_delete_resource() if null) and returns the previous default.
+        inline memory_resource* set_default_resource(memory_resource* r) noexcept {
+            return default_resource_slot().exchange(r ? r : new_delete_resource(), std::memory_order_acq_rel);
+        }
+
+        /**
+        * @brief Bump allocation through an optional initial buffer, then upstream chunks.
+        *
+        * deallocate does nothing; release() returns every chunk to upstream and rewinds to the
+        * initial buffer. Each new chunk is twice the size of the previous one.
+        */
+        class monotonic_buffer_resource : public memory_resource {
+        public:
+            static constexpr std::size_t default_initial_size = 1024;
+
+            monotonic_buffer_resource() noexcept : monotonic_buffer_resource(get_default_resource()) {
+            }
+
+            explicit monotonic_buffer_resource(memory_resource* upstream) noexcept
+                : upstream_(upstream), next_size_(default_initial_size) {
+            }
+
+            explicit monotonic_buffer_resource(std::size_t initial_size,
+                                               memory_resource* upstream = get_default_resource()) noexcept
+                : upstream_(upstream), next_size_(initial_size ? initial_size : 1) {
+            }
+
+            monotonic_buffer_resource(void* buffer, std::size_t buffer_size,
+                                      memory_resource* upstream = get_default_resource()) noexcept
+                : upstream_(upstream), initial_buffer_(static_cast<char*>(buffer)), initial_size_(buffer_size),
+                  current_(initial_buffer_), space_(buffer_size), next_size_(buffer_size ? buffer_size * 2 : 1) {
+            }
+
+            monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+
+            monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+            ~monotonic_buffer_resource() override {
+                release();
+            }
+
+            void release() noexcept {
+                while (chunks_) {
+                    chunk_header* next = chunks_->next;
+                    upstream_->deallocate(chunks_, chunks_->size, alignof(std::max_align_t));
+                    chunks_ = next;
+                }
+                current_ = initial_buffer_;
+                space_   = initial_size_;
+            }
+
+            memory_resource* upstream_resource() const noexcept {
+                return upstream_;
+            }
+
+        private:
+            struct alignas(std::max_align_t) chunk_header {
+                chunk_header* next;
+                std::size_t size;
+            };
+
+            void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+                void* cursor = current_;
+                if (!cursor || !std::align(alignment, bytes, cursor, space_)) {
+                    new_chunk(bytes, alignment);
+                    cursor = current_;
+                    std::align(alignment, bytes, cursor, space_);
+                }
+                current_ = static_cast<char*>(cursor) + bytes;
+                space_ -= bytes;
+                return cursor;
+            }
+
+            void do_deallocate(void*, std::size_t, std::size_t) override {
+            }
+
+            bool do_is_equal(const memory_resource& other) const noexcept override {
+                return this == std::addressof(other);
+            }
+
+            void new_chunk(std::size_t bytes, std::size_t alignment) {
+                if (bytes > std::numeric_limits<std::size_t>::max() / 2 - sizeof(chunk_header) - alignment) {
+                    throw std::bad_alloc();
+                }
+                const std::size_t needed = sizeof(chunk_header) + bytes + alignment;
+                std::size_t size         = next_size_;
+                while (size < needed) {
+                    size *= 2;
+                }
+                chunk_header* chunk = static_cast<chunk_header*>(upstream_->allocate(size, alignof(std::max_align_t)));
+                chunk->next         = chunks_;
+                chunk->size         = size;
+                chunks_             = chunk;
+                current_            = reinterpret_cast<char*>(chunk + 1);
+                space_              = size - sizeof(chunk_header);
+                next_size_          = size <= std::numeric_limits<std::size_t>::max() / 2 ? size * 2 : size;
+            }
+
+            memory_resource* upstream_;
+            char* initial_buffer_ = nullptr;
+            std::size_t initial_size_ = 0;
+            char* current_ = nullptr;
+            std::size_t space_ = 0;
+            std::size_t next_size_;
+            chunk_header* chunks_ = nullptr;
+        };
+
+        /**
+        * @brief Tuning knobs for the pool resources; zero picks the default.
+        *
+        * - max_blocks_per_chunk: upper bound on how many blocks one upstream chunk holds.
+        * - largest_required_pool_block: larger requests bypass the pools and go upstream.
+        */
+        struct pool_options {
+            std::size_t max_blocks_per_chunk        = 0;
+            std::size_t largest_required_pool_block = 0;
+        };
+
+        /**
+        * @brief Size-class pools for one thread, carved from upstream chunks.
+        *
+        * - Requests up to largest_required_pool_block bytes (at most 32 KiB) with fundamental
+        *   alignment use the size classes of size_class_pool. Each class keeps a free list;
+        *   an empty list takes a new chunk from upstream, each chunk twice as large as the last
+        *   up to max_blocks_per_chunk blocks.
+        * - Other requests go upstream with a small header, so release() can return them too.
+        * - release() gives all memory back to upstream; blocks are otherwise only recycled.
+        *
+        * Not thread-safe; see synchronized_pool_resource.
+        */
+        class unsynchronized_pool_resource : public memory_resource {
+        public:
+            unsynchronized_pool_resource() : unsynchronized_pool_resource(pool_options(), get_default_resource()) {
+            }
+
+            explicit unsynchronized_pool_resource(memory_resource* upstream)
+                : unsynchronized_pool_resource(pool_options(), upstream) {
+            }
+
+            explicit unsynchronized_pool_resource(const pool_options& options,
+                                                  memory_resource* upstream = get_default_resource())
+                : upstream_(upstream), options_(normalize(options)),
+                  pool_count_(size_class_pool::class_index(options_.largest_required_pool_block) + 1) {
+            }
+
+            unsynchronized_pool_resource(const unsynchronized_pool_resource&) = delete;
+
+            unsynchronized_pool_resource& operator=(const unsynchronized_pool_resource&) = delete;
+
+            ~unsynchronized_pool_resource() override {
+                release();
+            }
+
+            void release() noexcept {
+                for (std::size_t i = 0; i < pool_count_; ++i) {
+                    pool& current = pools_[i];
+                    while (current.chunks) {
+                        chunk_header* next = current.chunks->next;
+                        upstream_->deallocate(current.chunks, current.chunks->size, alignof(std::max_align_t));
+                        current.chunks = next;
+                    }
+                    current.free       = nullptr;
+                    current.next_count = 0;
+                }
+                while (large_) {
+                    large_header* next = large_->next;
+                    upstream_->deallocate(large_->base, large_->size, large_->alignment);
+                    large_ = next;
+                }
+            }
+
+            memory_resource* upstream_resource() const noexcept {
+                return upstream_;
+            }
+
+            pool_options options() const noexcept {
+                return options_;
+            }
+
+        protected:
+            void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+                if (!uses_pool(bytes, alignment)) {
+                    return allocate_large(bytes, alignment);
+                }
+                pool& current = pools_[size_class_pool::class_index(bytes)];
+                if (!current.free) {
+                    refill(current, size_class_pool::class_index(bytes));
+                }
+                free_block* block = current.free;
+                current.free      = block->next;
+                return block;
+            }
+
+            void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+                if (!uses_pool(bytes, alignment)) {
+                    deallocate_large(p);
+                    return;
+                }
+                pool& current     = pools_[size_class_pool::class_index(bytes)];
+                free_block* block = static_cast<free_block*>(p);
+                block->next       = current.free;
+                current.free      = block;
+            }
+
+            bool do_is_equal(const memory_resource& other) const noexcept override {
+                return this == std::addressof(other);
+            }
+
+        private:
+            struct free_block {
+                free_block* next;
+            };
+
+            struct alignas(std::max_align_t) chunk_header {
+                chunk_header* next;
+                std::size_t size;
+            };
+
+            // Sits right before a large block; doubly linked so deallocate unlinks in O(1).
+            struct large_header {
+                large_header* prev;
+                large_header* next;
+                void* base;
+                std::size_t size;
+                std::size_t alignment;
+            };
+
+            struct pool {
+                free_block* free       = nullptr;
+                chunk_header* chunks   = nullptr;
+                std::size_t next_count = 0; // blocks in the next chunk
+            };
+
+            static constexpr std::size_t default_max_blocks_per_chunk = 1024;
+
+            static pool_options normalize(pool_options options) noexcept {
+                if (options.max_blocks_per_chunk == 0) {
+                    options.max_blocks_per_chunk = default_max_blocks_per_chunk;
+                }
+                if (options.largest_required_pool_block == 0 ||
+                    options.largest_required_pool_block > size_class_pool::max_small_size) {
+                    options.largest_required_pool_block = size_class_pool::max_small_size;
+                }
+                options.largest_required_pool_block = size_class_pool::good_size(options.largest_required_pool_block);
+                return options;
+            }
+
+            bool uses_pool(std::size_t bytes, std::size_t alignment) const noexcept {
+                return bytes <= options_.largest_required_pool_block && alignment <= alignof(std::max_align_t);
+            }
+
+            void refill(pool& current, std::size_t index) {
+                const std::size_t size = size_class_pool::class_size(index);
+                std::size_t count      = current.next_count ? current.next_count : 8;
+                if (count > options_.max_blocks_per_chunk) {
+                    count = options_.max_blocks_per_chunk;
+                }
+                const std::size_t bytes = sizeof(chunk_header) + count * size;
+                chunk_header* chunk     = static_cast<chunk_header*>(upstream_->allocate(bytes, alignof(std::max_align_t)));
+                chunk->next             = current.chunks;
+                chunk->size             = bytes;
+                current.chunks          = chunk;
+                char* first             = reinterpret_cast<char*>(chunk + 1);
+                for (std::size_t i = count; i-- > 0;) {
+                    free_block* block = reinterpret_cast<free_block*>(first + i * size);
+                    block->next       = current.free;
+                    current.free      = block;
+                }
+                current.next_count = count * 2;
+            }
+
+            void* allocate_large(std::size_t bytes, std::size_t alignment) {
+                if (alignment < alignof(large_header)) {
+                    alignment = alignof(large_header);
+                }
+                const std::size_t offset = (sizeof(large_header) + alignment - 1) & ~(alignment - 1);
+                if (bytes > std::numeric_limits<std::size_t>::max() - offset) {
+                    throw std::bad_alloc();
+                }
+                char* base           = static_cast<char*>(upstream_->allocate(offset + bytes, alignment));
+                large_header* header = reinterpret_cast<large_header*>(base + offset) - 1;
+                header->prev         = nullptr;
+                header->next         = large_;
+                header->base         = base;
+                header->size         = offset + bytes;
+                header->alignment    = alignment;
+                if (large_) {
+                    large_->prev = header;
+                }
+                large_ = header;
+                return base + offset;
+            }
+
+            void deallocate_large(void* p) noexcept {
+                large_header* header = static_cast<large_header*>(p) - 1;
+                if (header->prev) {
+                    header->prev->next = header->next;
+                } else {
+                    large_ = header->next;
+                }
+                if (header->next) {
+                    header->next->prev = header->prev;
+                }
+                upstream_->deallocate(header->base, header->size, header->alignment);
+            }
+
+            memory_resource* upstream_;
+            pool_options options_;
+            std::size_t pool_count_;
+            pool pools_[size_class_pool::class_count];
+            large_header* large_ = nullptr;
+        };
+
+        // unsynchronized_pool_resource behind a mutex, safe to share between threads.
+        class synchronized_pool_resource : public memory_resource {
+        public:
+            synchronized_pool_resource() = default;
+
+            explicit synchronized_pool_resource(memory_resource* upstream) : pools_(upstream) {
+            }
+
+            explicit synchronized_pool_resource(const pool_options& options,
+                                                memory_resource* upstream = get_default_resource())
+                : pools_(options, upstream) {
+            }
+
+            synchronized_pool_resource(const synchronized_pool_resource&) = delete;
+
+            synchronized_pool_resource& operator=(const synchronized_pool_resource&) = delete;
+
+            ~synchronized_pool_resource() override = default;
+
+            void release() {
+                std::lock_guard<std::mutex> guard(lock_);
+                pools_.release();
+            }
+
+            memory_resource* upstream_resource() const noexcept {
+                return pools_.upstream_resource();
+            }
+
+            pool_options options() const noexcept {
+                return pools_.options();
+            }
+
+        private:
+            void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+                std::lock_guard<std::mutex> guard(lock_);
+                return pools_.allocate(bytes, alignment);
+            }
+
+            void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+                std::lock_guard<std::mutex> guard(lock_);
+                pools_.deallocate(p, bytes, alignment);
+            }
+
+            bool do_is_equal(const memory_resource& other) const noexcept override {
+                return this == std::addressof(other);
+            }
+
+            std::mutex lock_;
+            unsynchronized_pool_resource pools_;
+        };
+
+        /**
+        * @brief An allocator that forwards to a memory_resource chosen at run time.
+        *
+        * The default constructor uses get_default_resource(). The allocator never propagates,
+        * and copy construction of a container picks the default resource again, so every
+        * container keeps the resource it was constructed with. Two allocators are equal when
+        * their resources are.
+        *
+        * @tparam T The type of objects this allocator will manage.
+        */
+        template<class T>
+        class polymorphic_allocator {
+        public:
+            typedef T              value_type;
+            typedef T*             pointer;
+            typedef const T*       const_pointer;
+            typedef T&             reference;
+            typedef const T&       const_reference;
+            typedef std::size_t    size_type;
+            typedef std::ptrdiff_t difference_type;
+
+            template<class U>
+            struct rebind {
+                typedef polymorphic_allocator<U> other;
+            };
+
+        public:
+            polymorphic_allocator() noexcept : resource_(get_default_resource()) {
+            }
+
+            polymorphic_allocator(memory_resource* resource) noexcept : resource_(resource) {
+            }
+
+            polymorphic_allocator(const polymorphic_allocator&) noexcept = default;
+
+            template<class U>
+            polymorphic_allocator(const polymorphic_allocator<U>& other) noexcept : resource_(other.resource()) {
+            }
+
+            polymorphic_allocator& operator=(const polymorphic_allocator&) = delete;
+
+            ~polymorphic_allocator() = default;
+
+            [[nodiscard]] static size_type max_size() noexcept {
+                return std::numeric_limits<size_type>::max() / sizeof(value_type);
+            }
+
+            pointer allocate(size_type n) {
+                if (n > max_size()) {
+                    throw std::bad_array_new_length();
+                }
+                return static_cast<pointer>(resource_->allocate(n * sizeof(T), alignof(T)));
+            }
+
+            void deallocate(pointer p, size_type n) {
+                resource_->deallocate(p, n * sizeof(T), alignof(T));
+            }
+
+            polymorphic_allocator select_on_container_copy_construction() const noexcept {
+                return polymorphic_allocator();
+            }
+
+            memory_resource* resource() const noexcept {
+                return resource_;
+            }
+
+        private:
+            memory_resource* resource_;
+        };
+
+        template<class T, class U>
+        bool operator==(const polymorphic_allocator<T>& lhs, const polymorphic_allocator<U>& rhs) noexcept {
+            return *lhs.resource() == *rhs.resource();
+        }
+
+        template<class T, class U>
+        bool operator!=(const polymorphic_allocator<T>& lhs, const polymorphic_allocator<U>& rhs) noexcept {
+            return !(lhs == rhs);
+        }
+
+        template<class T>
+        using vector = Lsh::vector<T, polymorphic_allocator<T>>;
+    }
+}
+#endif //MEMORY_RESOURCE_H
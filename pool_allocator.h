@@ -0,0 +1,316 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include "allocator.h"
+
+namespace Lsh {
+    /**
+    * @brief Process-wide size-class pool with per-thread caches, in the style of tcmalloc.
+    *
+    * - Requests up to max_small_size bytes are rounded to one of class_count size classes:
+    *   multiples of 16 bytes up to 128, then four classes per power of two.
+    * - Every thread owns a cache with one free list per class. allocate/deallocate only touch
+    *   that list, so the common path takes no lock.
+    * - An empty list refills a whole batch from the central list of its class under that
+    *   class's mutex; a list that grows past two batches hands one batch back the same way.
+    * - A block freed on another thread simply joins the freeing thread's cache. A remote free
+    *   costs the same as a local one, and producer/consumer imbalances flow back through the
+    *   central lists in batches.
+    * - Central lists carve new blocks out of 64 KiB chunks from ::operator new. Chunks are kept
+    *   for the lifetime of the process.
+    * - Larger requests go straight to ::operator new / ::operator delete.
+    *
+    * Blocks carry no header, so deallocate must be given the size that was allocated (or the
+    * count reported by allocate_at_least).
+    */
+    class size_class_pool {
+    public:
+        static constexpr std::size_t max_small_size = 32 * 1024;
+        static constexpr std::size_t class_count    = 40;
+
+        static void* allocate(std::size_t bytes);
+
+        static void deallocate(void* p, std::size_t bytes) noexcept;
+
+        // The number of bytes a request of `bytes` really receives.
+        static std::size_t good_size(std::size_t bytes) noexcept;
+
+        static std::size_t class_index(std::size_t bytes) noexcept;
+
+        static std::size_t class_size(std::size_t index) noexcept;
+
+    private:
+        struct free_block {
+            free_block* next;
+        };
+
+        struct free_list {
+            free_block* head   = nullptr;
+            std::size_t length = 0;
+
+            void push(void* p) noexcept {
+                free_block* block = static_cast<free_block*>(p);
+                block->next       = head;
+                head              = block;
+                ++length;
+            }
+
+            void* pop() noexcept {
+                free_block* block = head;
+                head              = block->next;
+                --length;
+                return block;
+            }
+        };
+
+        struct central_list {
+            std::mutex lock;
+            free_list blocks;
+        };
+
+        struct thread_cache {
+            free_list lists[class_count];
+
+            ~thread_cache();
+        };
+
+        static constexpr std::size_t chunk_size = 64 * 1024;
+
+        static std::size_t batch_size(std::size_t index) noexcept;
+
+        static central_list* central() noexcept;
+
+        static thread_cache* local_cache() noexcept;
+
+        static bool& cache_destroyed() noexcept;
+
+        static void fetch_batch(std::size_t index, free_list& out, std::size_t count);
+
+        static void release_batch(std::size_t index, free_list& from, std::size_t count) noexcept;
+    };
+
+    inline std::size_t size_class_pool::class_index(std::size_t bytes) noexcept {
+        if (bytes <= 128) {
+            return bytes == 0 ? 0 : (bytes - 1) / 16;
+        }
+        // bytes - 1 lies in [2^k, 2^(k+1)) with k >= 7; that range holds four classes.
+        std::size_t k = 7;
+        while ((std::size_t(2) << k) <= bytes - 1) {
+            ++k;
+        }
+        const std::size_t spacing = std::size_t(1) << (k - 2);
+        return 8 + (k - 7) * 4 + ((bytes - 1) - (std::size_t(1) << k)) / spacing;
+    }
+
+    inline std::size_t size_class_pool::class_size(std::size_t index) noexcept {
+        if (index < 8) {
+            return (index + 1) * 16;
+        }
+        const std::size_t k = (index - 8) / 4 + 7;
+        return (std::size_t(1) << k) + ((index - 8) % 4 + 1) * (std::size_t(1) << (k - 2));
+    }
+
+    inline std::size_t size_class_pool::good_size(std::size_t bytes) noexcept {
+        return bytes <= max_small_size ? class_size(class_index(bytes)) : bytes;
+    }
+
+    // Move about 64 KiB per batch, between 2 and 32 blocks.
+    inline std::size_t size_class_pool::batch_size(std::size_t index) noexcept {
+        const std::size_t count = chunk_size / class_size(index);
+        return count < 2 ? 2 : (count > 32 ? 32 : count);
+    }
+
+    // Never destroyed: thread caches may flush into it while static objects are torn down.
+    inline size_class_pool::central_list* size_class_pool::central() noexcept {
+        static central_list* lists = new central_list[class_count];
+        return lists;
+    }
+
+    inline bool& size_class_pool::cache_destroyed() noexcept {
+        thread_local bool destroyed = false;
+        return destroyed;
+    }
+
+    // Null once the calling thread's cache has been destroyed, e.g. from a later thread_local
+    // destructor; callers then fall back to the central lists.
+    inline size_class_pool::thread_cache* size_class_pool::local_cache() noexcept {
+        if (cache_destroyed()) {
+            return nullptr;
+        }
+        thread_local thread_cache cache;
+        return &cache;
+    }
+
+    inline size_class_pool::thread_cache::~thread_cache() {
+        for (std::size_t i = 0; i < class_count; ++i) {
+            release_batch(i, lists[i], lists[i].length);
+        }
+        cache_destroyed() = true;
+    }
+
+    inline void size_class_pool::fetch_batch(std::size_t index, free_list& out, std::size_t count) {
+        central_list& shared = central()[index];
+        std::lock_guard<std::mutex> guard(shared.lock);
+        if (shared.blocks.length < count) {
+            // Carve a fresh chunk; a chunk always holds at least one batch.
+            const std::size_t size = class_size(index);
+            char* chunk            = static_cast<char*>(::operator new(chunk_size));
+            for (std::size_t offset = 0; offset + size <= chunk_size; offset += size) {
+                shared.blocks.push(chunk + offset);
+            }
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            out.push(shared.blocks.pop());
+        }
+    }
+
+    inline void size_class_pool::release_batch(std::size_t index, free_list& from, std::size_t count) noexcept {
+        if (count == 0) {
+            return;
+        }
+        central_list& shared = central()[index];
+        std::lock_guard<std::mutex> guard(shared.lock);
+        for (std::size_t i = 0; i < count; ++i) {
+            shared.blocks.push(from.pop());
+        }
+    }
+
+    inline void* size_class_pool::allocate(std::size_t bytes) {
+        if (bytes > max_small_size) {
+            return ::operator new(bytes);
+        }
+        const std::size_t index = class_index(bytes);
+        thread_cache* cache     = local_cache();
+        if (!cache) {
+            free_list temp;
+            fetch_batch(index, temp, 1);
+            return temp.pop();
+        }
+        free_list& list = cache->lists[index];
+        if (!list.head) {
+            fetch_batch(index, list, batch_size(index));
+        }
+        return list.pop();
+    }
+
+    inline void size_class_pool::deallocate(void* p, std::size_t bytes) noexcept {
+        if (bytes > max_small_size) {
+            ::operator delete(p, bytes);
+            return;
+        }
+        const std::size_t index = class_index(bytes);
+        thread_cache* cache     = local_cache();
+        if (!cache) {
+            free_list temp;
+            temp.push(p);
+            release_batch(index, temp, 1);
+            return;
+        }
+        free_list& list = cache->lists[index];
+        list.push(p);
+        const std::size_t batch = batch_size(index);
+        if (list.length > 2 * batch) {
+            release_batch(index, list, batch);
+        }
+    }
+
+    /**
+    * @brief A stateless allocator drawing from size_class_pool.
+    *
+    * Drop-in replacement for Lsh::allocator for small, short-lived containers: allocation and
+    * deallocation usually touch only the calling thread's free list. allocate_at_least reports
+    * the whole size class, so a vector's capacity grows to fill it.
+    *
+    * @tparam T The type of objects this allocator will manage.
+    */
+    template<class T>
+    class pool_allocator {
+        static_assert(alignof(T) <= alignof(std::max_align_t),
+                      "pool_allocator cannot serve over-aligned types");
+
+    public:
+        typedef T              value_type;
+        typedef T*             pointer;
+        typedef const T*       const_pointer;
+        typedef T&             reference;
+        typedef const T&       const_reference;
+        typedef std::size_t    size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        // Every instance shares the same pool.
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type is_always_equal;
+
+        template<class U>
+        struct rebind {
+            typedef pool_allocator<U> other;
+        };
+
+    public:
+        pool_allocator() noexcept = default;
+
+        pool_allocator(const pool_allocator&) noexcept = default;
+
+        template<class U>
+        pool_allocator(const pool_allocator<U>&) noexcept {
+        }
+
+        ~pool_allocator() = default;
+
+        [[nodiscard]] static size_type max_size() noexcept;
+
+        static pointer allocate(size_type n);
+
+        // Allocates at least n objects; deallocate must then be passed the returned count.
+        static allocation_result<pointer, size_type> allocate_at_least(size_type n);
+
+        static void deallocate(pointer p, size_type n) noexcept;
+    };
+
+    template<class T>
+    typename pool_allocator<T>::size_type pool_allocator<T>::max_size() noexcept {
+        return std::numeric_limits<size_type>::max() / sizeof(value_type);
+    }
+
+    template<class T>
+    typename pool_allocator<T>::pointer pool_allocator<T>::allocate(size_type n) {
+        if (n > max_size()) {
+            throw std::bad_alloc();
+        }
+        return static_cast<pointer>(size_class_pool::allocate(n * sizeof(T)));
+    }
+
+    template<class T>
+    allocation_result<typename pool_allocator<T>::pointer, typename pool_allocator<T>::size_type>
+    pool_allocator<T>::allocate_at_least(size_type n) {
+        if (n < max_size()) {
+            n = size_class_pool::good_size(n * sizeof(T)) / sizeof(T);
+        }
+        return {allocate(n), n};
+    }
+
+    template<class T>
+    void pool_allocator<T>::deallocate(pointer p, size_type n) noexcept {
+        size_class_pool::deallocate(p, n * sizeof(T));
+    }
+
+    template<class T, class U>
+    bool operator==(const pool_allocator<T>&, const pool_allocator<U>&) noexcept {
+        return true;
+    }
+
+    template<class T, class U>
+    bool operator!=(const pool_allocator<T>&, const pool_allocator<U>&) noexcept {
+        return false;
+    }
+}
+#endif //POOL_ALLOCATOR_H
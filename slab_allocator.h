@@ -0,0 +1,436 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include "allocator.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#define LSH_HAS_SLAB_MMAP 1
+#else
+#define LSH_HAS_SLAB_MMAP 0
+#endif
+
+namespace Lsh {
+    /**
+    * @brief A cache of equal-size slots carved out of slab_size-aligned slabs.
+    *
+    * - Every slab starts with a header, followed by its slots. A slot's slab is found by
+    *   masking the slot's address, so slots carry no per-allocation header.
+    * - Free slots of a slab form an intrusive singly linked list threaded through the slots
+    *   themselves. Slots that were never handed out are carved lazily with a bump pointer, so
+    *   a new slab is not touched up front.
+    * - Slabs with at least one free slot sit on a partial list; allocate always takes from its
+    *   head. A full slab moves to the full list and comes back on its first deallocate.
+    * - A slab that becomes empty is kept as the single spare; any further empty slab is
+    *   returned to the OS (munmap where available, ::operator delete otherwise).
+    *
+    * Not thread-safe; slab_allocator wraps a shared cache in a mutex.
+    */
+    class slab_cache {
+    public:
+        static constexpr std::size_t min_slab_size  = 64 * 1024;
+        static constexpr std::size_t min_slab_slots = 8;
+
+        slab_cache(std::size_t slot_size, std::size_t alignment) noexcept;
+
+        slab_cache(const slab_cache&) = delete;
+
+        slab_cache& operator=(const slab_cache&) = delete;
+
+        ~slab_cache();
+
+        void* allocate() {
+            slab_header* slab = partial_;
+            if (!slab) {
+                slab = new_slab();
+            }
+            void* p;
+            if (slab->free) {
+                p          = slab->free;
+                slab->free = slab->free->next;
+            } else {
+                p = slab->bump;
+                slab->bump += slot_size_;
+            }
+            if (++slab->used == slots_per_slab_) {
+                unlink(partial_, slab);
+                push_front(full_, slab);
+            }
+            return p;
+        }
+
+        void deallocate(void* p) noexcept {
+            slab_header* slab = slab_of(p);
+            free_slot* slot   = static_cast<free_slot*>(p);
+            slot->next        = slab->free;
+            slab->free        = slot;
+            if (slab->used-- == slots_per_slab_) {
+                unlink(full_, slab);
+                push_front(partial_, slab);
+            }
+            if (slab->used == 0) {
+                retire(slab);
+            }
+        }
+
+        // Fills out[0, count); on failure every slot taken so far is returned and bad_alloc thrown.
+        template<class Pointer>
+        void allocate_bulk(Pointer* out, std::size_t count);
+
+        template<class Pointer>
+        void deallocate_bulk(const Pointer* slots, std::size_t count) noexcept {
+            for (std::size_t i = 0; i < count; ++i) {
+                deallocate(slots[i]);
+            }
+        }
+
+        std::size_t slot_size() const noexcept {
+            return slot_size_;
+        }
+
+        std::size_t slab_size() const noexcept {
+            return slab_size_;
+        }
+
+        // Slabs currently held, including the spare.
+        std::size_t slab_count() const noexcept {
+            return slab_count_;
+        }
+
+    private:
+        struct free_slot {
+            free_slot* next;
+        };
+
+        struct slab_header {
+            slab_header* prev;
+            slab_header* next;
+            free_slot* free;
+            char* bump;       // first slot never handed out
+            std::size_t used; // slots handed out
+        };
+
+        slab_header* slab_of(void* p) const noexcept {
+            return reinterpret_cast<slab_header*>(reinterpret_cast<std::uintptr_t>(p) & ~(slab_size_ - 1));
+        }
+
+        static void push_front(slab_header*& list, slab_header* slab) noexcept {
+            slab->prev = nullptr;
+            slab->next = list;
+            if (list) {
+                list->prev = slab;
+            }
+            list = slab;
+        }
+
+        static void unlink(slab_header*& list, slab_header* slab) noexcept {
+            if (slab->prev) {
+                slab->prev->next = slab->next;
+            } else {
+                list = slab->next;
+            }
+            if (slab->next) {
+                slab->next->prev = slab->prev;
+            }
+        }
+
+        void reset(slab_header* slab) noexcept {
+            slab->free = nullptr;
+            slab->bump = reinterpret_cast<char*>(slab) + first_slot_;
+            slab->used = 0;
+        }
+
+        slab_header* new_slab();
+
+        void retire(slab_header* slab) noexcept;
+
+        static void* map_slab(std::size_t size);
+
+        static void unmap_slab(void* p, std::size_t size) noexcept;
+
+        std::size_t slot_size_;
+        std::size_t first_slot_;
+        std::size_t slab_size_;
+        std::size_t slots_per_slab_;
+        slab_header* partial_ = nullptr; // slabs with a free slot
+        slab_header* full_    = nullptr; // kept so the destructor can free them
+        slab_header* spare_   = nullptr;
+        std::size_t slab_count_ = 0;
+    };
+
+    /*
+     * Slots are at least a pointer wide and a multiple of the alignment. The slab is the
+     * smallest power of two of at least min_slab_size that holds min_slab_slots slots, so
+     * large objects still share a slab with a few neighbours.
+     */
+    inline slab_cache::slab_cache(std::size_t slot_size, std::size_t alignment) noexcept {
+        if (alignment < alignof(free_slot)) {
+            alignment = alignof(free_slot);
+        }
+        if (slot_size < sizeof(free_slot)) {
+            slot_size = sizeof(free_slot);
+        }
+        slot_size_  = (slot_size + alignment - 1) & ~(alignment - 1);
+        first_slot_ = (sizeof(slab_header) + alignment - 1) & ~(alignment - 1);
+        slab_size_  = min_slab_size;
+        while (slab_size_ < first_slot_ + min_slab_slots * slot_size_) {
+            slab_size_ *= 2;
+        }
+        slots_per_slab_ = (slab_size_ - first_slot_) / slot_size_;
+    }
+
+    // Frees every slab, including slots still handed out.
+    inline slab_cache::~slab_cache() {
+        for (slab_header* list : {partial_, full_}) {
+            while (list) {
+                slab_header* next = list->next;
+                unmap_slab(list, slab_size_);
+                list = next;
+            }
+        }
+        if (spare_) {
+            unmap_slab(spare_, slab_size_);
+        }
+    }
+
+    template<class Pointer>
+    void slab_cache::allocate_bulk(Pointer* out, std::size_t count) {
+        std::size_t i = 0;
+        try {
+            for (; i < count; ++i) {
+                out[i] = static_cast<Pointer>(allocate());
+            }
+        } catch (...) {
+            deallocate_bulk(out, i);
+            throw;
+        }
+    }
+
+    inline slab_cache::slab_header* slab_cache::new_slab() {
+        slab_header* slab = spare_;
+        if (slab) {
+            spare_ = nullptr;
+        } else {
+            slab = static_cast<slab_header*>(map_slab(slab_size_));
+            ++slab_count_;
+        }
+        reset(slab);
+        push_front(partial_, slab);
+        return slab;
+    }
+
+    inline void slab_cache::retire(slab_header* slab) noexcept {
+        unlink(partial_, slab);
+        if (!spare_) {
+            spare_ = slab;
+            return;
+        }
+        unmap_slab(slab, slab_size_);
+        --slab_count_;
+    }
+
+    /*
+     * Slabs must be aligned to their size for slab_of.
+     * - With mmap, over-map by one slab and trim both ends, like huge_page_allocator::map;
+     *   munmap then gives the pages straight back to the OS.
+     * - Otherwise use the aligned ::operator new.
+     */
+    inline void* slab_cache::map_slab(std::size_t size) {
+#if LSH_HAS_SLAB_MMAP
+        void* raw = ::mmap(nullptr, size * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        const std::uintptr_t start   = reinterpret_cast<std::uintptr_t>(raw);
+        const std::uintptr_t aligned = (start + size - 1) & ~std::uintptr_t(size - 1);
+        const std::size_t head       = aligned - start;
+        const std::size_t tail       = size - head;
+        if (head) {
+            ::munmap(raw, head);
+        }
+        if (tail) {
+            ::munmap(reinterpret_cast<void*>(aligned + size), tail);
+        }
+        return reinterpret_cast<void*>(aligned);
+#else
+        return aligned_operator_new(size, size);
+#endif
+    }
+
+    inline void slab_cache::unmap_slab(void* p, std::size_t size) noexcept {
+#if LSH_HAS_SLAB_MMAP
+        ::munmap(p, size);
+#else
+        aligned_operator_delete(p, size, size);
+#endif
+    }
+
+    /**
+    * @brief The process-wide slab_cache for one slot size and alignment.
+    *
+    * Every type with the same size and alignment shares a cache. With Synchronized the cache is
+    * guarded by a mutex; without it the caller promises single-threaded use. Never destroyed,
+    * so containers with static storage duration may still free into it.
+    */
+    template<std::size_t SlotSize, std::size_t Align, bool Synchronized>
+    struct shared_slab_cache {
+        std::mutex lock;
+        slab_cache cache{SlotSize, Align};
+
+        static shared_slab_cache& instance() noexcept {
+            static shared_slab_cache* shared = new shared_slab_cache();
+            return *shared;
+        }
+
+        void* allocate() {
+            if (Synchronized) {
+                std::lock_guard<std::mutex> guard(lock);
+                return cache.allocate();
+            }
+            return cache.allocate();
+        }
+
+        void deallocate(void* p) noexcept {
+            if (Synchronized) {
+                std::lock_guard<std::mutex> guard(lock);
+                cache.deallocate(p);
+                return;
+            }
+            cache.deallocate(p);
+        }
+
+        template<class Pointer>
+        void allocate_bulk(Pointer* out, std::size_t count) {
+            if (Synchronized) {
+                std::lock_guard<std::mutex> guard(lock);
+                cache.allocate_bulk(out, count);
+                return;
+            }
+            cache.allocate_bulk(out, count);
+        }
+
+        template<class Pointer>
+        void deallocate_bulk(const Pointer* slots, std::size_t count) noexcept {
+            if (Synchronized) {
+                std::lock_guard<std::mutex> guard(lock);
+                cache.deallocate_bulk(slots, count);
+                return;
+            }
+            cache.deallocate_bulk(slots, count);
+        }
+    };
+
+    /**
+    * @brief A stateless allocator handing out single objects from a shared slab_cache.
+    *
+    * Meant for node containers and per-object allocations: allocate(1) pops a slot off a free
+    * list, with no malloc header per object. Node containers rebind it to their node type and
+    * get the cache for that node's size. Requests for more than one object (a vector's array,
+    * say) go to ::operator new like Lsh::allocator.
+    *
+    * allocate_bulk / deallocate_bulk move many single objects under one lock.
+    *
+    * @tparam T The type of objects this allocator will manage.
+    * @tparam Synchronized false drops the lock for single-threaded programs.
+    */
+    template<class T, bool Synchronized = true>
+    class slab_allocator {
+    public:
+        typedef T              value_type;
+        typedef T*             pointer;
+        typedef const T*       const_pointer;
+        typedef T&             reference;
+        typedef const T&       const_reference;
+        typedef std::size_t    size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type is_always_equal;
+
+        template<class U>
+        struct rebind {
+            typedef slab_allocator<U, Synchronized> other;
+        };
+
+    public:
+        slab_allocator() noexcept = default;
+
+        slab_allocator(const slab_allocator&) noexcept = default;
+
+        template<class U>
+        slab_allocator(const slab_allocator<U, Synchronized>&) noexcept {
+        }
+
+        ~slab_allocator() = default;
+
+        [[nodiscard]] static size_type max_size() noexcept;
+
+        static pointer allocate(size_type n);
+
+        static void deallocate(pointer p, size_type n) noexcept;
+
+        static void allocate_bulk(pointer* out, size_type count);
+
+        static void deallocate_bulk(pointer const* objects, size_type count) noexcept;
+
+    private:
+        typedef shared_slab_cache<sizeof(T), alignof(T), Synchronized> cache_type;
+    };
+
+    template<class T, bool Synchronized>
+    typename slab_allocator<T, Synchronized>::size_type slab_allocator<T, Synchronized>::max_size() noexcept {
+        return std::numeric_limits<size_type>::max() / sizeof(value_type);
+    }
+
+    template<class T, bool Synchronized>
+    typename slab_allocator<T, Synchronized>::pointer slab_allocator<T, Synchronized>::allocate(size_type n) {
+        if (n == 1) {
+            return static_cast<pointer>(cache_type::instance().allocate());
+        }
+        if (n > max_size()) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<pointer>(aligned_operator_new(n * sizeof(T), alignof(T)));
+    }
+
+    template<class T, bool Synchronized>
+    void slab_allocator<T, Synchronized>::deallocate(pointer p, size_type n) noexcept {
+        if (n == 1) {
+            cache_type::instance().deallocate(p);
+            return;
+        }
+        aligned_operator_delete(p, n * sizeof(T), alignof(T));
+    }
+
+    template<class T, bool Synchronized>
+    void slab_allocator<T, Synchronized>::allocate_bulk(pointer* out, size_type count) {
+        cache_type::instance().allocate_bulk(out, count);
+    }
+
+    template<class T, bool Synchronized>
+    void slab_allocator<T, Synchronized>::deallocate_bulk(pointer const* objects, size_type count) noexcept {
+        cache_type::instance().deallocate_bulk(objects, count);
+    }
+
+    template<class T, class U, bool Synchronized>
+    bool operator==(const slab_allocator<T, Synchronized>&, const slab_allocator<U, Synchronized>&) noexcept {
+        return true;
+    }
+
+    template<class T, class U, bool Synchronized>
+    bool operator!=(const slab_allocator<T, Synchronized>&, const slab_allocator<U, Synchronized>&) noexcept {
+        return false;
+    }
+}
+#endif //SLAB_ALLOCATOR_H
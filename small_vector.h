@@ -0,0 +1,421 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "allocator.h"
+#include "construct.h"
+#include "growth_policy.h"
+#include "vector.h"
+
+namespace Lsh {
+    /*
+     * 自带 N 个元素内联缓冲区的分配器，供 small_vector 使用
+     * -- 请求不超过 N 个元素且缓冲区空闲时直接返回缓冲区，否则交给内层分配器 Allocator
+     * -- 缓冲区是分配器对象的一部分，而 vector_impl 继承自分配器，所以缓冲区就在容器对象内部
+     * -- 拷贝分配器只拷贝内层分配器，不拷贝缓冲区；每个分配器对象只与自身相等，
+     *    因此 vector 的通用移动/交换路径不会接管另一个对象的内联缓冲区
+     */
+    template<class T, std::size_t N, class Allocator>
+    class inline_buffer_allocator : public Allocator {
+        using inner_traits = std::allocator_traits<Allocator>;
+
+    public:
+        typedef T              value_type;
+        typedef T*             pointer;
+        typedef const T*       const_pointer;
+        typedef std::size_t    size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        typedef std::false_type propagate_on_container_copy_assignment;
+        typedef std::false_type propagate_on_container_move_assignment;
+        typedef std::false_type propagate_on_container_swap;
+        typedef std::false_type is_always_equal;
+
+        template<class U>
+        struct rebind {
+            typedef inline_buffer_allocator<U, N, typename inner_traits::template rebind_alloc<U>> other;
+        };
+
+    public:
+        inline_buffer_allocator() = default;
+
+        explicit inline_buffer_allocator(const Allocator& alloc) noexcept : Allocator(alloc) {
+        }
+
+        // 只拷贝内层分配器，新对象的缓冲区是空闲的
+        inline_buffer_allocator(const inline_buffer_allocator& other) noexcept
+            : Allocator(other.inner_allocator()) {
+        }
+
+        template<class U, class OtherAllocator>
+        inline_buffer_allocator(const inline_buffer_allocator<U, N, OtherAllocator>& other) noexcept
+            : Allocator(other.inner_allocator()) {
+        }
+
+        inline_buffer_allocator& operator=(const inline_buffer_allocator&) = delete;
+
+        ~inline_buffer_allocator() = default;
+
+        pointer allocate(size_type n) {
+            if (n <= N && !in_use_) {
+                in_use_ = true;
+                return buffer();
+            }
+            return inner_traits::allocate(inner_allocator(), n);
+        }
+
+        // 使用缓冲区时容量总是 N
+        allocation_result<pointer, size_type> allocate_at_least(size_type n) {
+            if (n <= N && !in_use_) {
+                in_use_ = true;
+                return {buffer(), N};
+            }
+            return Lsh::allocate_at_least(inner_allocator(), n);
+        }
+
+        void deallocate(pointer p, size_type n) {
+            if (p == buffer()) {
+                in_use_ = false;
+                return;
+            }
+            inner_traits::deallocate(inner_allocator(), p, n);
+        }
+
+        /*
+         * 内层分配器有 reallocate 时才提供（同名函数会隐藏基类的版本）
+         * -- 缓冲区不能交给内层分配器 realloc：超出 N 时另外分配并按字节拷贝，缓冲区随即空闲
+         * -- 堆上的块直接交给内层分配器
+         */
+        template<class A = Allocator, typename = typename std::enable_if<has_reallocate<A>::value>::type>
+        pointer reallocate(pointer p, size_type old_n, size_type new_n) {
+            if (p != buffer()) {
+                return inner_allocator().reallocate(p, old_n, new_n);
+            }
+            if (new_n <= N) {
+                return p;
+            }
+            pointer result = inner_traits::allocate(inner_allocator(), new_n);
+            std::memcpy(static_cast<void*>(result), static_cast<const void*>(p), std::min(old_n, new_n) * sizeof(T));
+            in_use_ = false;
+            return result;
+        }
+
+        // 内层分配器有 allocate_zeroed 时才提供；使用缓冲区时自己清零
+        template<class A = Allocator, typename = typename std::enable_if<has_allocate_zeroed<A>::value>::type>
+        pointer allocate_zeroed(size_type n) {
+            if (n <= N && !in_use_) {
+                in_use_ = true;
+                std::memset(static_cast<void*>(buffer()), 0, n * sizeof(T));
+                return buffer();
+            }
+            return inner_allocator().allocate_zeroed(n);
+        }
+
+        [[nodiscard]] size_type max_size() const noexcept {
+            return inner_traits::max_size(inner_allocator());
+        }
+
+        // 构造与析构转交内层分配器
+        template<class U, class... Args>
+        void construct(U* p, Args&&... args) {
+            inner_traits::construct(inner_allocator(), p, std::forward<Args>(args)...);
+        }
+
+        template<class U>
+        void destroy(U* p) {
+            inner_traits::destroy(inner_allocator(), p);
+        }
+
+        inline_buffer_allocator select_on_container_copy_construction() const {
+            return inline_buffer_allocator(inner_traits::select_on_container_copy_construction(inner_allocator()));
+        }
+
+        Allocator& inner_allocator() noexcept {
+            return *this;
+        }
+
+        const Allocator& inner_allocator() const noexcept {
+            return *this;
+        }
+
+        // p 是否指向本对象的内联缓冲区
+        bool is_inline_buffer(const_pointer p) const noexcept {
+            return p == buffer();
+        }
+
+    private:
+        pointer buffer() noexcept {
+            return reinterpret_cast<pointer>(buffer_);
+        }
+
+        const_pointer buffer() const noexcept {
+            return reinterpret_cast<const_pointer>(buffer_);
+        }
+
+        alignas(T) unsigned char buffer_[N * sizeof(T)];
+        bool in_use_ = false;
+    };
+
+    template<class T, class U, std::size_t N, class A1, class A2>
+    bool operator==(const inline_buffer_allocator<T, N, A1>& lhs, const inline_buffer_allocator<U, N, A2>& rhs) noexcept {
+        return static_cast<const void*>(std::addressof(lhs)) == static_cast<const void*>(std::addressof(rhs));
+    }
+
+    template<class T, class U, std::size_t N, class A1, class A2>
+    bool operator!=(const inline_buffer_allocator<T, N, A1>& lhs, const inline_buffer_allocator<U, N, A2>& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+    // construct/destroy 只是转发，能否走快速路径取决于内层分配器
+    template<class T, std::size_t N, class Allocator>
+    struct uses_default_construct<inline_buffer_allocator<T, N, Allocator>> : uses_default_construct<Allocator> {
+    };
+
+    /*
+     * 最多 N 个元素时放在对象内部的 vector，超过 N 个才去堆上分配
+     * -- 插入、删除、扩容等逻辑全部来自 vector，区别只在分配器：
+     *    inline_buffer_allocator 把内联缓冲区当成一块容量为 N 的内存交给 vector
+     * -- 任何时候 capacity() >= N：构造完成后如果还没有内存，就先占用内联缓冲区
+     * -- 元素回到 N 个以内时 shrink_to_fit 会把它们搬回内联缓冲区
+     * -- 移动和交换：堆上的内存直接接管指针，内联的元素只能逐个搬迁（可平凡重定位的类型整体 memcpy）
+     */
+    template<class T, std::size_t N, class Allocator = allocator<T>, class GrowthPolicy = growth_2x>
+    class small_vector : public vector<T, inline_buffer_allocator<T, N, Allocator>, GrowthPolicy> {
+        static_assert(N > 0, "small_vector needs a non-empty inline buffer");
+        static_assert(!std::is_same<T, bool>::value, "small_vector<bool> is not supported, use vector<bool>");
+
+        using base         = vector<T, inline_buffer_allocator<T, N, Allocator>, GrowthPolicy>;
+        using inner_traits = std::allocator_traits<Allocator>;
+
+    public:
+        using typename base::value_type;
+        using typename base::allocator_type;
+        using typename base::pointer;
+        using typename base::const_pointer;
+        using typename base::reference;
+        using typename base::const_reference;
+        using typename base::iterator;
+        using typename base::const_iterator;
+        using typename base::reverse_iterator;
+        using typename base::const_reverse_iterator;
+        using typename base::size_type;
+        using typename base::difference_type;
+
+        // 内联缓冲区能放下的元素个数
+        static constexpr size_type inline_capacity = N;
+
+    public:
+        //===============================构造函数==============================
+        small_vector() {
+            init_inline();
+        }
+
+        explicit small_vector(const Allocator& alloc) : base(allocator_type(alloc)) {
+            init_inline();
+        }
+
+        explicit small_vector(size_type count, const Allocator& alloc = Allocator())
+            : base(count, allocator_type(alloc)) {
+            init_inline();
+        }
+
+        small_vector(size_type count, default_init_t, const Allocator& alloc = Allocator())
+            : base(count, default_init, allocator_type(alloc)) {
+            init_inline();
+        }
+
+        small_vector(size_type count, const_reference value, const Allocator& alloc = Allocator())
+            : base(count, value, allocator_type(alloc)) {
+            init_inline();
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        small_vector(InputIterator first, InputIterator last, const Allocator& alloc = Allocator())
+            : base(first, last, allocator_type(alloc)) {
+            init_inline();
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        small_vector(InputIterator first, InputIterator last, size_type count_hint,
+                     const Allocator& alloc = Allocator())
+            : base(first, last, count_hint, allocator_type(alloc)) {
+            init_inline();
+        }
+
+        small_vector(std::initializer_list<T> init, const Allocator& alloc = Allocator())
+            : base(init, allocator_type(alloc)) {
+            init_inline();
+        }
+
+        small_vector(const small_vector& other) : base(other) {
+            init_inline();
+        }
+
+        // other 在堆上时直接接管指针，否则把元素搬到自己的内联缓冲区；other 最终为空
+        small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+            : base(allocator_type(other.get_alloc().inner_allocator())) {
+            init_inline();
+            take_elements(other);
+        }
+
+        ~small_vector() = default;
+
+        //===============================赋值运算符==============================
+        small_vector& operator=(const small_vector& other) {
+            base::operator=(other);
+            return *this;
+        }
+
+        /*
+         * -- other 在堆上并且内层分配器相等：释放自己的内存后接管 other 的指针
+         * -- 否则逐个移动赋值，已有的内存可以复用
+         */
+        small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible<T>::value &&
+                                                               std::is_nothrow_move_assignable<T>::value) {
+            if (std::addressof(other) != this) {
+                if (!other.is_inline() && inner_equal(other)) {
+                    this->clear();
+                    release_heap();
+                    take_elements(other);
+                } else {
+                    this->assign(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+                    other.clear();
+                }
+            }
+            return *this;
+        }
+
+        small_vector& operator=(std::initializer_list<value_type> ilist) {
+            base::operator=(ilist);
+            return *this;
+        }
+
+        //==================================== 容量 ================================
+        // 元素是否存放在内联缓冲区中
+        [[nodiscard]] bool is_inline() const noexcept {
+            return get_alloc().is_inline_buffer(this->impl_.start_);
+        }
+
+        /*
+         * 内联时容量就是 N，没有可以归还的内存
+         * -- 在堆上且不超过 N 个元素时搬回内联缓冲区；不走 reallocate，否则容量会变成 size() 而小于 N
+         */
+        void shrink_to_fit() {
+            if (is_inline()) {
+                return;
+            }
+            if (this->size() <= N) {
+                pointer old_start       = this->impl_.start_;
+                pointer old_finish      = this->impl_.finish_;
+                const size_type old_cap = this->capacity();
+                reset_to_inline();
+                this->impl_.finish_ = relocate_a(old_start, old_finish, this->impl_.start_, get_alloc());
+                get_alloc().deallocate(old_start, old_cap);
+            } else {
+                base::shrink_to_fit();
+            }
+        }
+
+        //====================================== swap ============================================
+        // 两边都在堆上时只交换指针，否则借助移动完成
+        void swap(small_vector& other) noexcept(std::is_nothrow_move_constructible<T>::value &&
+                                                std::is_nothrow_move_assignable<T>::value) {
+            if (std::addressof(other) == this) {
+                return;
+            }
+            if (!is_inline() && !other.is_inline()) {
+                base::swap(other);
+            } else {
+                small_vector temp(std::move(other));
+                other = std::move(*this);
+                *this = std::move(temp);
+            }
+        }
+
+        // 内联时元素就在对象内部，只能就地析构；在堆上时把内存连同内层分配器交出去
+        template<class Reclaimer>
+        void release_to(Reclaimer& reclaimer) {
+            if (is_inline()) {
+                this->clear();
+                return;
+            }
+            reclaimer.adopt(get_alloc().inner_allocator(), this->impl_.start_, this->impl_.finish_,
+                            this->capacity());
+            reset_to_inline();
+        }
+
+    private:
+        allocator_type& get_alloc() noexcept {
+            return this->impl_;
+        }
+
+        const allocator_type& get_alloc() const noexcept {
+            return this->impl_;
+        }
+
+        bool inner_equal(const small_vector& other) const noexcept {
+            return inner_traits::is_always_equal::value ||
+                   get_alloc().inner_allocator() == other.get_alloc().inner_allocator();
+        }
+
+        // 还没有内存时占用内联缓冲区，保证 capacity() >= N
+        void init_inline() {
+            if (!this->impl_.start_) {
+                reset_to_inline();
+            }
+        }
+
+        // 指针改为指向空的内联缓冲区；调用前必须已经不再持有任何内存
+        void reset_to_inline() noexcept {
+            const auto storage          = get_alloc().allocate_at_least(N);
+            this->impl_.start_          = storage.ptr;
+            this->impl_.finish_         = storage.ptr;
+            this->impl_.end_of_storage_ = storage.ptr + storage.count;
+        }
+
+        // 堆上的内存归还给内层分配器，并回到内联缓冲区；调用前元素必须已经析构
+        void release_heap() noexcept {
+            if (!is_inline()) {
+                get_alloc().deallocate(this->impl_.start_, this->capacity());
+                reset_to_inline();
+            }
+        }
+
+        /*
+         * 把 other 的元素转移过来，要求 *this 为空且位于内联缓冲区，两边内层分配器相等
+         * -- other 在堆上：交还自己的内联缓冲区，接管 other 的三个指针，other 回到内联状态
+         * -- other 内联：元素重定位到自己的内联缓冲区（最多 N 个，放得下）
+         */
+        void take_elements(small_vector& other) {
+            if (other.is_inline()) {
+                this->impl_.finish_ = relocate_a(other.impl_.start_, other.impl_.finish_,
+                                                 this->impl_.start_, get_alloc());
+                other.impl_.finish_ = other.impl_.start_;
+            } else {
+                get_alloc().deallocate(this->impl_.start_, N);
+                this->impl_.start_          = other.impl_.start_;
+                this->impl_.finish_         = other.impl_.finish_;
+                this->impl_.end_of_storage_ = other.impl_.end_of_storage_;
+                other.reset_to_inline();
+            }
+        }
+    };
+
+    template<class T, std::size_t N, class Allocator, class GrowthPolicy>
+    void swap(small_vector<T, N, Allocator, GrowthPolicy>& lhs,
+              small_vector<T, N, Allocator, GrowthPolicy>& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+        lhs.swap(rhs);
+    }
+}
+#endif //SMALL_VECTOR_H
@@ -0,0 +1,625 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef STATIC_VECTOR_H
+#define STATIC_VECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "construct.h"
+
+namespace Lsh {
+    /*
+     * static_vector 的存储：能放 N 个元素的内联字节数组和元素个数
+     * -- T 可平凡拷贝时拷贝、移动、析构都由编译器生成且是平凡的，static_vector 本身也可平凡拷贝，
+     *    可以直接 memcpy、放进共享内存或报文缓冲区（拷贝整个数组，包括未使用的部分）
+     * -- 其他 T 使用下面的特化版本，逐个元素地拷贝、移动和析构
+     */
+    template<class T, std::size_t N, bool = std::is_trivially_copyable<T>::value>
+    struct static_vector_storage {
+        T* data() noexcept {
+            return reinterpret_cast<T*>(bytes_);
+        }
+
+        const T* data() const noexcept {
+            return reinterpret_cast<const T*>(bytes_);
+        }
+
+        alignas(T) unsigned char bytes_[(N == 0 ? 1 : N) * sizeof(T)];
+        std::size_t size_{0};
+    };
+
+    template<class T, std::size_t N>
+    struct static_vector_storage<T, N, false> {
+        static_vector_storage() noexcept {
+        }
+
+        static_vector_storage(const static_vector_storage& other) {
+            std::uninitialized_copy(other.data(), other.data() + other.size_, data());
+            size_ = other.size_;
+        }
+
+        // 被移动的对象保留原来的元素个数，元素处于被移动后的状态
+        static_vector_storage(static_vector_storage&& other) noexcept(std::is_nothrow_move_constructible<T>::value) {
+            std::uninitialized_move(other.data(), other.data() + other.size_, data());
+            size_ = other.size_;
+        }
+
+        ~static_vector_storage() {
+            Lsh::destroy(data(), data() + size_);
+        }
+
+        static_vector_storage& operator=(const static_vector_storage& other) {
+            if (this != std::addressof(other)) {
+                assign_elements(other.data(), other.size_);
+            }
+            return *this;
+        }
+
+        static_vector_storage& operator=(static_vector_storage&& other) noexcept(
+            std::is_nothrow_move_assignable<T>::value && std::is_nothrow_move_constructible<T>::value) {
+            if (this != std::addressof(other)) {
+                assign_elements(std::make_move_iterator(other.data()), other.size_);
+            }
+            return *this;
+        }
+
+        T* data() noexcept {
+            return reinterpret_cast<T*>(bytes_);
+        }
+
+        const T* data() const noexcept {
+            return reinterpret_cast<const T*>(bytes_);
+        }
+
+        // 前 min(size_, count) 个元素赋值，多出的部分构造或析构
+        template<class InputIterator>
+        void assign_elements(InputIterator first, std::size_t count) {
+            const std::size_t common = std::min(size_, count);
+            std::copy_n(first, common, data());
+            std::advance(first, common);
+            if (count > size_) {
+                std::uninitialized_copy_n(first, count - size_, data() + size_);
+            } else {
+                Lsh::destroy(data() + count, data() + size_);
+            }
+            size_ = count;
+        }
+
+        alignas(T) unsigned char bytes_[(N == 0 ? 1 : N) * sizeof(T)];
+        std::size_t size_{0};
+    };
+
+    /*
+     *  [0 1 2 3 . . . .]  size
+     *   |       |       |
+     *  data    end    data + N
+     *
+     * -- 元素放在对象内部的定长数组里，整个生命周期不申请任何堆内存，适合实时线程和报文解析
+     * -- 接口与 vector 相同（迭代器是原始指针），另有 full()/available()/try_push_back()
+     * -- 元素个数超过 N 时抛出 std::length_error，容器内容不变；try_push_back/try_emplace_back
+     *    在满时返回 nullptr，不抛出异常
+     * -- 可平凡搬迁的元素插入、删除时整段 memmove，与 vector 相同
+     */
+    template<class T, std::size_t N>
+    class static_vector {
+    public:
+        using value_type             = T;
+        using pointer                = T*;
+        using const_pointer          = const T*;
+        using reference              = T&;
+        using const_reference        = const T&;
+        using iterator               = T*;
+        using const_iterator         = const T*;
+        using reverse_iterator       = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+        using size_type              = std::size_t;
+        using difference_type        = std::ptrdiff_t;
+
+    private:
+        using use_memmove = is_trivially_relocatable<T>;
+
+        static_vector_storage<T, N> impl_;
+
+    public:
+        //===============================构造函数==============================
+        // 拷贝、移动、赋值和析构由 static_vector_storage 决定
+        static_vector() noexcept = default;
+
+        explicit static_vector(size_type count) {
+            check_init_len(count);
+            std::uninitialized_value_construct_n(impl_.data(), count);
+            impl_.size_ = count;
+        }
+
+        // 元素默认初始化，平凡类型不清零
+        static_vector(size_type count, default_init_t) {
+            check_init_len(count);
+            std::uninitialized_default_construct_n(impl_.data(), count);
+            impl_.size_ = count;
+        }
+
+        static_vector(size_type count, const value_type& value) {
+            check_init_len(count);
+            std::uninitialized_fill_n(impl_.data(), count, value);
+            impl_.size_ = count;
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        static_vector(InputIterator first, InputIterator last) {
+            range_append(first, last, std::__iterator_category(first), "static_vector::static_vector");
+        }
+
+        static_vector(std::initializer_list<T> init) {
+            range_append(init.begin(), init.end(), std::random_access_iterator_tag(), "static_vector::static_vector");
+        }
+
+        //============================ operator= ==================================
+        static_vector& operator=(std::initializer_list<value_type> ilist) {
+            assign(ilist.begin(), ilist.end());
+            return *this;
+        }
+
+        //=============================== assign ===============================
+        void assign(size_type count, const value_type& value) {
+            check_init_len(count);
+            // 先赋值再析构多余的元素，value 引用自身元素时也安全
+            const size_type common = std::min(size(), count);
+            std::fill_n(begin(), common, value);
+            if (count > size()) {
+                std::uninitialized_fill_n(end(), count - size(), value);
+                impl_.size_ = count;
+            } else {
+                erase_at_end(begin() + count);
+            }
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        void assign(InputIterator first, InputIterator last) {
+            range_assign(first, last, std::__iterator_category(first));
+        }
+
+        void assign(std::initializer_list<value_type> ilist) {
+            assign(ilist.begin(), ilist.end());
+        }
+
+        //================================ 元素访问 =================================
+        reference at(size_type index) {
+            if (index >= size()) {
+                throw std::out_of_range("static_vector::at");
+            }
+            return impl_.data()[index];
+        }
+
+        const_reference at(size_type index) const {
+            if (index >= size()) {
+                throw std::out_of_range("static_vector::at");
+            }
+            return impl_.data()[index];
+        }
+
+        reference operator[](size_type index) {
+            return impl_.data()[index];
+        }
+
+        const_reference operator[](size_type index) const {
+            return impl_.data()[index];
+        }
+
+        reference front() {
+            return impl_.data()[0];
+        }
+
+        const_reference front() const {
+            return impl_.data()[0];
+        }
+
+        reference back() {
+            return impl_.data()[impl_.size_ - 1];
+        }
+
+        const_reference back() const {
+            return impl_.data()[impl_.size_ - 1];
+        }
+
+        T* data() noexcept {
+            return impl_.data();
+        }
+
+        const T* data() const noexcept {
+            return impl_.data();
+        }
+
+        //================================ 迭代器 ==================================
+        iterator begin() noexcept {
+            return impl_.data();
+        }
+
+        const_iterator begin() const noexcept {
+            return impl_.data();
+        }
+
+        const_iterator cbegin() const noexcept {
+            return impl_.data();
+        }
+
+        iterator end() noexcept {
+            return impl_.data() + impl_.size_;
+        }
+
+        const_iterator end() const noexcept {
+            return impl_.data() + impl_.size_;
+        }
+
+        const_iterator cend() const noexcept {
+            return impl_.data() + impl_.size_;
+        }
+
+        reverse_iterator rbegin() noexcept {
+            return reverse_iterator(end());
+        }
+
+        const_reverse_iterator rbegin() const noexcept {
+            return const_reverse_iterator(end());
+        }
+
+        const_reverse_iterator crbegin() const noexcept {
+            return const_reverse_iterator(end());
+        }
+
+        reverse_iterator rend() noexcept {
+            return reverse_iterator(begin());
+        }
+
+        const_reverse_iterator rend() const noexcept {
+            return const_reverse_iterator(begin());
+        }
+
+        const_reverse_iterator crend() const noexcept {
+            return const_reverse_iterator(begin());
+        }
+
+        //================================ 容量 ====================================
+        [[nodiscard]] bool empty() const noexcept {
+            return impl_.size_ == 0;
+        }
+
+        bool full() const noexcept {
+            return impl_.size_ == N;
+        }
+
+        size_type size() const noexcept {
+            return impl_.size_;
+        }
+
+        static constexpr size_type max_size() noexcept {
+            return N;
+        }
+
+        static constexpr size_type capacity() noexcept {
+            return N;
+        }
+
+        // 还能放入多少个元素
+        size_type available() const noexcept {
+            return N - impl_.size_;
+        }
+
+        // 容量固定，只检查 new_cap 不超过 N，便于与 vector 写同一份代码
+        void reserve(size_type new_cap) {
+            if (new_cap > N) {
+                throw std::length_error("static_vector::reserve");
+            }
+        }
+
+        void shrink_to_fit() noexcept {
+        }
+
+        //================================ 修改器 ==================================
+        void clear() noexcept {
+            erase_at_end(begin());
+        }
+
+        iterator insert(const_iterator pos, const value_type& value) {
+            return emplace(pos, value);
+        }
+
+        iterator insert(const_iterator pos, value_type&& value) {
+            return emplace(pos, std::move(value));
+        }
+
+        // 先在末尾构造，再旋转到 pos；构造抛出异常时容器不变
+        iterator insert(const_iterator pos, size_type count, const value_type& value) {
+            const size_type offset = pos - cbegin();
+            check_space(count, "static_vector::insert");
+            std::uninitialized_fill_n(end(), count, value);
+            impl_.size_ += count;
+            std::rotate(begin() + offset, end() - count, end());
+            return begin() + offset;
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        iterator insert(const_iterator pos, InputIterator first, InputIterator last) {
+            const size_type offset   = pos - cbegin();
+            const size_type old_size = size();
+            range_append(first, last, std::__iterator_category(first), "static_vector::insert");
+            std::rotate(begin() + offset, begin() + old_size, end());
+            return begin() + offset;
+        }
+
+        iterator insert(const_iterator pos, std::initializer_list<value_type> ilist) {
+            return insert(pos, ilist.begin(), ilist.end());
+        }
+
+        template<class... Args>
+        iterator emplace(const_iterator pos, Args&&... args) {
+            const size_type offset = pos - cbegin();
+            check_space(1, "static_vector::emplace");
+            if (offset == size()) {
+                Lsh::construct(end(), std::forward<Args>(args)...);
+                ++impl_.size_;
+            } else {
+                insert_aux(use_memmove(), begin() + offset, std::forward<Args>(args)...);
+            }
+            return begin() + offset;
+        }
+
+        template<class... Args>
+        reference emplace_back(Args&&... args) {
+            check_space(1, "static_vector::emplace_back");
+            Lsh::construct(end(), std::forward<Args>(args)...);
+            ++impl_.size_;
+            return back();
+        }
+
+        // 满时不构造，返回 nullptr；否则返回新元素的地址
+        template<class... Args>
+        pointer try_emplace_back(Args&&... args) {
+            if (full()) {
+                return nullptr;
+            }
+            pointer p = end();
+            Lsh::construct(p, std::forward<Args>(args)...);
+            ++impl_.size_;
+            return p;
+        }
+
+        void push_back(const value_type& value) {
+            emplace_back(value);
+        }
+
+        void push_back(value_type&& value) {
+            emplace_back(std::move(value));
+        }
+
+        pointer try_push_back(const value_type& value) {
+            return try_emplace_back(value);
+        }
+
+        pointer try_push_back(value_type&& value) {
+            return try_emplace_back(std::move(value));
+        }
+
+        void pop_back() {
+            --impl_.size_;
+            Lsh::destroy(end());
+        }
+
+        iterator erase(const_iterator pos) {
+            iterator first = begin() + (pos - cbegin());
+            erase_aux(first, first + 1, use_memmove());
+            return first;
+        }
+
+        iterator erase(const_iterator first, const_iterator last) {
+            iterator first_ = begin() + (first - cbegin());
+            iterator last_  = begin() + (last - cbegin());
+            if (first_ != last_) {
+                erase_aux(first_, last_, use_memmove());
+            }
+            return first_;
+        }
+
+        void resize(size_type new_size) {
+            check_init_len(new_size);
+            if (new_size > size()) {
+                std::uninitialized_value_construct_n(end(), new_size - size());
+                impl_.size_ = new_size;
+            } else {
+                erase_at_end(begin() + new_size);
+            }
+        }
+
+        // 新增的元素默认初始化，平凡类型不清零
+        void resize(size_type new_size, default_init_t) {
+            check_init_len(new_size);
+            if (new_size > size()) {
+                std::uninitialized_default_construct_n(end(), new_size - size());
+                impl_.size_ = new_size;
+            } else {
+                erase_at_end(begin() + new_size);
+            }
+        }
+
+        void resize(size_type new_size, const value_type& value) {
+            check_init_len(new_size);
+            if (new_size > size()) {
+                std::uninitialized_fill_n(end(), new_size - size(), value);
+                impl_.size_ = new_size;
+            } else {
+                erase_at_end(begin() + new_size);
+            }
+        }
+
+        // 元素在两个对象之间逐个交换，较长一方多出的元素移动过去，O(size)
+        void swap(static_vector& other) noexcept(std::is_nothrow_swappable<T>::value &&
+                                                 std::is_nothrow_move_constructible<T>::value) {
+            static_vector& shorter = size() < other.size() ? *this : other;
+            static_vector& longer  = size() < other.size() ? other : *this;
+            const size_type common = shorter.size();
+            std::swap_ranges(shorter.begin(), shorter.begin() + common, longer.begin());
+            std::uninitialized_move(longer.begin() + common, longer.end(), shorter.end());
+            shorter.impl_.size_ = longer.size();
+            longer.erase_at_end(longer.begin() + common);
+        }
+
+    private:
+        //================================ 工具函数 ================================
+        static void check_init_len(size_type count) {
+            if (count > N) {
+                throw std::length_error("static_vector size is greater than capacity()");
+            }
+        }
+
+        // 再放入 count 个元素会超过 N 时抛出异常
+        void check_space(size_type count, const char* s) const {
+            if (N - size() < count) {
+                throw std::length_error(s);
+            }
+        }
+
+        void erase_at_end(pointer position) noexcept {
+            Lsh::destroy(position, end());
+            impl_.size_ = position - begin();
+        }
+
+        // 在末尾依次构造 [first,last) 的元素；超出容量或构造抛出异常时析构已追加的元素
+        template<class InputIterator>
+        void range_append(InputIterator first, InputIterator last, std::input_iterator_tag, const char* s) {
+            const size_type old_size = size();
+            try {
+                for (; first != last; ++first) {
+                    check_space(1, s);
+                    Lsh::construct(end(), *first);
+                    ++impl_.size_;
+                }
+            } catch (...) {
+                erase_at_end(begin() + old_size);
+                throw;
+            }
+        }
+
+        template<class ForwardIterator>
+        void range_append(ForwardIterator first, ForwardIterator last, std::forward_iterator_tag, const char* s) {
+            const size_type count = std::distance(first, last);
+            check_space(count, s);
+            std::uninitialized_copy(first, last, end());
+            impl_.size_ += count;
+        }
+
+        template<class InputIterator>
+        void range_assign(InputIterator first, InputIterator last, std::input_iterator_tag) {
+            iterator cur = begin();
+            for (; first != last && cur != end(); ++cur, ++first) {
+                *cur = *first;
+            }
+            if (first == last) {
+                erase_at_end(cur);
+            } else {
+                range_append(first, last, std::input_iterator_tag(), "static_vector::assign");
+            }
+        }
+
+        // 长度超过 N 时不修改任何元素
+        template<class ForwardIterator>
+        void range_assign(ForwardIterator first, ForwardIterator last, std::forward_iterator_tag) {
+            const size_type count = std::distance(first, last);
+            check_init_len(count);
+            if (count <= size()) {
+                erase_at_end(std::copy(first, last, begin()));
+            } else {
+                ForwardIterator mid = first;
+                std::advance(mid, size());
+                std::copy(first, mid, begin());
+                std::uninitialized_copy(mid, last, end());
+                impl_.size_ = count;
+            }
+        }
+
+        /*
+         * 可按字节搬迁的元素：
+         * -- 新元素先构造在临时空间（参数可能引用自身的元素），再 memmove 把 [position,end) 后移一位，
+         *    最后按字节放进 position
+         */
+        template<class... Args>
+        void insert_aux(std::true_type, iterator position, Args&&... args) {
+            alignas(T) unsigned char temp[sizeof(T)];
+            pointer value = reinterpret_cast<pointer>(temp);
+            Lsh::construct(value, std::forward<Args>(args)...);
+            std::memmove(static_cast<void*>(position + 1), static_cast<const void*>(position),
+                         (end() - position) * sizeof(T));
+            std::memcpy(static_cast<void*>(position), static_cast<const void*>(value), sizeof(T));
+            ++impl_.size_;
+        }
+
+        // 其他元素：用最后一个元素移动构造出新的末尾，其余倒序移动赋值后移一位，再把临时对象移动赋值到 position
+        template<class... Args>
+        void insert_aux(std::false_type, iterator position, Args&&... args) {
+            T temp(std::forward<Args>(args)...);
+            pointer old_end = end();
+            Lsh::construct(old_end, std::move(*(old_end - 1)));
+            ++impl_.size_;
+            std::move_backward(position, old_end - 1, old_end);
+            *position = std::move(temp);
+        }
+
+        // 删除 [first,last)：后半段整体 memmove 到 first
+        void erase_aux(pointer first, pointer last, std::true_type) {
+            Lsh::destroy(first, last);
+            std::memmove(static_cast<void*>(first), static_cast<const void*>(last), (end() - last) * sizeof(T));
+            impl_.size_ -= (last - first);
+        }
+
+        // 删除 [first,last)：后半段依次移动赋值到 first，再析构末尾多出的元素
+        void erase_aux(pointer first, pointer last, std::false_type) {
+            erase_at_end(std::move(last, end(), first));
+        }
+    };
+
+    //==================================== 非成员函数 ==========================
+    template<class T, std::size_t N>
+    bool operator==(const static_vector<T, N>& lhs, const static_vector<T, N>& rhs) {
+        return (lhs.size() == rhs.size()) &&
+               std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+
+    template<class T, std::size_t N>
+    bool operator!=(const static_vector<T, N>& lhs, const static_vector<T, N>& rhs) {
+        return !(lhs == rhs);
+    }
+
+    template<class T, std::size_t N>
+    bool operator<(const static_vector<T, N>& lhs, const static_vector<T, N>& rhs) {
+        return std::lexicographical_compare(lhs.begin(), lhs.end(),
+                                            rhs.begin(), rhs.end());
+    }
+
+    template<class T, std::size_t N>
+    bool operator<=(const static_vector<T, N>& lhs, const static_vector<T, N>& rhs) {
+        return !(rhs < lhs);
+    }
+
+    template<class T, std::size_t N>
+    bool operator>(const static_vector<T, N>& lhs, const static_vector<T, N>& rhs) {
+        return rhs < lhs;
+    }
+
+    template<class T, std::size_t N>
+    bool operator>=(const static_vector<T, N>& lhs, const static_vector<T, N>& rhs) {
+        return !(lhs < rhs);
+    }
+
+    template<class T, std::size_t N>
+    void swap(static_vector<T, N>& lhs, static_vector<T, N>& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+        lhs.swap(rhs);
+    }
+}
+#endif //STATIC_VECTOR_H
@@ -0,0 +1,360 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef STATS_ALLOCATOR_H
+#define STATS_ALLOCATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include "allocator.h"
+#include "construct.h"
+
+namespace Lsh {
+    /**
+    * @brief A copy of one tag's counters at a point in time.
+    *
+    * Histogram bucket i counts requests whose byte size (or latency in nanoseconds) has
+    * bit width i, i.e. lies in [2^(i-1), 2^i); bucket 0 holds zero-sized requests.
+    */
+    struct allocation_snapshot {
+        static constexpr std::size_t size_buckets    = 65;
+        static constexpr std::size_t latency_buckets = 32;
+
+        const char* tag;
+        std::uint64_t allocations;
+        std::uint64_t deallocations;
+        std::uint64_t bytes_allocated; // cumulative
+        std::uint64_t bytes_live;
+        std::uint64_t peak_bytes;
+        std::uint64_t size_histogram[size_buckets];
+        std::uint64_t latency_histogram[latency_buckets]; // all zero unless latency is tracked
+    };
+
+    /**
+    * @brief Live counters for one tag, updated with relaxed atomics.
+    *
+    * Each tag gets its own cache-line-aligned instance, so subsystems do not contend with each
+    * other. Counters are individually exact; a snapshot taken during concurrent updates may mix
+    * values from slightly different moments.
+    */
+    class alignas(64) allocation_stats {
+    public:
+        explicit allocation_stats(const char* tag) noexcept : tag_(tag) {
+        }
+
+        allocation_stats(const allocation_stats&) = delete;
+
+        allocation_stats& operator=(const allocation_stats&) = delete;
+
+        void record_allocate(std::size_t bytes) noexcept {
+            allocations_.fetch_add(1, std::memory_order_relaxed);
+            bytes_allocated_.fetch_add(bytes, std::memory_order_relaxed);
+            size_histogram_[bit_width(bytes)].fetch_add(1, std::memory_order_relaxed);
+            const std::uint64_t live = bytes_live_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            std::uint64_t peak       = peak_bytes_.load(std::memory_order_relaxed);
+            while (peak < live && !peak_bytes_.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+            }
+        }
+
+        void record_deallocate(std::size_t bytes) noexcept {
+            deallocations_.fetch_add(1, std::memory_order_relaxed);
+            bytes_live_.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+
+        void record_latency(std::uint64_t nanoseconds) noexcept {
+            std::size_t bucket = bit_width(nanoseconds);
+            if (bucket >= allocation_snapshot::latency_buckets) {
+                bucket = allocation_snapshot::latency_buckets - 1;
+            }
+            latency_histogram_[bucket].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        allocation_snapshot snapshot() const noexcept {
+            allocation_snapshot result{};
+            result.tag             = tag_;
+            result.allocations     = allocations_.load(std::memory_order_relaxed);
+            result.deallocations   = deallocations_.load(std::memory_order_relaxed);
+            result.bytes_allocated = bytes_allocated_.load(std::memory_order_relaxed);
+            result.bytes_live      = bytes_live_.load(std::memory_order_relaxed);
+            result.peak_bytes      = peak_bytes_.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < allocation_snapshot::size_buckets; ++i) {
+                result.size_histogram[i] = size_histogram_[i].load(std::memory_order_relaxed);
+            }
+            for (std::size_t i = 0; i < allocation_snapshot::latency_buckets; ++i) {
+                result.latency_histogram[i] = latency_histogram_[i].load(std::memory_order_relaxed);
+            }
+            return result;
+        }
+
+    private:
+        friend class stats_registry;
+
+        static std::size_t bit_width(std::uint64_t value) noexcept {
+            std::size_t width = 0;
+            while (value) {
+                value >>= 1;
+                ++width;
+            }
+            return width;
+        }
+
+        const char* tag_;
+        allocation_stats* next_ = nullptr; // registry list, guarded by the registry mutex
+        std::atomic<std::uint64_t> allocations_{0};
+        std::atomic<std::uint64_t> deallocations_{0};
+        std::atomic<std::uint64_t> bytes_allocated_{0};
+        std::atomic<std::uint64_t> bytes_live_{0};
+        std::atomic<std::uint64_t> peak_bytes_{0};
+        std::atomic<std::uint64_t> size_histogram_[allocation_snapshot::size_buckets]{};
+        std::atomic<std::uint64_t> latency_histogram_[allocation_snapshot::latency_buckets]{};
+    };
+
+    /**
+    * @brief Process-wide list of every tag's allocation_stats.
+    *
+    * A tag registers itself the first time an allocator with that tag is used. for_each visits
+    * a snapshot of every registered tag; dump prints them, one line per tag followed by the
+    * non-empty histogram buckets.
+    */
+    class stats_registry {
+    public:
+        static void add(allocation_stats* stats) noexcept {
+            std::lock_guard<std::mutex> guard(lock());
+            stats->next_ = head();
+            head()       = stats;
+        }
+
+        template<class Visitor>
+        static void for_each(Visitor&& visitor) {
+            std::lock_guard<std::mutex> guard(lock());
+            for (allocation_stats* stats = head(); stats; stats = stats->next_) {
+                visitor(stats->snapshot());
+            }
+        }
+
+        static void dump(std::ostream& out) {
+            for_each([&out](const allocation_snapshot& s) {
+                out << s.tag << ": allocations=" << s.allocations << " deallocations=" << s.deallocations
+                    << " bytes_allocated=" << s.bytes_allocated << " bytes_live=" << s.bytes_live
+                    << " peak_bytes=" << s.peak_bytes << '\n';
+                for (std::size_t i = 0; i < allocation_snapshot::size_buckets; ++i) {
+                    if (s.size_histogram[i]) {
+                        out << "  size < 2^" << i << " bytes: " << s.size_histogram[i] << '\n';
+                    }
+                }
+                for (std::size_t i = 0; i < allocation_snapshot::latency_buckets; ++i) {
+                    if (s.latency_histogram[i]) {
+                        out << "  latency < 2^" << i << " ns: " << s.latency_histogram[i] << '\n';
+                    }
+                }
+            });
+        }
+
+    private:
+        static std::mutex& lock() noexcept {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        static allocation_stats*& head() noexcept {
+            static allocation_stats* list = nullptr;
+            return list;
+        }
+    };
+
+    // The name shown for Tag: Tag::name if it declares one, otherwise typeid(Tag).name().
+    template<class Tag, class = void>
+    struct stats_tag_name {
+        static const char* get() noexcept {
+            return typeid(Tag).name();
+        }
+    };
+
+    template<class Tag>
+    struct stats_tag_name<Tag, std::void_t<decltype(Tag::name)>> {
+        static const char* get() noexcept {
+            return Tag::name;
+        }
+    };
+
+    // The counters shared by every stats_allocator with this Tag, whatever T or Inner.
+    template<class Tag>
+    allocation_stats& stats_for() noexcept {
+        static allocation_stats* stats = [] {
+            // Never destroyed: containers may still free memory during static destruction.
+            allocation_stats* created = new allocation_stats(stats_tag_name<Tag>::get());
+            stats_registry::add(created);
+            return created;
+        }();
+        return *stats;
+    }
+
+    /**
+    * @brief Wraps Inner and records every allocation in the counters of Tag.
+    *
+    * - Tag is any type; give it a `static constexpr const char* name` for readable dumps.
+    *   Containers of different element types can share a tag.
+    * - Counters use relaxed atomics, so the adapter can stay enabled in production. With
+    *   TrackLatency the time spent inside Inner::allocate is also bucketed, at the cost of two
+    *   clock reads per allocation.
+    * - allocate_at_least is forwarded when Inner provides it, and the real block size is
+    *   counted. reallocate exists only when Inner has it and counts as a free plus an
+    *   allocation; allocate_zeroed likewise. Propagation traits and equality follow Inner.
+    * - Inner is a private base, so none of its other members leak through unaccounted.
+    *
+    * @tparam T The type of objects this allocator will manage.
+    * @tparam Tag The statistics bucket.
+    * @tparam Inner The allocator doing the real work.
+    * @tparam TrackLatency Also record an allocation latency histogram.
+    */
+    template<class T, class Tag, class Inner = allocator<T>, bool TrackLatency = false>
+    class stats_allocator : private Inner {
+        using inner_traits = std::allocator_traits<Inner>;
+
+        static_assert(std::is_same<typename inner_traits::value_type, T>::value,
+                      "stats_allocator must have the same value_type as its inner allocator");
+
+    public:
+        typedef T                                      value_type;
+        typedef typename inner_traits::pointer         pointer;
+        typedef typename inner_traits::size_type       size_type;
+        typedef typename inner_traits::difference_type difference_type;
+
+        typedef typename inner_traits::propagate_on_container_copy_assignment propagate_on_container_copy_assignment;
+        typedef typename inner_traits::propagate_on_container_move_assignment propagate_on_container_move_assignment;
+        typedef typename inner_traits::propagate_on_container_swap            propagate_on_container_swap;
+        typedef typename inner_traits::is_always_equal                        is_always_equal;
+
+        template<class U>
+        struct rebind {
+            typedef stats_allocator<U, Tag, typename inner_traits::template rebind_alloc<U>, TrackLatency> other;
+        };
+
+    public:
+        stats_allocator() = default;
+
+        explicit stats_allocator(const Inner& inner) noexcept : Inner(inner) {
+        }
+
+        stats_allocator(const stats_allocator&) noexcept = default;
+
+        template<class U, class OtherInner>
+        stats_allocator(const stats_allocator<U, Tag, OtherInner, TrackLatency>& other) noexcept
+            : Inner(other.inner_allocator()) {
+        }
+
+        stats_allocator& operator=(const stats_allocator&) = default;
+
+        ~stats_allocator() = default;
+
+        pointer allocate(size_type n) {
+            const auto start = clock_start();
+            pointer p        = inner_traits::allocate(inner_allocator(), n);
+            record(n, start);
+            return p;
+        }
+
+        allocation_result<pointer, size_type> allocate_at_least(size_type n) {
+            const auto start  = clock_start();
+            const auto result = Lsh::allocate_at_least(inner_allocator(), n);
+            record(result.count, start);
+            return {result.ptr, result.count};
+        }
+
+        void deallocate(pointer p, size_type n) {
+            stats_for<Tag>().record_deallocate(n * sizeof(T));
+            inner_traits::deallocate(inner_allocator(), p, n);
+        }
+
+        template<class I = Inner, class = std::enable_if_t<has_reallocate<I>::value>>
+        pointer reallocate(pointer p, size_type old_n, size_type new_n) {
+            const auto start = clock_start();
+            pointer result   = inner_allocator().reallocate(p, old_n, new_n);
+            if (p) {
+                stats_for<Tag>().record_deallocate(old_n * sizeof(T));
+            }
+            record(new_n, start);
+            return result;
+        }
+
+        template<class I = Inner, class = std::enable_if_t<has_allocate_zeroed<I>::value>>
+        pointer allocate_zeroed(size_type n) {
+            const auto start = clock_start();
+            pointer p        = inner_allocator().allocate_zeroed(n);
+            record(n, start);
+            return p;
+        }
+
+        [[nodiscard]] size_type max_size() const noexcept {
+            return inner_traits::max_size(inner_allocator());
+        }
+
+        template<class U, class... Args>
+        void construct(U* p, Args&&... args) {
+            inner_traits::construct(inner_allocator(), p, std::forward<Args>(args)...);
+        }
+
+        template<class U>
+        void destroy(U* p) {
+            inner_traits::destroy(inner_allocator(), p);
+        }
+
+        stats_allocator select_on_container_copy_construction() const {
+            return stats_allocator(inner_traits::select_on_container_copy_construction(inner_allocator()));
+        }
+
+        Inner& inner_allocator() noexcept {
+            return *this;
+        }
+
+        const Inner& inner_allocator() const noexcept {
+            return *this;
+        }
+
+        static allocation_snapshot snapshot() noexcept {
+            return stats_for<Tag>().snapshot();
+        }
+
+    private:
+        static std::chrono::steady_clock::time_point clock_start() noexcept {
+            return TrackLatency ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        }
+
+        static void record(size_type n, std::chrono::steady_clock::time_point start) noexcept {
+            allocation_stats& stats = stats_for<Tag>();
+            stats.record_allocate(n * sizeof(T));
+            if (TrackLatency) {
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                stats.record_latency(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            }
+        }
+    };
+
+    template<class T, class U, class Tag, class A1, class A2, bool TrackLatency>
+    bool operator==(const stats_allocator<T, Tag, A1, TrackLatency>& lhs,
+                    const stats_allocator<U, Tag, A2, TrackLatency>& rhs) noexcept {
+        return lhs.inner_allocator() == rhs.inner_allocator();
+    }
+
+    template<class T, class U, class Tag, class A1, class A2, bool TrackLatency>
+    bool operator!=(const stats_allocator<T, Tag, A1, TrackLatency>& lhs,
+                    const stats_allocator<U, Tag, A2, TrackLatency>& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+    // construct/destroy only forward, so the fast paths depend on Inner.
+    template<class T, class Tag, class Inner, bool TrackLatency>
+    struct uses_default_construct<stats_allocator<T, Tag, Inner, TrackLatency>> : uses_default_construct<Inner> {
+    };
+}
+#endif //STATS_ALLOCATOR_H
@@ -0,0 +1,1234 @@
+//
+// Created by Lsh on 26-10-16.
+//
+
+#ifndef UNORDERED_MAP_H
+#define UNORDERED_MAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "allocator.h"
+#include "construct.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LSH_HAS_SSE2 1
+#else
+#define LSH_HAS_SSE2 0
+#endif
+
+namespace Lsh {
+    /*
+     * 控制字节：每个槽位一个字节
+     * -- 空槽为 0x80（最高位为 1），满槽为哈希值的低 7 位 h2（最高位为 0）
+     * -- 删除时把后面的元素前移（backward shift），表中没有墓碑，只有这两种状态
+     */
+    typedef std::int8_t ctrl_t;
+
+    constexpr ctrl_t ctrl_empty = static_cast<ctrl_t>(-128);
+
+    /*
+     * 一组 16 个控制字节
+     * -- 开启 SSE2 时一次比较 16 个字节（pcmpeqb + pmovmskb），得到 16 位的掩码，第 i 位对应组内第 i 个槽位
+     * -- 没有 SSE2 时逐字节比较，结果相同
+     */
+    struct swiss_group {
+        static constexpr std::size_t width = 16;
+
+        explicit swiss_group(const ctrl_t* pos) noexcept {
+#if LSH_HAS_SSE2
+            ctrl_ = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+#else
+            std::memcpy(ctrl_, pos, width);
+#endif
+        }
+
+        // 控制字节等于 h2 的槽位
+        std::uint32_t match(ctrl_t h2) const noexcept {
+#if LSH_HAS_SSE2
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)));
+#else
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < width; ++i) {
+                mask |= static_cast<std::uint32_t>(ctrl_[i] == h2) << i;
+            }
+            return mask;
+#endif
+        }
+
+        // 空槽：最高位为 1
+        std::uint32_t match_empty() const noexcept {
+#if LSH_HAS_SSE2
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl_));
+#else
+            std::uint32_t mask = 0;
+            for (std::size_t i = 0; i < width; ++i) {
+                mask |= static_cast<std::uint32_t>(ctrl_[i] < 0) << i;
+            }
+            return mask;
+#endif
+        }
+
+        std::uint32_t match_full() const noexcept {
+            return match_empty() ^ 0xffffu;
+        }
+
+        // 掩码中最低的 1 所在的位置，mask 不能为 0
+        static std::size_t lowest(std::uint32_t mask) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<std::size_t>(__builtin_ctz(mask));
+#else
+            std::size_t n = 0;
+            while (!(mask & 1)) {
+                mask >>= 1;
+                ++n;
+            }
+            return n;
+#endif
+        }
+
+    private:
+#if LSH_HAS_SSE2
+        __m128i ctrl_;
+#else
+        ctrl_t ctrl_[width];
+#endif
+    };
+
+    /*
+     * 打散哈希值：std::hash 对整数是恒等函数，直接取低位做 h2、高位做起始槽位会大量冲突
+     * -- 与黄金分割常数做 64x64→128 位乘法，再把高低两半异或
+     * -- 没有 128 位整数时用 murmur3 的 fmix64
+     */
+    inline std::size_t swiss_mix(std::size_t hash) noexcept {
+#if defined(__SIZEOF_INT128__)
+        __extension__ typedef unsigned __int128 uint128;
+        const uint128 m = static_cast<uint128>(hash) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<std::size_t>(static_cast<std::uint64_t>(m) ^ static_cast<std::uint64_t>(m >> 64));
+#else
+        std::uint64_t h = hash;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return static_cast<std::size_t>(h);
+#endif
+    }
+
+    /*
+     * unordered_map 的迭代器
+     * -- 保存容器指针、槽位下标 index（end 为 npos）和创建时容器的遍历起点 origin
+     * -- 从 origin 之后循环扫描到 origin 为止；origin 是空槽，删除时前移的元素不会越过它，
+     *    所以 it = erase(it) 的循环每个元素恰好访问一次
+     * -- 插入占用 origin 时容器换用下一个空槽作起点，已有迭代器的 index 和 origin 不变：
+     *    仍与 find 的结果相等，继续遍历也不会重复访问
+     */
+    template<class Map, class Ref, class Ptr>
+    class unordered_map_iterator {
+        template<class, class, class>
+        friend class unordered_map_iterator;
+
+        template<class, class, class, class, class>
+        friend class unordered_map;
+
+        using mutable_iterator = unordered_map_iterator<typename std::remove_const<Map>::type,
+                                                        typename Map::reference, typename Map::pointer>;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = typename Map::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = Ptr;
+        using reference         = Ref;
+        using size_type         = std::size_t;
+
+        unordered_map_iterator() noexcept = default;
+
+        unordered_map_iterator(Map* map, size_type index, size_type origin) noexcept
+            : map_(map), index_(index), origin_(origin) {
+        }
+
+        // iterator 可以隐式转换为 const_iterator
+        template<class It, typename = typename std::enable_if<
+                               std::is_same<It, mutable_iterator>::value &&
+                               !std::is_same<It, unordered_map_iterator>::value>::type>
+        unordered_map_iterator(const It& other) noexcept
+            : map_(other.map_), index_(other.index_), origin_(other.origin_) {
+        }
+
+        reference operator*() const noexcept {
+            return map_->value_at(index_);
+        }
+
+        pointer operator->() const noexcept {
+            return std::addressof(map_->value_at(index_));
+        }
+
+        unordered_map_iterator& operator++() noexcept {
+            index_ = map_->next_full(map_->pos_of(index_, origin_) + 1, origin_);
+            return *this;
+        }
+
+        unordered_map_iterator operator++(int) noexcept {
+            unordered_map_iterator temp = *this;
+            ++*this;
+            return temp;
+        }
+
+        friend bool operator==(const unordered_map_iterator& lhs, const unordered_map_iterator& rhs) noexcept {
+            return lhs.index_ == rhs.index_;
+        }
+
+        friend bool operator!=(const unordered_map_iterator& lhs, const unordered_map_iterator& rhs) noexcept {
+            return lhs.index_ != rhs.index_;
+        }
+
+    private:
+        Map* map_{nullptr};
+        size_type index_{Map::npos};
+        size_type origin_{0};
+    };
+
+    /*
+     *  ctrl:  [h2 . . h2 h2 . ... h2 . | 前 15 个字节的副本]
+     *  slots: [kv . . kv kv . ... kv .]
+     *
+     * -- 开放寻址的哈希表（Swiss table），元素直接放在槽位数组里，没有链表节点
+     * -- 容量是 2 的幂，至少 16；负载因子超过 7/8 时容量翻倍
+     * -- 查找从 h1 & mask 开始线性探测，每次读 16 个控制字节，先用 h2 过滤再比较键；
+     *    一组里出现空槽就说明键不存在
+     * -- 控制字节数组末尾复制了开头的 15 个字节，从任何位置开始读 16 个字节都不用处理回绕
+     * -- 删除时把同一簇里后面的元素前移填补空洞（需要重新计算这些元素的哈希值），
+     *    不留墓碑，查找长度不会因为反复增删而变差
+     * -- 槽位和控制字节都通过 Allocator 重新绑定后的分配器分配
+     * -- 与 std::unordered_map 不同：扩容和删除会移动元素，指向被移动元素的引用和迭代器失效
+     */
+    template<class Key, class T, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>,
+             class Allocator = allocator<std::pair<const Key, T>>>
+    class unordered_map {
+        static_assert(std::is_same<typename Allocator::value_type, std::pair<const Key, T>>::value,
+                      "unordered_map must have the same value_type as its allocator");
+
+        template<class, class, class>
+        friend class unordered_map_iterator;
+
+    public:
+        using key_type        = Key;
+        using mapped_type     = T;
+        using value_type      = std::pair<const Key, T>;
+        using size_type       = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using hasher          = Hash;
+        using key_equal       = KeyEqual;
+        using allocator_type  = Allocator;
+        using reference       = value_type&;
+        using const_reference = const value_type&;
+        using pointer         = value_type*;
+        using const_pointer   = const value_type*;
+        using iterator        = unordered_map_iterator<unordered_map, value_type&, value_type*>;
+        using const_iterator  = unordered_map_iterator<const unordered_map, const value_type&, const value_type*>;
+
+    private:
+        using alloc_traits       = std::allocator_traits<Allocator>;
+        using mutable_value_type = std::pair<Key, T>;
+
+        /*
+         * 槽位：value 给用户看，mutable_value 用来移动元素（移动 value 只能拷贝 const 的键）
+         * -- 两者布局相同，标准库的关联容器也用同样的办法移动节点
+         */
+        union slot_type {
+            value_type value;
+            mutable_value_type mutable_value;
+
+            slot_type() noexcept {
+            }
+
+            ~slot_type() {
+            }
+        };
+
+        using slot_allocator = typename alloc_traits::template rebind_alloc<slot_type>;
+        using slot_traits    = std::allocator_traits<slot_allocator>;
+        using ctrl_allocator = typename alloc_traits::template rebind_alloc<ctrl_t>;
+        using ctrl_traits    = std::allocator_traits<ctrl_allocator>;
+
+        // 键值对能否用 memcpy 搬到新槽位（不调用移动构造和析构）
+        using relocate_tag = use_memcpy_relocate<mutable_value_type, Allocator>;
+
+        static constexpr size_type group_width  = swiss_group::width;
+        static constexpr size_type min_capacity = swiss_group::width;
+        static constexpr size_type npos         = static_cast<size_type>(-1);
+
+        // 析构时归还控制字节和槽位两块内存；槽位里的元素由 unordered_map 析构
+        struct map_impl : public Allocator {
+            ctrl_t* ctrl_{nullptr};        // capacity_ + group_width - 1 个字节
+            slot_type* slots_{nullptr};
+            size_type capacity_{0};        // 0 或 2 的幂
+            size_type size_{0};
+            size_type origin_{0};          // 遍历的起点，总是一个空槽
+
+            map_impl() = default;
+
+            explicit map_impl(const Allocator& alloc) noexcept : Allocator(alloc) {
+            }
+
+            explicit map_impl(Allocator&& alloc) noexcept : Allocator(std::move(alloc)) {
+            }
+
+            ~map_impl() {
+                if (ctrl_) {
+                    deallocate_table(*this, ctrl_, slots_, capacity_);
+                }
+            }
+        };
+
+        map_impl impl_;
+        hasher hash_;
+        key_equal eq_;
+
+    public:
+        //===============================构造函数==============================
+        // 不分配内存，第一次插入时才分配 16 个槽位
+        unordered_map() = default;
+
+        explicit unordered_map(size_type bucket_count, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                               const Allocator& alloc = Allocator())
+            : impl_(alloc), hash_(hash), eq_(equal) {
+            rehash(bucket_count);
+        }
+
+        unordered_map(size_type bucket_count, const Allocator& alloc)
+            : unordered_map(bucket_count, Hash(), KeyEqual(), alloc) {
+        }
+
+        unordered_map(size_type bucket_count, const Hash& hash, const Allocator& alloc)
+            : unordered_map(bucket_count, hash, KeyEqual(), alloc) {
+        }
+
+        explicit unordered_map(const Allocator& alloc) : impl_(alloc), hash_(), eq_() {
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        unordered_map(InputIterator first, InputIterator last, size_type bucket_count = 0,
+                      const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                      const Allocator& alloc = Allocator())
+            : unordered_map(bucket_count, hash, equal, alloc) {
+            insert(first, last);
+        }
+
+        unordered_map(std::initializer_list<value_type> init, size_type bucket_count = 0,
+                      const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(),
+                      const Allocator& alloc = Allocator())
+            : unordered_map(bucket_count, hash, equal, alloc) {
+            reserve(init.size());
+            insert(init.begin(), init.end());
+        }
+
+        // 拷贝后容量与 other 相同，每个元素放在与 other 相同的槽位，不需要重新计算哈希值
+        unordered_map(const unordered_map& other)
+            : impl_(alloc_traits::select_on_container_copy_construction(other.get_alloc())),
+              hash_(other.hash_), eq_(other.eq_) {
+            copy_from(other);
+        }
+
+        unordered_map(const unordered_map& other, const Allocator& alloc)
+            : impl_(alloc), hash_(other.hash_), eq_(other.eq_) {
+            copy_from(other);
+        }
+
+        unordered_map(unordered_map&& other) noexcept(std::is_nothrow_move_constructible<Hash>::value &&
+                                                      std::is_nothrow_move_constructible<KeyEqual>::value)
+            : impl_(std::move(other.get_alloc())), hash_(std::move(other.hash_)), eq_(std::move(other.eq_)) {
+            steal_storage(other);
+        }
+
+        unordered_map(unordered_map&& other, const Allocator& alloc)
+            : impl_(alloc), hash_(other.hash_), eq_(other.eq_) {
+            if (alloc_traits::is_always_equal::value || get_alloc() == other.get_alloc()) {
+                steal_storage(other);
+            } else {
+                move_from(other);
+            }
+        }
+
+        //===============================析构函数==================================
+        ~unordered_map() {
+            destroy_elements();
+        }
+
+        //============================ operator= ==================================
+        unordered_map& operator=(const unordered_map& other) {
+            if (std::addressof(other) != this) {
+                clear();
+                // 需要换成 other 的分配器时，旧内存先交给旧分配器释放
+                if (alloc_traits::propagate_on_container_copy_assignment::value &&
+                    !alloc_traits::is_always_equal::value && get_alloc() != other.get_alloc()) {
+                    release_storage();
+                }
+                alloc_on_copy(get_alloc(), other.get_alloc());
+                hash_ = other.hash_;
+                eq_   = other.eq_;
+                copy_from(other);
+            }
+            return *this;
+        }
+
+        unordered_map& operator=(unordered_map&& other) noexcept(
+            (alloc_traits::propagate_on_container_move_assignment::value ||
+             alloc_traits::is_always_equal::value) &&
+            std::is_nothrow_move_assignable<Hash>::value && std::is_nothrow_move_assignable<KeyEqual>::value) {
+            if (std::addressof(other) != this) {
+                move_assign(std::move(other), std::integral_constant<bool,
+                            alloc_traits::propagate_on_container_move_assignment::value ||
+                            alloc_traits::is_always_equal::value>());
+            }
+            return *this;
+        }
+
+        unordered_map& operator=(std::initializer_list<value_type> init) {
+            clear();
+            reserve(init.size());
+            insert(init.begin(), init.end());
+            return *this;
+        }
+
+        allocator_type get_allocator() const noexcept {
+            return allocator_type(get_alloc());
+        }
+
+        hasher hash_function() const {
+            return hash_;
+        }
+
+        key_equal key_eq() const {
+            return eq_;
+        }
+
+        //================================ 迭代器 ==================================
+        iterator begin() noexcept {
+            return iterator(this, next_full(impl_.origin_, impl_.origin_), impl_.origin_);
+        }
+
+        const_iterator begin() const noexcept {
+            return const_iterator(this, next_full(impl_.origin_, impl_.origin_), impl_.origin_);
+        }
+
+        const_iterator cbegin() const noexcept {
+            return begin();
+        }
+
+        iterator end() noexcept {
+            return iterator(this, npos, impl_.origin_);
+        }
+
+        const_iterator end() const noexcept {
+            return const_iterator(this, npos, impl_.origin_);
+        }
+
+        const_iterator cend() const noexcept {
+            return end();
+        }
+
+        //================================ 容量 ====================================
+        [[nodiscard]] bool empty() const noexcept {
+            return impl_.size_ == 0;
+        }
+
+        size_type size() const noexcept {
+            return impl_.size_;
+        }
+
+        size_type max_size() const noexcept {
+            size_type diffmax  = std::numeric_limits<difference_type>::max() / sizeof(slot_type);
+            size_type allocmax = slot_traits::max_size(slot_allocator(get_alloc()));
+            size_type slots    = std::min(diffmax, allocmax);
+            return slots - slots / 8;
+        }
+
+        //================================ 修改器 ==================================
+        // 析构所有元素，保留槽位数组
+        void clear() noexcept {
+            destroy_elements();
+            if (impl_.ctrl_) {
+                std::memset(impl_.ctrl_, static_cast<unsigned char>(ctrl_empty), ctrl_bytes(impl_.capacity_));
+            }
+            impl_.size_   = 0;
+            impl_.origin_ = 0;
+        }
+
+        std::pair<iterator, bool> insert(const value_type& value) {
+            return try_emplace_impl(value.first, value.second);
+        }
+
+        std::pair<iterator, bool> insert(value_type&& value) {
+            return try_emplace_impl(value.first, std::move(value.second));
+        }
+
+        template<class P, typename = typename std::enable_if<std::is_constructible<value_type, P&&>::value>::type>
+        std::pair<iterator, bool> insert(P&& value) {
+            return emplace(std::forward<P>(value));
+        }
+
+        // 位置提示没有用处，只为与 std::inserter 等配合
+        iterator insert(const_iterator, const value_type& value) {
+            return insert(value).first;
+        }
+
+        iterator insert(const_iterator, value_type&& value) {
+            return insert(std::move(value)).first;
+        }
+
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        void insert(InputIterator first, InputIterator last) {
+            for (; first != last; ++first) {
+                emplace(*first);
+            }
+        }
+
+        void insert(std::initializer_list<value_type> init) {
+            insert(init.begin(), init.end());
+        }
+
+        template<class M>
+        std::pair<iterator, bool> insert_or_assign(const key_type& key, M&& obj) {
+            return insert_or_assign_impl(key, std::forward<M>(obj));
+        }
+
+        template<class M>
+        std::pair<iterator, bool> insert_or_assign(key_type&& key, M&& obj) {
+            return insert_or_assign_impl(std::move(key), std::forward<M>(obj));
+        }
+
+        // 先在栈上构造出键值对才能知道键，再把它移动到槽位里
+        template<class... Args>
+        std::pair<iterator, bool> emplace(Args&&... args) {
+            mutable_value_type value(std::forward<Args>(args)...);
+            return try_emplace_impl(std::move(value.first), std::move(value.second));
+        }
+
+        template<class... Args>
+        iterator emplace_hint(const_iterator, Args&&... args) {
+            return emplace(std::forward<Args>(args)...).first;
+        }
+
+        // 键已存在时不构造 mapped_type，也不移动实参
+        template<class... Args>
+        std::pair<iterator, bool> try_emplace(const key_type& key, Args&&... args) {
+            return try_emplace_impl(key, std::forward<Args>(args)...);
+        }
+
+        template<class... Args>
+        std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args) {
+            return try_emplace_impl(std::move(key), std::forward<Args>(args)...);
+        }
+
+        template<class... Args>
+        iterator try_emplace(const_iterator, const key_type& key, Args&&... args) {
+            return try_emplace_impl(key, std::forward<Args>(args)...).first;
+        }
+
+        template<class... Args>
+        iterator try_emplace(const_iterator, key_type&& key, Args&&... args) {
+            return try_emplace_impl(std::move(key), std::forward<Args>(args)...).first;
+        }
+
+        /*
+         * 删除 pos 指向的元素，返回下一个还没访问过的元素
+         * -- 同一簇里后面的元素可能前移到 pos 的位置，所以返回的迭代器可能仍指向 pos 的槽位
+         * -- 指向被前移元素的其它迭代器失效，遍历时删除请用 it = erase(it)
+         */
+        iterator erase(const_iterator pos) {
+            erase_at(pos.index_);
+            return iterator(this, next_full(pos_of(pos.index_, pos.origin_), pos.origin_), pos.origin_);
+        }
+
+        iterator erase(iterator pos) {
+            return erase(const_iterator(pos));
+        }
+
+        // 从后往前删：删除一个元素只会移动它后面的元素，前面还没删的元素位置不变
+        iterator erase(const_iterator first, const_iterator last) {
+            if (first == last) {
+                return iterator(this, last.index_, last.origin_);
+            }
+            if (first == cbegin() && last.index_ == npos) {
+                clear();
+                return end();
+            }
+            const size_type origin    = first.origin_;
+            const size_type first_pos = pos_of(first.index_, origin);
+            size_type pos = last.index_ == npos ? origin + impl_.capacity_ : pos_of(last.index_, origin);
+            do {
+                do {
+                    --pos;
+                } while (impl_.ctrl_[pos & mask()] == ctrl_empty);
+                erase_at(pos & mask());
+            } while (pos != first_pos);
+            return iterator(this, next_full(first_pos, origin), origin);
+        }
+
+        size_type erase(const key_type& key) {
+            return erase_key(key);
+        }
+
+        template<class K, class H = Hash, class E = KeyEqual,
+                 typename = typename H::is_transparent, typename = typename E::is_transparent,
+                 typename = typename std::enable_if<!std::is_convertible<K&&, const_iterator>::value &&
+                                                    !std::is_convertible<K&&, iterator>::value>::type>
+        size_type erase(K&& key) {
+            return erase_key(key);
+        }
+
+        void swap(unordered_map& other) noexcept {
+            using std::swap;
+            std::swap(impl_.ctrl_, other.impl_.ctrl_);
+            std::swap(impl_.slots_, other.impl_.slots_);
+            std::swap(impl_.capacity_, other.impl_.capacity_);
+            std::swap(impl_.size_, other.impl_.size_);
+            std::swap(impl_.origin_, other.impl_.origin_);
+            swap(hash_, other.hash_);
+            swap(eq_, other.eq_);
+            alloc_on_swap(get_alloc(), other.get_alloc());
+        }
+
+        //================================ 查找 ====================================
+        T& at(const key_type& key) {
+            return at_impl(key);
+        }
+
+        const T& at(const key_type& key) const {
+            return const_cast<unordered_map*>(this)->at_impl(key);
+        }
+
+        T& operator[](const key_type& key) {
+            return try_emplace_impl(key).first->second;
+        }
+
+        T& operator[](key_type&& key) {
+            return try_emplace_impl(std::move(key)).first->second;
+        }
+
+        iterator find(const key_type& key) {
+            return iterator_at(find_index(key, hash_of(key)));
+        }
+
+        const_iterator find(const key_type& key) const {
+            return const_iterator_at(find_index(key, hash_of(key)));
+        }
+
+        // 透明查找：Hash 和 KeyEqual 都声明了 is_transparent 时，可以直接用 string_view 等查找
+        template<class K, class H = Hash, class E = KeyEqual,
+                 typename = typename H::is_transparent, typename = typename E::is_transparent>
+        iterator find(const K& key) {
+            return iterator_at(find_index(key, hash_of(key)));
+        }
+
+        template<class K, class H = Hash, class E = KeyEqual,
+                 typename = typename H::is_transparent, typename = typename E::is_transparent>
+        const_iterator find(const K& key) const {
+            return const_iterator_at(find_index(key, hash_of(key)));
+        }
+
+        size_type count(const key_type& key) const {
+            return contains(key) ? 1 : 0;
+        }
+
+        template<class K, class H = Hash, class E = KeyEqual,
+                 typename = typename H::is_transparent, typename = typename E::is_transparent>
+        size_type count(const K& key) const {
+            return contains(key) ? 1 : 0;
+        }
+
+        bool contains(const key_type& key) const {
+            return find_index(key, hash_of(key)) != npos;
+        }
+
+        template<class K, class H = Hash, class E = KeyEqual,
+                 typename = typename H::is_transparent, typename = typename E::is_transparent>
+        bool contains(const K& key) const {
+            return find_index(key, hash_of(key)) != npos;
+        }
+
+        std::pair<iterator, iterator> equal_range(const key_type& key) {
+            return equal_range_impl(find(key));
+        }
+
+        std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const {
+            return equal_range_impl(find(key));
+        }
+
+        template<class K, class H = Hash, class E = KeyEqual,
+                 typename = typename H::is_transparent, typename = typename E::is_transparent>
+        std::pair<iterator, iterator> equal_range(const K& key) {
+            return equal_range_impl(find(key));
+        }
+
+        template<class K, class H = Hash, class E = KeyEqual,
+                 typename = typename H::is_transparent, typename = typename E::is_transparent>
+        std::pair<const_iterator, const_iterator> equal_range(const K& key) const {
+            return equal_range_impl(find(key));
+        }
+
+        //================================ 哈希策略 ================================
+        // 每个槽位相当于一个桶
+        size_type bucket_count() const noexcept {
+            return impl_.capacity_;
+        }
+
+        float load_factor() const noexcept {
+            return impl_.capacity_ == 0 ? 0.0f : static_cast<float>(impl_.size_) / impl_.capacity_;
+        }
+
+        // 最大负载因子固定为 7/8，设置的值只是提示，会被忽略
+        float max_load_factor() const noexcept {
+            return 0.875f;
+        }
+
+        void max_load_factor(float) noexcept {
+        }
+
+        // 容量改为不小于 bucket_count 且能容纳 size() 个元素的最小值，可能缩小；两者都为 0 时释放内存
+        void rehash(size_type bucket_count) {
+            size_type new_capacity = capacity_for(impl_.size_);
+            if (bucket_count > new_capacity) {
+                if (bucket_count > max_size()) {
+                    throw std::length_error("unordered_map::rehash");
+                }
+                new_capacity = std::max(min_capacity, round_up_pow2(bucket_count));
+            }
+            if (new_capacity == impl_.capacity_) {
+                return;
+            }
+            if (new_capacity == 0) {
+                release_storage();
+            } else {
+                rehash_to(new_capacity);
+            }
+        }
+
+        // 保证再插入到 count 个元素之前不会扩容
+        void reserve(size_type count) {
+            const size_type new_capacity = capacity_for(count);
+            if (new_capacity > impl_.capacity_) {
+                rehash_to(new_capacity);
+            }
+        }
+
+    private:
+        //================================ 工具函数 ================================
+        Allocator& get_alloc() noexcept {
+            return impl_;
+        }
+
+        const Allocator& get_alloc() const noexcept {
+            return impl_;
+        }
+
+        size_type mask() const noexcept {
+            return impl_.capacity_ - 1;
+        }
+
+        static size_type ctrl_bytes(size_type capacity) noexcept {
+            return capacity + group_width - 1;
+        }
+
+        static size_type growth_limit(size_type capacity) noexcept {
+            return capacity - capacity / 8;
+        }
+
+        static size_type h1(size_type hash) noexcept {
+            return hash >> 7;
+        }
+
+        static ctrl_t h2(size_type hash) noexcept {
+            return static_cast<ctrl_t>(hash & 0x7f);
+        }
+
+        // n 不超过 max_size()，左移不会溢出
+        static size_type round_up_pow2(size_type n) noexcept {
+            size_type capacity = 1;
+            while (capacity < n) {
+                capacity <<= 1;
+            }
+            return capacity;
+        }
+
+        // 放下 count 个元素且负载因子不超过 7/8 的最小容量
+        size_type capacity_for(size_type count) const {
+            if (count == 0) {
+                return 0;
+            }
+            if (count > max_size()) {
+                throw std::length_error("unordered_map::reserve");
+            }
+            size_type capacity = min_capacity;
+            while (growth_limit(capacity) < count) {
+                capacity <<= 1;
+            }
+            return capacity;
+        }
+
+        template<class K>
+        size_type hash_of(const K& key) const {
+            return swiss_mix(static_cast<size_type>(hash_(key)));
+        }
+
+        value_type& value_at(size_type pos) noexcept {
+            return impl_.slots_[pos & mask()].value;
+        }
+
+        const value_type& value_at(size_type pos) const noexcept {
+            return impl_.slots_[pos & mask()].value;
+        }
+
+        // 槽位下标换算成从 origin 开始的遍历位置：origin 之前的槽位排在最后
+        size_type pos_of(size_type index, size_type origin) const noexcept {
+            return index < origin ? index + impl_.capacity_ : index;
+        }
+
+        iterator iterator_at(size_type index) noexcept {
+            return iterator(this, index, impl_.origin_);
+        }
+
+        const_iterator const_iterator_at(size_type index) const noexcept {
+            return const_iterator(this, index, impl_.origin_);
+        }
+
+        // 以 origin 为起点、从遍历位置 pos（含）开始的第一个满槽的下标，一次看 16 个控制字节；没有时返回 npos
+        size_type next_full(size_type pos, size_type origin) const noexcept {
+            const size_type last = origin + impl_.capacity_;
+            while (pos < last) {
+                std::uint32_t match = swiss_group(impl_.ctrl_ + (pos & mask())).match_full();
+                if (last - pos < group_width) {
+                    match &= (std::uint32_t(1) << (last - pos)) - 1;
+                }
+                if (match != 0) {
+                    return (pos + swiss_group::lowest(match)) & mask();
+                }
+                pos += group_width;
+            }
+            return npos;
+        }
+
+        // 写控制字节，下标小于 15 时同时写末尾的副本；下标不小于 15 时第二次写的就是它自己
+        void set_ctrl(size_type index, ctrl_t value) noexcept {
+            impl_.ctrl_[index] = value;
+            impl_.ctrl_[((index - (group_width - 1)) & mask()) + (group_width - 1)] = value;
+        }
+
+        /*
+         * 查找 key 所在的槽位，不存在时返回 npos
+         * -- 从 h1 & mask 开始，每次取 16 个控制字节，只对 h2 相同的槽位比较键
+         * -- 线性探测中同一个键的起始位置到它所在位置之间没有空槽，所以遇到空槽即可停止
+         */
+        template<class K>
+        size_type find_index(const K& key, size_type hash) const {
+            if (impl_.size_ == 0) {
+                return npos;
+            }
+            const ctrl_t tag = h2(hash);
+            size_type pos    = h1(hash) & mask();
+            while (true) {
+                const swiss_group group(impl_.ctrl_ + pos);
+                for (std::uint32_t match = group.match(tag); match != 0; match &= match - 1) {
+                    const size_type index = (pos + swiss_group::lowest(match)) & mask();
+                    if (eq_(key, impl_.slots_[index].value.first)) {
+                        return index;
+                    }
+                }
+                if (group.match_empty() != 0) {
+                    return npos;
+                }
+                pos = (pos + group_width) & mask();
+            }
+        }
+
+        // 从槽位 index 开始的第一个空槽；负载因子不超过 7/8，一定能找到
+        size_type find_empty(size_type index) const noexcept {
+            while (true) {
+                const std::uint32_t match = swiss_group(impl_.ctrl_ + index).match_empty();
+                if (match != 0) {
+                    return (index + swiss_group::lowest(match)) & mask();
+                }
+                index = (index + group_width) & mask();
+            }
+        }
+
+        /*
+         * 元素已在 index 上构造好并写了控制字节；占用了 origin 时把 origin 挪到下一个空槽
+         * -- 已有的迭代器保存的是槽位下标和它们自己的起点，不受影响
+         */
+        void finish_insert(size_type index) noexcept {
+            ++impl_.size_;
+            if (index == impl_.origin_) {
+                impl_.origin_ = find_empty(index);
+            }
+        }
+
+        template<class K, class... Args>
+        std::pair<iterator, bool> try_emplace_impl(K&& key, Args&&... args) {
+            const size_type hash = hash_of(key);
+            size_type index      = find_index(key, hash);
+            if (index != npos) {
+                return std::pair<iterator, bool>(iterator_at(index), false);
+            }
+            // 需要扩容时先在新表中构造新元素，再搬迁旧元素：key 和 args 可能引用表中的元素
+            auto construct = [&](size_type slot) {
+                alloc_traits::construct(get_alloc(), std::addressof(impl_.slots_[slot].value), std::piecewise_construct,
+                                        std::forward_as_tuple(std::forward<K>(key)),
+                                        std::forward_as_tuple(std::forward<Args>(args)...));
+                set_ctrl(slot, h2(hash));
+            };
+            if (impl_.size_ >= growth_limit(impl_.capacity_)) {
+                index = rehash_to(capacity_for(impl_.size_ + 1), hash, construct);
+            } else {
+                index = find_empty(h1(hash) & mask());
+                construct(index);
+            }
+            finish_insert(index);
+            return std::pair<iterator, bool>(iterator_at(index), true);
+        }
+
+        template<class K, class M>
+        std::pair<iterator, bool> insert_or_assign_impl(K&& key, M&& obj) {
+            const size_type index = find_index(key, hash_of(key));
+            if (index != npos) {
+                impl_.slots_[index].value.second = std::forward<M>(obj);
+                return std::pair<iterator, bool>(iterator_at(index), false);
+            }
+            return try_emplace_impl(std::forward<K>(key), std::forward<M>(obj));
+        }
+
+        T& at_impl(const key_type& key) {
+            const size_type index = find_index(key, hash_of(key));
+            if (index == npos) {
+                throw std::out_of_range("unordered_map::at");
+            }
+            return impl_.slots_[index].value.second;
+        }
+
+        template<class K>
+        size_type erase_key(const K& key) {
+            const size_type index = find_index(key, hash_of(key));
+            if (index == npos) {
+                return 0;
+            }
+            erase_at(index);
+            return 1;
+        }
+
+        template<class It>
+        std::pair<It, It> equal_range_impl(It it) const {
+            It last = it;
+            if (it.index_ != npos) {
+                ++last;
+            }
+            return std::pair<It, It>(it, last);
+        }
+
+        /*
+         * 删除槽位 index 上的元素，不留墓碑
+         * -- 向后扫描到第一个空槽为止，起始位置不在 (hole, next] 内的元素可以前移到空洞 hole，
+         *    之后 next 成为新的空洞；最后把空洞标为空槽
+         * -- 前移的元素不会越过 origin，origin 仍是空槽
+         * -- 元素的移动构造抛出异常时调用 std::terminate
+         */
+        void erase_at(size_type index) noexcept {
+            alloc_traits::destroy(get_alloc(), std::addressof(impl_.slots_[index].value));
+            size_type hole = index;
+            for (size_type next = (index + 1) & mask(); impl_.ctrl_[next] != ctrl_empty; next = (next + 1) & mask()) {
+                const size_type home = h1(hash_of(impl_.slots_[next].value.first)) & mask();
+                if (((next - home) & mask()) >= ((next - hole) & mask())) {
+                    relocate_slot(impl_.slots_ + hole, impl_.slots_ + next, relocate_tag());
+                    set_ctrl(hole, impl_.ctrl_[next]);
+                    hole = next;
+                }
+            }
+            set_ctrl(hole, ctrl_empty);
+            --impl_.size_;
+        }
+
+        void relocate_slot(slot_type* to, slot_type* from, std::true_type) noexcept {
+            std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), sizeof(slot_type));
+        }
+
+        void relocate_slot(slot_type* to, slot_type* from, std::false_type) noexcept {
+            alloc_traits::construct(get_alloc(), std::addressof(to->mutable_value), std::move(from->mutable_value));
+            alloc_traits::destroy(get_alloc(), std::addressof(from->mutable_value));
+        }
+
+        // 扩容时搬元素：移动构造可能抛出异常时退而拷贝，旧表保持完好
+        void transfer_slot(slot_type* to, slot_type* from, std::true_type) noexcept {
+            std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), sizeof(slot_type));
+        }
+
+        void transfer_slot(slot_type* to, slot_type* from, std::false_type) {
+            alloc_traits::construct(get_alloc(), std::addressof(to->mutable_value),
+                                    std::move_if_noexcept(from->mutable_value));
+        }
+
+        // 析构 [ctrl, ctrl + capacity) 中满槽上的元素，不改控制字节
+        void destroy_slots(const ctrl_t* ctrl, slot_type* slots, size_type capacity) noexcept {
+            if (!std::is_trivially_destructible<value_type>::value || !uses_default_construct<Allocator>::value) {
+                for (size_type i = 0; i < capacity; ++i) {
+                    if (ctrl[i] != ctrl_empty) {
+                        alloc_traits::destroy(get_alloc(), std::addressof(slots[i].value));
+                    }
+                }
+            }
+        }
+
+        void destroy_elements() noexcept {
+            if (impl_.size_ != 0) {
+                destroy_slots(impl_.ctrl_, impl_.slots_, impl_.capacity_);
+            }
+        }
+
+        // 换表时暂存的旧表
+        struct table_state {
+            ctrl_t* ctrl_;
+            slot_type* slots_;
+            size_type capacity_;
+            size_type origin_;
+        };
+
+        /*
+         * 分配 capacity 个槽位的新表并把所有元素搬过去
+         * -- 逐个重新计算哈希值，放到新表中起始位置后的第一个空槽
+         * -- 除哈希函数外抛出异常（只可能是拷贝构造）时释放新表，旧表保持不变
+         */
+        void rehash_to(size_type capacity) {
+            const table_state old = {impl_.ctrl_, impl_.slots_, impl_.capacity_, impl_.origin_};
+            allocate_table(capacity);
+            try {
+                transfer_from(old);
+            } catch (...) {
+                if (!relocate_tag::value) {
+                    destroy_slots(impl_.ctrl_, impl_.slots_, impl_.capacity_);
+                }
+                restore_table(old);
+                throw;
+            }
+            retire_table(old);
+        }
+
+        /*
+         * 扩容并插入哈希值为 hash 的新元素，返回它的槽位
+         * -- 旧元素搬迁之前先调用 construct(index) 在新表中构造新元素并写控制字节：
+         *    构造的参数可能引用旧表中的元素，搬迁之后它们就被移走或释放了
+         * -- 构造或搬迁抛出异常时新元素被析构，旧表保持不变
+         */
+        template<class Construct>
+        size_type rehash_to(size_type capacity, size_type hash, Construct& construct) {
+            const table_state old = {impl_.ctrl_, impl_.slots_, impl_.capacity_, impl_.origin_};
+            allocate_table(capacity);
+            const size_type index = find_empty(h1(hash) & mask());
+            try {
+                construct(index);
+            } catch (...) {
+                restore_table(old);
+                throw;
+            }
+            try {
+                transfer_from(old);
+            } catch (...) {
+                if (relocate_tag::value) {
+                    alloc_traits::destroy(get_alloc(), std::addressof(impl_.slots_[index].value));
+                } else {
+                    destroy_slots(impl_.ctrl_, impl_.slots_, impl_.capacity_);
+                }
+                restore_table(old);
+                throw;
+            }
+            retire_table(old);
+            return index;
+        }
+
+        void transfer_from(const table_state& old) {
+            for (size_type i = 0; i < old.capacity_; ++i) {
+                if (old.ctrl_[i] != ctrl_empty) {
+                    const size_type hash  = hash_of(old.slots_[i].value.first);
+                    const size_type index = find_empty(h1(hash) & mask());
+                    transfer_slot(impl_.slots_ + index, old.slots_ + i, relocate_tag());
+                    set_ctrl(index, old.ctrl_[i]);
+                }
+            }
+        }
+
+        // 释放新表（其中的元素已经析构），换回旧表
+        void restore_table(const table_state& old) noexcept {
+            deallocate_table(get_alloc(), impl_.ctrl_, impl_.slots_, impl_.capacity_);
+            impl_.ctrl_     = old.ctrl_;
+            impl_.slots_    = old.slots_;
+            impl_.capacity_ = old.capacity_;
+            impl_.origin_   = old.origin_;
+        }
+
+        // 搬迁完成：析构旧表中的元素（按字节搬迁时不需要）并释放旧表
+        void retire_table(const table_state& old) noexcept {
+            impl_.origin_ = find_empty(0);
+            if (old.ctrl_) {
+                if (!relocate_tag::value) {
+                    destroy_slots(old.ctrl_, old.slots_, old.capacity_);
+                }
+                deallocate_table(get_alloc(), old.ctrl_, old.slots_, old.capacity_);
+            }
+        }
+
+        // 分配新表并全部标为空槽，不释放旧表
+        void allocate_table(size_type capacity) {
+            ctrl_allocator ctrl_alloc(get_alloc());
+            slot_allocator slot_alloc(get_alloc());
+            ctrl_t* ctrl = ctrl_traits::allocate(ctrl_alloc, ctrl_bytes(capacity));
+            try {
+                impl_.slots_ = slot_traits::allocate(slot_alloc, capacity);
+            } catch (...) {
+                ctrl_traits::deallocate(ctrl_alloc, ctrl, ctrl_bytes(capacity));
+                throw;
+            }
+            std::memset(ctrl, static_cast<unsigned char>(ctrl_empty), ctrl_bytes(capacity));
+            impl_.ctrl_     = ctrl;
+            impl_.capacity_ = capacity;
+            impl_.origin_   = 0;
+        }
+
+        static void deallocate_table(Allocator& alloc, ctrl_t* ctrl, slot_type* slots, size_type capacity) noexcept {
+            ctrl_allocator ctrl_alloc(alloc);
+            slot_allocator slot_alloc(alloc);
+            slot_traits::deallocate(slot_alloc, slots, capacity);
+            ctrl_traits::deallocate(ctrl_alloc, ctrl, ctrl_bytes(capacity));
+        }
+
+        // 归还槽位数组，调用前元素必须已经析构
+        void release_storage() noexcept {
+            if (impl_.ctrl_) {
+                deallocate_table(get_alloc(), impl_.ctrl_, impl_.slots_, impl_.capacity_);
+            }
+            impl_.ctrl_     = nullptr;
+            impl_.slots_    = nullptr;
+            impl_.capacity_ = 0;
+            impl_.size_     = 0;
+            impl_.origin_   = 0;
+        }
+
+        void steal_storage(unordered_map& other) noexcept {
+            impl_.ctrl_           = other.impl_.ctrl_;
+            impl_.slots_          = other.impl_.slots_;
+            impl_.capacity_       = other.impl_.capacity_;
+            impl_.size_           = other.impl_.size_;
+            impl_.origin_         = other.impl_.origin_;
+            other.impl_.ctrl_     = nullptr;
+            other.impl_.slots_    = nullptr;
+            other.impl_.capacity_ = 0;
+            other.impl_.size_     = 0;
+            other.impl_.origin_   = 0;
+        }
+
+        /*
+         * 按 other 的容量建表，每个元素放在与 other 相同的槽位
+         * -- 调用前本表必须为空，hash_ 与 other 的相同
+         * -- 抛出异常时已拷贝的元素被析构，本表为空
+         */
+        template<class Map, class Construct>
+        void clone_from(Map& other, Construct construct) {
+            if (other.impl_.size_ == 0) {
+                return;
+            }
+            if (impl_.capacity_ != other.impl_.capacity_) {
+                release_storage();
+                allocate_table(other.impl_.capacity_);
+            }
+            try {
+                for (size_type i = 0; i < other.impl_.capacity_; ++i) {
+                    if (other.impl_.ctrl_[i] != ctrl_empty) {
+                        construct(impl_.slots_ + i, other.impl_.slots_ + i);
+                        set_ctrl(i, other.impl_.ctrl_[i]);
+                        ++impl_.size_;
+                    }
+                }
+            } catch (...) {
+                clear();
+                throw;
+            }
+            impl_.origin_ = other.impl_.origin_;
+        }
+
+        void copy_from(const unordered_map& other) {
+            clone_from(other, [this](slot_type* to, const slot_type* from) {
+                alloc_traits::construct(get_alloc(), std::addressof(to->value), from->value);
+            });
+        }
+
+        // 分配器不相等时只能逐个移动元素，other 随后被清空
+        void move_from(unordered_map& other) {
+            clone_from(other, [this](slot_type* to, slot_type* from) {
+                alloc_traits::construct(get_alloc(), std::addressof(to->mutable_value),
+                                        std::move(from->mutable_value));
+            });
+            other.clear();
+        }
+
+        void move_assign(unordered_map&& other, std::true_type) noexcept(
+            std::is_nothrow_move_assignable<Hash>::value && std::is_nothrow_move_assignable<KeyEqual>::value) {
+            clear();
+            release_storage();
+            alloc_on_move(get_alloc(), other.get_alloc());
+            hash_ = std::move(other.hash_);
+            eq_   = std::move(other.eq_);
+            steal_storage(other);
+        }
+
+        void move_assign(unordered_map&& other, std::false_type) {
+            if (get_alloc() == other.get_alloc()) {
+                move_assign(std::move(other), std::true_type());
+            } else {
+                clear();
+                hash_ = other.hash_;
+                eq_   = other.eq_;
+                move_from(other);
+            }
+        }
+    };
+
+    //==================================== 非成员函数 ==========================
+    // 元素个数相同，且 lhs 的每个键都能在 rhs 中找到相等的值
+    template<class Key, class T, class Hash, class KeyEqual, class Allocator>
+    bool operator==(const unordered_map<Key, T, Hash, KeyEqual, Allocator>& lhs,
+                    const unordered_map<Key, T, Hash, KeyEqual, Allocator>& rhs) {
+        if (lhs.size() != rhs.size()) {
+            return false;
+        }
+        for (const auto& value : lhs) {
+            const auto it = rhs.find(value.first);
+            if (it == rhs.end() || !(it->second == value.second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<class Key, class T, class Hash, class KeyEqual, class Allocator>
+    bool operator!=(const unordered_map<Key, T, Hash, KeyEqual, Allocator>& lhs,
+                    const unordered_map<Key, T, Hash, KeyEqual, Allocator>& rhs) {
+        return !(lhs == rhs);
+    }
+
+    template<class Key, class T, class Hash, class KeyEqual, class Allocator>
+    void swap(unordered_map<Key, T, Hash, KeyEqual, Allocator>& lhs,
+              unordered_map<Key, T, Hash, KeyEqual, Allocator>& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+}
+#endif //UNORDERED_MAP_H
@@ -5,15 +5,30 @@
 #ifndef VECTOR_H
 #define VECTOR_H
 
+#include <algorithm>
+#include <cstring>
 #include <initializer_list>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <stdexcept>
+#include "allocator.h"
+#include "construct.h"
+#include "growth_policy.h"
 
 namespace Lsh {
-    template<class T>
+    /*
+     * -- Allocator    分配器，默认 Lsh::allocator
+     * -- GrowthPolicy 扩容策略（见 growth_policy.h），默认二倍扩容
+     */
+    template<class T, class Allocator = allocator<T>, class GrowthPolicy = growth_2x>
     class vector {
+        static_assert(std::is_same<typename Allocator::value_type, T>::value,
+                      "vector must have the same value_type as its allocator");
+
     public:
         using value_type             = T;
+        using allocator_type         = Allocator;
         using pointer                = T*;
         using const_pointer          = const T*;
         using reference              = T&;
@@ -26,28 +41,78 @@ namespace Lsh {
         using difference_type        = std::ptrdiff_t;
 
     private:
+        using alloc_traits = std::allocator_traits<Allocator>;
+
+        // 元素可以按字节搬迁时，中间插入/删除时用一次 memmove 平移后半段
+        using use_memmove = use_memcpy_relocate<T, Allocator>;
+
+        // 分配器提供 reallocate 且元素可以按字节搬迁时，扩容交给分配器原地进行
+        using use_reallocate = std::integral_constant<bool, has_reallocate<Allocator>::value &&
+                                                            use_memcpy_relocate<T, Allocator>::value>;
+
+        // 分配器能直接给出全零内存、且全零字节就是值初始化的 T 时，值初始化不必逐个清零
+        using use_allocate_zeroed = std::integral_constant<bool, has_allocate_zeroed<Allocator>::value &&
+                                                                 is_zero_initializable<T>::value &&
+                                                                 uses_default_construct<Allocator>::value>;
+
         /*
          * [1 1 1 1 1 1 1 1 0 0 0 0 0 0 0 0 0 0 0]
          *  |               |                     |
          *  start          finish           end_of_storage
+         *
+         * -- 分配器与三个指针放在一起：vector_impl 继承自 Allocator，
+         *    无状态的分配器借助空基类优化(EBO)不占额外空间，sizeof(vector) 仍是三个指针
+         * -- vector_impl 析构时归还整块内存（不析构元素），
+         *    构造函数中途抛出异常时已分配的内存也不会泄漏
          */
-        pointer start_{nullptr};          // 指向第一个元素
-        pointer finish_{nullptr};         // 指向最后一个元素的下一个位置
-        pointer end_of_storage_{nullptr}; // 分配空间的末尾
+        struct vector_impl : public Allocator {
+            pointer start_{nullptr};          // 指向第一个元素
+            pointer finish_{nullptr};         // 指向最后一个元素的下一个位置
+            pointer end_of_storage_{nullptr}; // 分配空间的末尾
+
+            vector_impl() = default;
+
+            LSH_CONSTEXPR20 explicit vector_impl(const Allocator& alloc) noexcept : Allocator(alloc) {
+            }
+
+            LSH_CONSTEXPR20 explicit vector_impl(Allocator&& alloc) noexcept : Allocator(std::move(alloc)) {
+            }
+
+            LSH_CONSTEXPR20 ~vector_impl() {
+                if (start_) {
+                    alloc_traits::deallocate(*this, start_, end_of_storage_ - start_);
+                }
+            }
+        };
+
+    protected:
+        // small_vector 等派生容器需要直接调整三个指针
+        vector_impl impl_;
 
     public:
         //===============================构造函数==============================
         // 默认构造函数
         vector() = default;
 
+        LSH_CONSTEXPR20 explicit vector(const Allocator& alloc) noexcept : impl_(alloc) {
+        }
+
         // 构造拥有 count 个默认插入的 T 对象的 vector
-        explicit vector(size_type count) {
+        LSH_CONSTEXPR20 explicit vector(size_type count, const Allocator& alloc = Allocator()) : impl_(alloc) {
             count = check_init_len(count);
             default_initialize(count);
         }
 
+        // 构造拥有 count 个默认初始化的 T 对象的 vector
+        // -- 与上面不同，int 等平凡类型不会被清零，适合随后整体覆盖写入的场景
+        LSH_CONSTEXPR20 vector(size_type count, default_init_t, const Allocator& alloc = Allocator()) : impl_(alloc) {
+            count = check_init_len(count);
+            default_initialize(count, default_init);
+        }
+
         // 构造拥有 count 个值为 value 的元素的 vector
-        vector(size_type count, const_reference value) {
+        LSH_CONSTEXPR20 vector(size_type count, const_reference value, const Allocator& alloc = Allocator())
+            : impl_(alloc) {
             count = check_init_len(count);
             fill_initialize(count, value);
         }
@@ -65,51 +130,91 @@ namespace Lsh {
          * -- 实现方法来自标准库
          */
         template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
-        vector(InputIterator first, InputIterator last) {
+        LSH_CONSTEXPR20 vector(InputIterator first, InputIterator last, const Allocator& alloc = Allocator())
+            : impl_(alloc) {
             ranges_initialize(first, last, std::__iterator_category(first));
         }
 
+        // 以范围 [first,last) 的内容构造 vector，count_hint 为范围的预估长度
+        /*
+         * -- 先按 count_hint 分配内存，再单趟读取 [first,last)，不再调用 std::distance
+         * -- 适用于长度已知但迭代器不是随机访问的范围（链表、流），提示准确时只分配一次；
+         *    提示偏小时照常按 GrowthPolicy 扩容，偏大时多出的容量留作备用
+         */
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        LSH_CONSTEXPR20 vector(InputIterator first, InputIterator last, size_type count_hint,
+               const Allocator& alloc = Allocator())
+            : impl_(alloc) {
+            create_storage(check_init_len(count_hint));
+            ranges_initialize(first, last, std::input_iterator_tag());
+        }
+
         // 拷贝构造函数
-        vector(const vector& other) {
+        // -- 分配器由 select_on_container_copy_construction 决定
+        LSH_CONSTEXPR20 vector(const vector& other)
+            : impl_(alloc_traits::select_on_container_copy_construction(other.get_alloc())) {
             create_storage(check_init_len(other.size()));
-            finish_ = std::uninitialized_copy(other.begin(), other.end(), start_);
+            impl_.finish_ = uninitialized_copy_a(other.begin(), other.end(), impl_.start_, get_alloc());
+        }
+
+        LSH_CONSTEXPR20 vector(const vector& other, const Allocator& alloc) : impl_(alloc) {
+            create_storage(check_init_len(other.size()));
+            impl_.finish_ = uninitialized_copy_a(other.begin(), other.end(), impl_.start_, get_alloc());
         }
 
         /*
          * 移动构造函数
          * -- “偷走资源”,而非复制资源
          * -- 接管资源,清空源对象
+         * -- 分配器随资源一起移动
          */
-        vector(vector&& other) noexcept : start_(other.start_), finish_(other.finish_),
-                                          end_of_storage_(other.end_of_storage_) {
-            other.start_          = nullptr;
-            other.finish_         = nullptr;
-            other.end_of_storage_ = nullptr;
+        LSH_CONSTEXPR20 vector(vector&& other) noexcept : impl_(std::move(other.get_alloc())) {
+            steal_storage(other);
+        }
+
+        // 指定分配器的移动构造
+        // -- 分配器相等时直接接管资源，否则只能逐个移动元素到新分配的内存中
+        LSH_CONSTEXPR20 vector(vector&& other, const Allocator& alloc) : impl_(alloc) {
+            if (alloc_traits::is_always_equal::value || get_alloc() == other.get_alloc()) {
+                steal_storage(other);
+            } else {
+                create_storage(other.size());
+                impl_.finish_ = uninitialized_move_a(other.begin(), other.end(), impl_.start_, get_alloc());
+                other.clear();
+            }
         }
 
         // 等价于 vector(init.first,init.end)
-        vector(std::initializer_list<T> init) {
+        LSH_CONSTEXPR20 vector(std::initializer_list<T> init, const Allocator& alloc = Allocator()) : impl_(alloc) {
             create_storage(check_init_len(init.size()));
-            finish_ = std::uninitialized_copy(init.begin(), init.end(), start_);
+            impl_.finish_ = uninitialized_copy_a(init.begin(), init.end(), impl_.start_, get_alloc());
         }
 
         //===============================析构函数==================================
-        ~vector() {
-            // 析构元素
-            std::destroy(start_, finish_);
-            // 释放内存
-            using Tr = std::allocator_traits<std::allocator<T>>;
-            std::allocator<T> alloc_;
-            Tr::deallocate(alloc_, start_, size());
-            start_          = nullptr;
-            finish_         = nullptr;
-            end_of_storage_ = nullptr;
+        LSH_CONSTEXPR20 ~vector() {
+            // 析构元素，内存由 vector_impl 的析构函数释放
+            destroy_a(impl_.start_, impl_.finish_, get_alloc());
         }
 
         //============================ operator= ==================================
-        vector& operator=(const vector& other) {
+        LSH_CONSTEXPR20 vector& operator=(const vector& other) {
             // 自赋值检查
             if (std::addressof(other) != this) {
+                /*
+                 * -- 分配器需要传播且两者不相等时，旧内存必须先交给旧分配器释放
+                 * -- 之后的复制逻辑与不传播时相同
+                 */
+                if (alloc_traits::propagate_on_container_copy_assignment::value) {
+                    if (!alloc_traits::is_always_equal::value && get_alloc() != other.get_alloc()) {
+                        clear();
+                        deallocate(impl_.start_, capacity());
+                        impl_.start_          = nullptr;
+                        impl_.finish_         = nullptr;
+                        impl_.end_of_storage_ = nullptr;
+                    }
+                    alloc_on_copy(get_alloc(), other.get_alloc());
+                }
+
                 const size_type other_size = other.size();
 
                 /*
@@ -121,303 +226,324 @@ namespace Lsh {
                     pointer new_start = allocate_and_copy(other_size, other.begin(), other.end());
 
                     // 销毁当前元素并释放内存
-                    std::destroy(start_, finish_);
-                    deallocate(start_, end_of_storage_ - start_);
+                    destroy_a(impl_.start_, impl_.finish_, get_alloc());
+                    deallocate(impl_.start_, capacity());
 
                     // 更新指针和容量
-                    start_          = new_start;
-                    finish_         = new_start + other_size;
-                    end_of_storage_ = new_start + other_size;
+                    impl_.start_          = new_start;
+                    impl_.finish_         = new_start + other_size;
+                    impl_.end_of_storage_ = new_start + other_size;
                 } else {
                     // 如果目标对象更小,先销毁多余元素
                     if (size() >= other_size) {
-                        std::destroy(std::copy(other.begin(), other.end(), begin()), end());
+                        erase_at_end(std::copy(other.begin(), other.end(), begin()));
                     } else {
                         // 如果目标对象更大,扩展当前容器
                         std::copy(other.begin(), other.begin() + size(), begin());
-                        std::uninitialized_copy(other.begin() + size(), other.end(), end());
+                        uninitialized_copy_a(other.begin() + size(), other.end(), end(), get_alloc());
                     }
-                    finish_ = begin() + other_size;
+                    impl_.finish_ = begin() + other_size;
                 }
             }
             return *this;
         }
 
-        vector& operator=(vector&& other) noexcept {
+        /*
+         * -- 分配器可以传播或总是相等时，直接接管 other 的资源
+         * -- 否则只有两个分配器相等时才能接管，不相等时退化为逐个移动元素
+         */
+        LSH_CONSTEXPR20 vector& operator=(vector&& other) noexcept(
+            alloc_traits::propagate_on_container_move_assignment::value ||
+            alloc_traits::is_always_equal::value) {
             if (std::addressof(other) != this) {
-                // 释放当前资源
-                this->clear();
-                this->deallocate(this->start_, this->end_of_storage_ - this->start_);
-
-                // 转移资源
-                this->start_          = other.start_;
-                this->finish_         = other.finish_;
-                this->end_of_storage_ = other.end_of_storage_;
-
-                // 清空源对象
-                other.start_          = nullptr;
-                other.finish_         = nullptr;
-                other.end_of_storage_ = nullptr;
+                move_assign(std::move(other), std::integral_constant<bool,
+                            alloc_traits::propagate_on_container_move_assignment::value ||
+                            alloc_traits::is_always_equal::value>());
             }
             return *this;
         }
 
-        vector& operator=(std::initializer_list<value_type> ilist) {
+        LSH_CONSTEXPR20 vector& operator=(std::initializer_list<value_type> ilist) {
             // 实现同 vector& operator=(const vector& other)
             size_type ilen = ilist.size();
             if (ilen > capacity()) {
                 pointer new_start = allocate_and_copy(ilen, ilist.begin(), ilist.end());
-                std::destroy(start_, finish_);
-                deallocate(start_, end_of_storage_ - start_);
-                start_          = new_start;
-                finish_         = new_start + ilen;
-                end_of_storage_ = new_start + ilen;
+                destroy_a(impl_.start_, impl_.finish_, get_alloc());
+                deallocate(impl_.start_, capacity());
+                impl_.start_          = new_start;
+                impl_.finish_         = new_start + ilen;
+                impl_.end_of_storage_ = new_start + ilen;
             } else {
                 if (size() >= ilen) {
-                    std::destroy(std::copy(ilist.begin(), ilist.end(), begin()), end());
+                    erase_at_end(std::copy(ilist.begin(), ilist.end(), begin()));
                 } else {
                     std::copy(ilist.begin(), ilist.begin() + size(), begin());
-                    std::uninitialized_copy(ilist.begin() + size(), ilist.end(), end());
+                    uninitialized_copy_a(ilist.begin() + size(), ilist.end(), end(), get_alloc());
                 }
-                finish_ = begin() + ilen;
+                impl_.finish_ = begin() + ilen;
             }
             return *this;
         }
 
         //=============================== assign ===============================
-        void assign(size_type count, const value_type& value) {
+        LSH_CONSTEXPR20 void assign(size_type count, const value_type& value) {
             if (count > capacity()) {
                 clear();
-                deallocate(start_, end_of_storage_ - start_);
+                deallocate(impl_.start_, capacity());
+                impl_.start_ = impl_.finish_ = impl_.end_of_storage_ = nullptr;
                 create_storage(check_init_len(count));
-                fill_initialize(count, value);
+                impl_.finish_ = uninitialized_fill_n_a(impl_.start_, count, value, get_alloc());
             } else {
                 if (size() >= count) {
                     // 复制并清除掉多余部分
-                    erase_at_end(std::fill_n(start_, count, value));
+                    erase_at_end(std::fill_n(impl_.start_, count, value));
                 } else {
                     std::fill(begin(), end(), value);
                     const size_type diff = count - size();
-                    std::uninitialized_fill_n(finish_, diff, value);
-                    finish_ = start_ + count;
+                    uninitialized_fill_n_a(impl_.finish_, diff, value, get_alloc());
+                    impl_.finish_ = impl_.start_ + count;
                 }
             }
         }
 
         template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
-        void assign(InputIterator first, InputIterator last) {
+        LSH_CONSTEXPR20 void assign(InputIterator first, InputIterator last) {
             this->range_assign(first, last, std::__iterator_category(first));
         }
 
-        void assign(std::initializer_list<value_type> ilist) {
+        // count_hint 为 [first,last) 的预估长度，见带 count_hint 的构造函数
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        LSH_CONSTEXPR20 void assign(InputIterator first, InputIterator last, size_type count_hint) {
+            if (count_hint > capacity()) {
+                // 旧元素反正要被覆盖，先清空，重新分配时就不用搬迁
+                clear();
+                this->reserve(count_hint);
+            }
+            this->range_assign(first, last, std::input_iterator_tag());
+        }
+
+        LSH_CONSTEXPR20 void assign(std::initializer_list<value_type> ilist) {
             this->range_assign(ilist.begin(), ilist.end(),
                                std::random_access_iterator_tag());
         }
 
+        LSH_CONSTEXPR20 allocator_type get_allocator() const noexcept {
+            return allocator_type(get_alloc());
+        }
+
         //================================ 元素访问 =================================
         // at 带边界检查
-        reference at(size_type index) {
+        LSH_CONSTEXPR20 reference at(size_type index) {
             if (index >= size()) {
                 throw std::out_of_range("vector::at");
             }
-            return *(start_ + index);
+            return *(impl_.start_ + index);
         }
 
-        const_reference at(size_type index) const {
+        LSH_CONSTEXPR20 const_reference at(size_type index) const {
             if (index >= size()) {
                 throw std::out_of_range("vector::at");
             }
-            return *(start_ + index);
+            return *(impl_.start_ + index);
         }
 
         // operator[] 不带边界检查
-        reference operator[](size_type index) {
-            return *(start_ + index);
+        LSH_CONSTEXPR20 reference operator[](size_type index) {
+            return *(impl_.start_ + index);
         }
 
-        const_reference operator[](size_type index) const {
-            return *(start_ + index);
+        LSH_CONSTEXPR20 const_reference operator[](size_type index) const {
+            return *(impl_.start_ + index);
         }
 
-        reference front() {
-            return *start_;
+        LSH_CONSTEXPR20 reference front() {
+            return *impl_.start_;
         }
 
-        const_reference front() const {
-            return *start_;
+        LSH_CONSTEXPR20 const_reference front() const {
+            return *impl_.start_;
         }
 
-        reference back() {
-            return *(finish_ - 1);
+        LSH_CONSTEXPR20 reference back() {
+            return *(impl_.finish_ - 1);
         }
 
-        const_reference back() const {
-            return *(finish_ - 1);
+        LSH_CONSTEXPR20 const_reference back() const {
+            return *(impl_.finish_ - 1);
         }
 
-        T* data() {
-            return (start_);
+        LSH_CONSTEXPR20 T* data() {
+            return (impl_.start_);
         }
 
-        const T* data() const {
-            return (start_);
+        LSH_CONSTEXPR20 const T* data() const {
+            return (impl_.start_);
         }
 
         //================================ 迭代器 ==================================
-        iterator begin() noexcept {
-            return iterator(start_);
+        LSH_CONSTEXPR20 iterator begin() noexcept {
+            return iterator(impl_.start_);
         }
 
-        const_iterator begin() const noexcept {
-            return const_iterator(start_);
+        LSH_CONSTEXPR20 const_iterator begin() const noexcept {
+            return const_iterator(impl_.start_);
         }
 
-        const_iterator cbegin() const noexcept {
-            return const_iterator(start_);
+        LSH_CONSTEXPR20 const_iterator cbegin() const noexcept {
+            return const_iterator(impl_.start_);
         }
 
-        iterator end() noexcept {
-            return iterator(finish_);
+        LSH_CONSTEXPR20 iterator end() noexcept {
+            return iterator(impl_.finish_);
         }
 
-        const_iterator end() const noexcept {
-            return const_iterator(finish_);
+        LSH_CONSTEXPR20 const_iterator end() const noexcept {
+            return const_iterator(impl_.finish_);
         }
 
-        const_iterator cend() const noexcept {
-            return const_iterator(finish_);
+        LSH_CONSTEXPR20 const_iterator cend() const noexcept {
+            return const_iterator(impl_.finish_);
         }
 
-        reverse_iterator rbegin() noexcept {
+        LSH_CONSTEXPR20 reverse_iterator rbegin() noexcept {
             return reverse_iterator(end());
         }
 
-        const_reverse_iterator rbegin() const noexcept {
+        LSH_CONSTEXPR20 const_reverse_iterator rbegin() const noexcept {
             return const_reverse_iterator(end());
         }
 
-        const_reverse_iterator crbegin() const noexcept {
+        LSH_CONSTEXPR20 const_reverse_iterator crbegin() const noexcept {
             return const_reverse_iterator(end());
         }
 
-        reverse_iterator rend() noexcept {
+        LSH_CONSTEXPR20 reverse_iterator rend() noexcept {
             return reverse_iterator(begin());
         }
 
-        reverse_iterator rend() const noexcept {
+        LSH_CONSTEXPR20 reverse_iterator rend() const noexcept {
             return const_reverse_iterator(begin());
         }
 
-        const_reverse_iterator crend() const noexcept {
+        LSH_CONSTEXPR20 const_reverse_iterator crend() const noexcept {
             return const_reverse_iterator(begin());
         }
 
         //==================================== 容量 ================================
-        [[nodiscard]] bool empty() const {
-            return finish_ == start_;
+        [[nodiscard]] LSH_CONSTEXPR20 bool empty() const {
+            return impl_.finish_ == impl_.start_;
         }
 
-        [[nodiscard]] size_type size() const {
-            return size_type(finish_ - start_);
+        [[nodiscard]] LSH_CONSTEXPR20 size_type size() const {
+            return size_type(impl_.finish_ - impl_.start_);
         }
 
         // 能分配的最大内存
-        [[nodiscard]] size_type max_size() const {
-            using Tr           = std::allocator_traits<std::allocator<T>>;
+        [[nodiscard]] LSH_CONSTEXPR20 size_type max_size() const {
             size_type diffmax  = std::numeric_limits<ptrdiff_t>::max() / sizeof(T);
-            size_type allocmax = Tr::max_size(std::allocator<T>());
+            size_type allocmax = alloc_traits::max_size(get_alloc());
             return std::min(diffmax, allocmax);
         }
 
         // 增加 vector 的容量（即 vector 在不重新分配存储的情况下能最多能持有的元素的数量）
         // 到大于或等于 new_cap 的值。如果 new_cap 大于当前的 capacity()，
         // 那么就会分配新存储，否则该方法不做任何事。
-        // 这里的实现标准库有内存迁移的部分，有点复杂，仅采用传统方式
-        void reserve(size_type new_cap) {
+        // 元素通过 relocate_a 迁移：可平凡重定位的类型整体 memcpy，否则逐个移动再析构
+        LSH_CONSTEXPR20 void reserve(size_type new_cap) {
             if (new_cap > this->max_size()) {
                 throw std::length_error("vector::reserve(): new capacity too large");
             }
             // 重新分配
             if (this->capacity() < new_cap) {
-                size_type old_size = this->size();
-                pointer temp       = allocate_and_copy(new_cap, this->start_, this->finish_);
-                std::destroy(this->start_, this->finish_);
-                deallocate(this->start_, this->end_of_storage_ - this->start_);
-                this->start_          = temp;
-                this->finish_         = temp + old_size;
-                this->end_of_storage_ = temp + new_cap;
+                this->reallocate_storage(new_cap, use_reallocate());
             }
         }
 
-        [[nodiscard]] size_type capacity() const {
-            return size_type(end_of_storage_ - start_);
+        [[nodiscard]] LSH_CONSTEXPR20 size_type capacity() const {
+            return size_type(impl_.end_of_storage_ - impl_.start_);
         }
 
         //请求移除未使用的容量。
         //它是减少 capacity() 到 size() 的非强制性请求。
-        void shrink_to_fit() {
+        // -- 分配器只接受整块归还，不能只释放 [finish,end_of_storage) 这一段，
+        //    所以重新分配一块恰好放下所有元素的内存
+        LSH_CONSTEXPR20 void shrink_to_fit() {
             if (this->capacity() > this->size()) {
-                deallocate(this->finish_, this->end_of_storage_ - this->finish_);
-                this->end_of_storage_ = this->finish_;
+                this->reallocate_storage(this->size(), use_reallocate());
             }
         }
 
         //======================================================================
         //-------------------------------- 修改器 -------------------------------
         //======================================================================
-        void clear() {
-            erase_at_end(start_);
+        LSH_CONSTEXPR20 void clear() {
+            erase_at_end(impl_.start_);
         }
 
         //================================ insert ===============================
-        iterator insert(const_iterator pos, const value_type& value) {
+        LSH_CONSTEXPR20 iterator insert(const_iterator pos, const value_type& value) {
             const auto diff = pos - cbegin();
             // 内存够,不扩容插入
-            if (this->finish_ != this->end_of_storage_) {
+            if (impl_.finish_ != impl_.end_of_storage_) {
                 // 使用 begin() + (position - cbegin()) 保持类型兼容
                 this->unrealloc_insert(begin() + (pos - cbegin()), value);
             } else {
                 // 内存不够,扩容插入
                 this->realloc_insert(begin() + (pos - cbegin()), value);
             }
-            return iterator(this->start_ + diff);
+            return iterator(impl_.start_ + diff);
         }
 
-        iterator insert(const_iterator pos, value_type&& value) {
+        LSH_CONSTEXPR20 iterator insert(const_iterator pos, value_type&& value) {
             const auto diff = pos - cbegin();
-            if (this->finish_ != this->end_of_storage_) {
+            if (impl_.finish_ != impl_.end_of_storage_) {
                 this->unrealloc_insert(begin() + (pos - cbegin()), std::move(value));
             } else {
                 this->realloc_insert(begin() + (pos - cbegin()), std::move(value));
             }
-            return iterator(this->start_ + diff);
+            return iterator(impl_.start_ + diff);
         }
 
-        iterator insert(const_iterator pos, size_type count, const value_type& value) {
+        LSH_CONSTEXPR20 iterator insert(const_iterator pos, size_type count, const value_type& value) {
             const auto diff = pos - cbegin();
             this->fill_insert(begin() + diff, count, value);
-            return iterator(this->start_ + diff);
+            return iterator(impl_.start_ + diff);
         }
 
         template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
-        iterator insert(const_iterator position, InputIterator first, InputIterator last) {
+        LSH_CONSTEXPR20 iterator insert(const_iterator position, InputIterator first, InputIterator last) {
             const auto diff = position - cbegin();
             this->range_insert(begin() + diff, first, last, std::__iterator_category(first));
-            return iterator(this->start_ + diff);
+            return iterator(impl_.start_ + diff);
+        }
+
+        // count_hint 为 [first,last) 的预估长度，见带 count_hint 的构造函数
+        template<class InputIterator, typename = std::_RequireInputIter<InputIterator>>
+        LSH_CONSTEXPR20 iterator insert(const_iterator position, InputIterator first, InputIterator last,
+                                        size_type count_hint) {
+            const auto diff = position - cbegin();
+            if (count_hint > size_type(impl_.end_of_storage_ - impl_.finish_)) {
+                if (count_hint > max_size() - size()) {
+                    throw std::length_error("vector::insert(): count_hint too large");
+                }
+                this->reserve(size() + count_hint);
+            }
+            this->range_insert(begin() + diff, first, last, std::input_iterator_tag());
+            return iterator(impl_.start_ + diff);
         }
 
-        iterator insert(const_iterator position, std::initializer_list<value_type> ilist) {
+        LSH_CONSTEXPR20 iterator insert(const_iterator position, std::initializer_list<value_type> ilist) {
             const auto diff = position - cbegin();
             this->range_insert(begin() + diff, ilist.begin(), ilist.end(),
                                std::random_access_iterator_tag());
-            return iterator(this->start_ + diff);
+            return iterator(impl_.start_ + diff);
         }
 
         //====================================== emplace =====================================
         template<class... Args>
-        void emplace(const_iterator position, Args&&... args) {
+        LSH_CONSTEXPR20 void emplace(const_iterator position, Args&&... args) {
             // 与 insert() 相同
-            if (this->finish_ != this->end_of_storage_) {
+            if (impl_.finish_ != impl_.end_of_storage_) {
                 this->unrealloc_insert(begin() + (position - cbegin()), std::forward<Args>(args)...);
             } else {
                 this->realloc_insert(begin() + (position - cbegin()), std::forward<Args>(args)...);
@@ -425,12 +551,10 @@ namespace Lsh {
         }
 
         template<class... Args>
-        void emplace_back(Args&&... args) {
-            if (this->finish_ != this->end_of_storage_) {
-                typedef std::allocator_traits<std::allocator<T>> Tr;
-                std::allocator<value_type> alloc_;
-                Tr::construct(alloc_, this->finish_, std::forward<Args>(args)...);
-                ++this->finish_;
+        LSH_CONSTEXPR20 void emplace_back(Args&&... args) {
+            if (impl_.finish_ != impl_.end_of_storage_) {
+                alloc_traits::construct(get_alloc(), impl_.finish_, std::forward<Args>(args)...);
+                ++impl_.finish_;
             } else {
                 this->realloc_insert(end(), std::forward<Args>(args)...);
             }
@@ -439,10 +563,9 @@ namespace Lsh {
         // C++17 起返回最后一个元素的引用
         /*template<class... Args>
         reference emplace_back(Args&&... args) {
-            if (this->finish_ != this->end_of_storage_) {
-                typedef std::iterator_traits<std::allocator<T>> Tr;
-                std::allocator<T> alloc_;
-                Tr::construct(alloc_, this->finish_, std::forward<Args>(args)...);
+            if (impl_.finish_ != impl_.end_of_storage_) {
+                alloc_traits::construct(get_alloc(), impl_.finish_, std::forward<Args>(args)...);
+                ++impl_.finish_;
             } else {
                 this->realloc_insert(end(), std::forward<Args>(args)...);
             }
@@ -450,57 +573,43 @@ namespace Lsh {
         }*/
 
         //=================================== erase ==========================================
-        iterator erase(const_iterator pos) {
+        LSH_CONSTEXPR20 iterator erase(const_iterator pos) {
             // 转换迭代器类型
             iterator pos_ = begin() + (pos - cbegin());
-            if ((pos_ + 1) != end()) {
-                // [pos + 1,end()) 的元素正序依次复制到 {pos, pos++ ...}
-                std::move(pos_ + 1, end(), pos_);
-            }
-            --this->finish_;
-            using Tr = std::allocator_traits<std::allocator<T>>;
-            std::allocator<value_type> alloc_;
-            Tr::destroy(alloc_, this->finish_);
+            this->erase_aux(pos_, pos_ + 1, use_memmove());
             return pos_;
         }
 
-        iterator erase(const_iterator first, const_iterator last) {
+        LSH_CONSTEXPR20 iterator erase(const_iterator first, const_iterator last) {
             iterator first_ = begin() + (first - cbegin());
             iterator last_  = begin() + (last - cbegin());
             if (first_ != last_) {
-                if (last_ != end()) {
-                    std::move(last_, end(), first_);
-                }
-                this->erase_at_end(first_ + (end() - last_));
+                this->erase_aux(first_, last_, use_memmove());
             }
             return first_;
         }
 
         //=================================== pop/push_back =================================
-        void push_back(const value_type& value) {
-            if (this->finish_ != this->end_of_storage_) {
-                using Tr = std::allocator_traits<std::allocator<T>>;
-                std::allocator<value_type> alloc_;
-                Tr::construct(alloc_, this->finish_, value);
-                ++this->finish_;
+        LSH_CONSTEXPR20 void push_back(const value_type& value) {
+            if (impl_.finish_ != impl_.end_of_storage_) {
+                alloc_traits::construct(get_alloc(), impl_.finish_, value);
+                ++impl_.finish_;
             } else {
                 this->realloc_insert(end(), value);
             }
         }
 
-        void push_back(value_type&& value) {
+        LSH_CONSTEXPR20 void push_back(value_type&& value) {
             emplace_back(std::move(value));
         }
 
-        void pop_back() {
-            --this->finish_;
-            using Tr = std::allocator_traits<std::allocator<T>>;
-            std::allocator<value_type> alloc_;
-            Tr::destroy(alloc_, this->finish_);
+        LSH_CONSTEXPR20 void pop_back() {
+            --impl_.finish_;
+            alloc_traits::destroy(get_alloc(), impl_.finish_);
         }
 
         //====================================== resize ========================================
-        void resize(size_type new_size) {
+        LSH_CONSTEXPR20 void resize(size_type new_size) {
             if (new_size > this->size()) {
                 const size_type diff = new_size - this->size();
                 this->default_append(diff);
@@ -509,246 +618,594 @@ namespace Lsh {
             }
         }
 
-        void resize(size_type new_size, const value_type& value) {
+        // 新增的元素默认初始化，平凡类型不清零
+        LSH_CONSTEXPR20 void resize(size_type new_size, default_init_t) {
+            if (new_size > this->size()) {
+                this->default_append(new_size - this->size(), default_init);
+            } else if (new_size < this->size()) {
+                erase_at_end(begin() + new_size);
+            }
+        }
+
+        LSH_CONSTEXPR20 void resize(size_type new_size, const value_type& value) {
             if (new_size > this->size()) {
                 insert(end(), new_size - size(), value);
             } else if (new_size < this->size()) {
-                erase_at_end(this->start_ + new_size);
+                erase_at_end(impl_.start_ + new_size);
+            }
+        }
+
+        /*
+         * 在末尾追加 count 个默认初始化的元素，返回指向第一个新元素的指针
+         * -- 平凡类型的新元素内容未定义，由调用者直接写入，省掉一次清零
+         */
+        LSH_CONSTEXPR20 pointer append_uninitialized(size_type count) {
+            const size_type old_size = this->size();
+            this->default_append(count, default_init);
+            return impl_.start_ + old_size;
+        }
+
+        /*
+         * 把 size 改为 op 的返回值，让 op 直接在原始内存上写入
+         * -- 先保证容量至少为 count，然后调用 op(data(), count)
+         * -- op 写入 [data(), data() + r) 并返回 r，r 成为新的 size()；r > count 时抛出 length_error，size 不变
+         * -- 只对平凡可复制类型开放：新增部分无需构造，缩小时也无需析构
+         */
+        template<class Operation>
+        LSH_CONSTEXPR20 void resize_and_overwrite(size_type count, Operation op) {
+            static_assert(std::is_trivially_copyable<T>::value,
+                          "resize_and_overwrite requires a trivially copyable value_type");
+            if (count > this->capacity()) {
+                this->reserve(count);
+            }
+            const size_type new_size = static_cast<size_type>(std::move(op)(impl_.start_, count));
+            if (new_size > count) {
+                throw std::length_error("vector::resize_and_overwrite(): op returned more than count");
             }
+            impl_.finish_ = impl_.start_ + new_size;
         }
 
         //====================================== swap ============================================
-        void swap(vector& other) noexcept {
+        // 分配器只在 propagate_on_container_swap 为真时交换
+        LSH_CONSTEXPR20 void swap(vector& other) noexcept {
             using std::swap;  // 确保使用标准库的swap，避免可能的递归问题
-            swap(start_, other.start_);
-            swap(finish_, other.finish_);
-            swap(end_of_storage_, other.end_of_storage_);
+            swap(impl_.start_, other.impl_.start_);
+            swap(impl_.finish_, other.impl_.finish_);
+            swap(impl_.end_of_storage_, other.impl_.end_of_storage_);
+            alloc_on_swap(get_alloc(), other.get_alloc());
+        }
+
+        /*
+         * 把全部元素连同内存交给 reclaimer（例如 Lsh::deferred_reclaimer），
+         * 由它在后台线程或空闲时分批析构、释放，调用后 vector 为空且不占内存
+         * -- 只转移三个指针和一份分配器副本，大 vector 的析构开销离开当前线程
+         * -- reclaimer.adopt 抛出异常时 vector 保持原样
+         */
+        template<class Reclaimer>
+        LSH_CONSTEXPR20 void release_to(Reclaimer& reclaimer) {
+            if (impl_.start_) {
+                reclaimer.adopt(get_alloc(), impl_.start_, impl_.finish_, this->capacity());
+                impl_.start_          = nullptr;
+                impl_.finish_         = nullptr;
+                impl_.end_of_storage_ = nullptr;
+            }
         }
 
     private:
         //==========================工具函数=======================
+        LSH_CONSTEXPR20 Allocator& get_alloc() noexcept {
+            return impl_;
+        }
+
+        LSH_CONSTEXPR20 const Allocator& get_alloc() const noexcept {
+            return impl_;
+        }
+
         // 分配大小为 count 的内存
-        pointer allocate(size_type count) {
-            using Tr = std::allocator_traits<std::allocator<T>>;
-            std::allocator<T> alloc_;
-            return count != 0 ? Tr::allocate(alloc_, count) : pointer();
+        LSH_CONSTEXPR20 pointer allocate(size_type count) {
+            return count != 0 ? alloc_traits::allocate(get_alloc(), count) : pointer();
+        }
+
+        /*
+         * 分配至少 count 个元素的内存
+         * -- 分配器支持 allocate_at_least 时，返回的 count 是内存块实际能放下的元素个数，
+         *    malloc 向上取整多出来的部分直接算作容量，不必等下一次扩容
+         */
+        LSH_CONSTEXPR20 allocation_result<pointer, size_type> allocate_at_least(size_type count) {
+            if (count == 0) {
+                return {pointer(), 0};
+            }
+            return Lsh::allocate_at_least(get_alloc(), count);
         }
 
         // 回收内存
-        void deallocate(pointer p, size_type count) {
-            using Tr = std::allocator_traits<std::allocator<T>>;
+        LSH_CONSTEXPR20 void deallocate(pointer p, size_type count) {
             if (p) {
-                std::allocator<value_type> alloc_;
-                Tr::deallocate(alloc_, p, count);
+                alloc_traits::deallocate(get_alloc(), p, count);
+            }
+        }
+
+        // 接管 other 的内存，other 置空
+        LSH_CONSTEXPR20 void steal_storage(vector& other) noexcept {
+            impl_.start_                = other.impl_.start_;
+            impl_.finish_               = other.impl_.finish_;
+            impl_.end_of_storage_       = other.impl_.end_of_storage_;
+            other.impl_.start_          = nullptr;
+            other.impl_.finish_         = nullptr;
+            other.impl_.end_of_storage_ = nullptr;
+        }
+
+        // 可以接管资源：释放当前资源，必要时移动分配器
+        LSH_CONSTEXPR20 void move_assign(vector&& other, std::true_type) {
+            // 释放当前资源
+            this->clear();
+            this->deallocate(impl_.start_, capacity());
+            alloc_on_move(get_alloc(), other.get_alloc());
+            // 转移资源并清空源对象
+            steal_storage(other);
+        }
+
+        // 分配器不传播：相等时仍可接管，否则逐个移动元素
+        LSH_CONSTEXPR20 void move_assign(vector&& other, std::false_type) {
+            if (get_alloc() == other.get_alloc()) {
+                move_assign(std::move(other), std::true_type());
+            } else {
+                this->assign(std::make_move_iterator(other.begin()),
+                             std::make_move_iterator(other.end()));
+                other.clear();
             }
         }
 
         // 为 vector 创建大小为 count 的内存空间，未构造元素
-        void create_storage(size_type count) {
-            start_          = allocate(count);
-            finish_         = start_;
-            end_of_storage_ = start_ + count;
+        LSH_CONSTEXPR20 void create_storage(size_type count) {
+            const auto storage    = allocate_at_least(count);
+            impl_.start_          = storage.ptr;
+            impl_.finish_         = impl_.start_;
+            impl_.end_of_storage_ = impl_.start_ + storage.count;
         }
 
         // 分配大小为 count 的内存空间,并把 [first,last) 的元素复制进去
         template<class ForwardIterator>
-        pointer allocate_and_copy(size_type count, ForwardIterator first, ForwardIterator last) {
+        LSH_CONSTEXPR20 pointer allocate_and_copy(size_type count, ForwardIterator first, ForwardIterator last) {
             pointer result = this->allocate(count);
-            std::uninitialized_copy(first, last, result);
+            try {
+                uninitialized_copy_a(first, last, result, get_alloc());
+            } catch (...) {
+                deallocate(result, count);
+                throw;
+            }
             return result;
         }
 
         // 把 [first,last) 内的元素赋值给 vector, 被 assign 调用
+        // -- 单趟迭代器：先逐个覆盖已有元素，剩下的部分删掉或者追加到末尾
+        template<class InputIterator>
+        LSH_CONSTEXPR20 void range_assign(InputIterator first, InputIterator last, std::input_iterator_tag) {
+            pointer cur = impl_.start_;
+            for (; first != last && cur != impl_.finish_; ++first, ++cur) {
+                *cur = *first;
+            }
+            if (first == last) {
+                erase_at_end(cur);
+            } else {
+                this->range_append(first, last);
+            }
+        }
+
         template<class ForwardIterator>
-        void range_assign(ForwardIterator first, ForwardIterator last, std::forward_iterator_tag) {
+        LSH_CONSTEXPR20 void range_assign(ForwardIterator first, ForwardIterator last, std::forward_iterator_tag) {
             const size_type len = std::distance(first, last);
             if (len > capacity()) {
                 check_init_len(len);
                 pointer new_start = allocate_and_copy(len, first, last);
-                std::destroy(start_, finish_);
-                deallocate(start_, end_of_storage_ - start_);
+                destroy_a(impl_.start_, impl_.finish_, get_alloc());
+                deallocate(impl_.start_, capacity());
 
-                start_          = new_start;
-                finish_         = new_start + len;
-                end_of_storage_ = new_start + len;
+                impl_.start_          = new_start;
+                impl_.finish_         = new_start + len;
+                impl_.end_of_storage_ = new_start + len;
             } else {
                 if (size() >= len) {
-                    erase_at_end(std::copy(first, last, this->start_));
+                    erase_at_end(std::copy(first, last, impl_.start_));
                 } else {
                     /* 不要用 first + size() ,会导致类型不兼容*/
-                    // std::copy(first, first + size(), this->start_);
-                    // finish_ = std::uninitialized_copy(first + size(), last, this->finish_);
+                    // std::copy(first, first + size(), impl_.start_);
+                    // impl_.finish_ = std::uninitialized_copy(first + size(), last, impl_.finish_);
                     ForwardIterator mid = first;
                     std::advance(mid, size());
-                    std::copy(first, mid, this->start_);
-                    finish_ = std::uninitialized_copy(mid, last, this->finish_);
+                    std::copy(first, mid, impl_.start_);
+                    impl_.finish_ = uninitialized_copy_a(mid, last, impl_.finish_, get_alloc());
                 }
             }
         }
 
         // 清除 [position,finish) 的元素
-        void erase_at_end(pointer position) {
-            if (size_type(finish_ - position)) {
-                std::destroy(position, finish_);
-                finish_ = position;
+        LSH_CONSTEXPR20 void erase_at_end(pointer position) {
+            if (size_type(impl_.finish_ - position)) {
+                destroy_a(position, impl_.finish_, get_alloc());
+                impl_.finish_ = position;
+            }
+        }
+
+        // 按字节把 [first,last) 搬到 dest，两段区间可以重叠；只用于 use_memmove 为真的元素
+        // -- 以下各个 std::true_type 版本在常量求值中都转交 std::false_type 版本：
+        //    编译期不能按字节搬迁对象，也不能调用 reallocate 等分配器扩展
+        static void memmove_elements(pointer dest, pointer first, pointer last) {
+            std::memmove(static_cast<void*>(dest), static_cast<const void*>(first),
+                         (last - first) * sizeof(T));
+        }
+
+        /*
+         * 在栈上的原始内存中通过分配器构造一个临时元素，离开作用域时析构
+         * -- 插入的值可能引用 vector 自身的元素，平移之后那个位置就变了，所以先复制出来
+         * -- 常量求值中不能把字节数组当作 T 使用，改为向分配器要一个元素的空间
+         */
+        struct temporary_value {
+            vector* owner_;
+            pointer value_;
+            alignas(T) unsigned char storage_[sizeof(T)];
+
+            template<class... Args>
+            LSH_CONSTEXPR20 explicit temporary_value(vector* owner, Args&&... args) : owner_(owner) {
+                if (Lsh::is_constant_evaluated()) {
+                    value_ = alloc_traits::allocate(owner_->get_alloc(), 1);
+                } else {
+                    value_ = reinterpret_cast<pointer>(storage_);
+                }
+                try {
+                    alloc_traits::construct(owner_->get_alloc(), value_, std::forward<Args>(args)...);
+                } catch (...) {
+                    release();
+                    throw;
+                }
+            }
+
+            temporary_value(const temporary_value&) = delete;
+
+            temporary_value& operator=(const temporary_value&) = delete;
+
+            LSH_CONSTEXPR20 ~temporary_value() {
+                alloc_traits::destroy(owner_->get_alloc(), value_);
+                release();
+            }
+
+            LSH_CONSTEXPR20 pointer get() noexcept {
+                return value_;
             }
+
+            LSH_CONSTEXPR20 void release() noexcept {
+                if (Lsh::is_constant_evaluated()) {
+                    alloc_traits::deallocate(owner_->get_alloc(), value_, 1);
+                }
+            }
+        };
+
+        // 删除 [first,last)：后半段整体 memmove 到 first
+        LSH_CONSTEXPR20 void erase_aux(pointer first, pointer last, std::true_type) {
+            if (Lsh::is_constant_evaluated()) {
+                return erase_aux(first, last, std::false_type());
+            }
+            destroy_a(first, last, get_alloc());
+            memmove_elements(first, last, impl_.finish_);
+            impl_.finish_ -= (last - first);
+        }
+
+        // 删除 [first,last)：后半段依次移动赋值到 first，再析构末尾多出的元素
+        LSH_CONSTEXPR20 void erase_aux(pointer first, pointer last, std::false_type) {
+            if (last != end()) {
+                std::move(last, end(), first);
+            }
+            this->erase_at_end(first + (end() - last));
         }
 
         // 对 vector 进行不扩容插入
         template<class... Args>
-        void unrealloc_insert(iterator position, Args&&... args) {
-            using Tr = std::allocator_traits<std::allocator<T>>;
-            std::allocator<value_type> alloc_;
+        LSH_CONSTEXPR20 void unrealloc_insert(iterator position, Args&&... args) {
             if (position == end()) {
-                Tr::construct(alloc_, this->finish_, std::forward<Args>(args)...);
-                ++this->finish_;
+                alloc_traits::construct(get_alloc(), impl_.finish_, std::forward<Args>(args)...);
+                ++impl_.finish_;
             } else {
-                Tr::construct(alloc_, this->finish_, *(this->finish_ - 1));
-                for (iterator it = end() - 1; it != position; --it) {
-                    *it = *(it - 1);
-                }
-                Tr::destroy(alloc_, position);
-                Tr::construct(alloc_, position, std::forward<Args>(args)...);
-                ++this->finish_;
+                this->unrealloc_insert_aux(use_memmove(), position, std::forward<Args>(args)...);
             }
         }
 
+        /*
+         * 可按字节搬迁的元素：
+         * -- 先把新元素构造在临时空间，再用一次 memmove 把 [position,finish) 后移一位，
+         *    最后把新元素按字节放进 position，不调用任何拷贝/移动/析构
+         */
+        template<class... Args>
+        LSH_CONSTEXPR20 void unrealloc_insert_aux(std::true_type, iterator position, Args&&... args) {
+            if (Lsh::is_constant_evaluated()) {
+                return unrealloc_insert_aux(std::false_type(), position, std::forward<Args>(args)...);
+            }
+            alignas(T) unsigned char temp[sizeof(T)];
+            pointer value = reinterpret_cast<pointer>(temp);
+            alloc_traits::construct(get_alloc(), value, std::forward<Args>(args)...);
+            memmove_elements(position + 1, position, impl_.finish_);
+            std::memcpy(static_cast<void*>(position), static_cast<const void*>(value), sizeof(T));
+            ++impl_.finish_;
+        }
+
+        /*
+         * 其他元素：
+         * -- 用最后一个元素移动构造出新的末尾，[position,finish - 1) 倒序移动赋值后移一位，
+         *    最后把临时对象移动赋值到 position
+         */
+        template<class... Args>
+        LSH_CONSTEXPR20 void unrealloc_insert_aux(std::false_type, iterator position, Args&&... args) {
+            temporary_value temp(this, std::forward<Args>(args)...);
+            pointer old_finish = impl_.finish_;
+            alloc_traits::construct(get_alloc(), old_finish, std::move(*(old_finish - 1)));
+            ++impl_.finish_;
+            std::move_backward(position, old_finish - 1, old_finish);
+            *position = std::move(*temp.get());
+        }
+
+        // 把容量改为（至少）new_capacity，元素整体迁移到新内存
+        LSH_CONSTEXPR20 void reallocate_storage(size_type new_capacity, std::false_type) {
+            const size_type old_size = this->size();
+            const auto storage       = allocate_at_least(new_capacity);
+            relocate_a(impl_.start_, impl_.finish_, storage.ptr, get_alloc());
+            deallocate(impl_.start_, capacity());
+            impl_.start_          = storage.ptr;
+            impl_.finish_         = storage.ptr + old_size;
+            impl_.end_of_storage_ = storage.ptr + storage.count;
+        }
+
+        // 由分配器 reallocate：realloc 能原地扩展，mremap 只重新映射页面，都不逐个搬迁元素
+        LSH_CONSTEXPR20 void reallocate_storage(size_type new_capacity, std::true_type) {
+            if (Lsh::is_constant_evaluated()) {
+                return reallocate_storage(new_capacity, std::false_type());
+            }
+            const size_type old_size = this->size();
+            pointer new_start        = get_alloc().reallocate(impl_.start_, capacity(), new_capacity);
+            impl_.start_             = new_start;
+            impl_.finish_            = new_start + old_size;
+            impl_.end_of_storage_    = new_start + new_capacity;
+        }
+
         // 对 vector 进行扩容插入
         template<class... Args>
-        void realloc_insert(iterator position, Args&&... args) {
-            // 扩容
+        LSH_CONSTEXPR20 void realloc_insert(iterator position, Args&&... args) {
+            this->realloc_insert_aux(use_reallocate(), position, std::forward<Args>(args)...);
+        }
+
+        /*
+         * 原地扩容插入
+         * -- args 可能引用 vector 自身的元素，reallocate 之后旧地址失效，
+         *    所以先把新元素构造在栈上的临时空间里，扩容后再按字节搬到 position
+         */
+        template<class... Args>
+        LSH_CONSTEXPR20 void realloc_insert_aux(std::true_type, iterator position, Args&&... args) {
+            if (Lsh::is_constant_evaluated()) {
+                return realloc_insert_aux(std::false_type(), position, std::forward<Args>(args)...);
+            }
             const size_type new_capacity = check_len(size_type(1), "vector::realloc_insert()");
-            pointer old_start            = this->start_;
-            pointer old_finish           = this->finish_;
             const size_type elems_before = position - begin();
-            pointer new_start            = allocate(new_capacity);
+
+            alignas(T) unsigned char temp[sizeof(T)];
+            pointer value = reinterpret_cast<pointer>(temp);
+            alloc_traits::construct(get_alloc(), value, std::forward<Args>(args)...);
+            try {
+                this->reallocate_storage(new_capacity, std::true_type());
+            } catch (...) {
+                alloc_traits::destroy(get_alloc(), value);
+                throw;
+            }
+
+            pointer pos = impl_.start_ + elems_before;
+            memmove_elements(pos + 1, pos, impl_.finish_);
+            std::memcpy(static_cast<void*>(pos), static_cast<const void*>(value), sizeof(T));
+            ++impl_.finish_;
+        }
+
+        template<class... Args>
+        LSH_CONSTEXPR20 void realloc_insert_aux(std::false_type, iterator position, Args&&... args) {
+            // 扩容
+            const auto storage           = allocate_at_least(check_len(size_type(1), "vector::realloc_insert()"));
+            pointer old_start            = impl_.start_;
+            pointer old_finish           = impl_.finish_;
+            const size_type elems_before = position - begin();
+            pointer new_start            = storage.ptr;
 
             // 构造新元素
-            typedef std::allocator_traits<std::allocator<T>> Tr;
-            std::allocator<value_type> alloc_;
-            Tr::construct(alloc_, new_start + elems_before, std::forward<Args>(args)...);
+            alloc_traits::construct(get_alloc(), new_start + elems_before, std::forward<Args>(args)...);
 
-            pointer new_finish = std::uninitialized_move(old_start, position, new_start);
+            // 把旧元素搬到新内存：可平凡重定位的类型直接 memcpy，旧内存不必再析构
+            pointer new_finish = relocate_a(old_start, position, new_start, get_alloc());
             ++new_finish;
-            new_finish = std::uninitialized_move(position, old_finish, new_finish);
+            new_finish = relocate_a(position, old_finish, new_finish, get_alloc());
 
-            std::destroy(old_start, old_finish);
-            deallocate(old_start, end_of_storage_ - old_start);
+            deallocate(old_start, impl_.end_of_storage_ - old_start);
 
-            this->start_          = new_start;
-            this->finish_         = new_finish;
-            this->end_of_storage_ = new_start + new_capacity;
+            impl_.start_          = new_start;
+            impl_.finish_         = new_finish;
+            impl_.end_of_storage_ = new_start + storage.count;
         }
 
-        void fill_insert(iterator position, size_type count, const value_type& value) {
+        LSH_CONSTEXPR20 void fill_insert(iterator position, size_type count, const value_type& value) {
             if (count != 0) {
                 // 不需要扩容
-                if (size_type(this->end_of_storage_ - this->finish_) > count) {
-                    const size_type elems_after = finish_ - position;
-                    pointer old_finish          = this->finish_;
-                    if (elems_after > count) {
-                        std::uninitialized_move(old_finish - count, old_finish, old_finish);
-                        this->finish_ = old_finish + count;
-                        // 将 [position,old_finish - count) 的元素倒序依次复制到 {old_finish,old_finish-- ...}
-                        // 1111111 123456789abcdefgh 00000000000000000000000
-                        //        |                 |
-                        //   position          old_finish      count = 5
-                        // 1111111 12345123456789abc 00000000000000000000000
-                        std::move_backward(position, old_finish - count, old_finish);
-                        std::fill(position, position + count, value);
-                    } else {
-                        this->finish_ = std::uninitialized_fill_n(old_finish, count - elems_after, value);
-                        std::uninitialized_move(position, old_finish, this->finish_);
-                        this->finish_ += elems_after;
-                        std::fill(position, old_finish, value);
-                    }
+                if (size_type(impl_.end_of_storage_ - impl_.finish_) >= count) {
+                    // value 可能引用 vector 自身的元素，先复制一份
+                    temporary_value temp(this, value);
+                    this->fill_insert_aux(position, count, *temp.get(), use_memmove());
                 } else {
                     // 扩容,实现方法类似 realloc_insert
-                    const size_type new_capacity = check_len(size_type(count), "vector::fill_insert()");
-                    pointer old_start            = this->start_;
-                    pointer old_finish           = this->finish_;
-                    pointer new_start            = allocate(new_capacity);
+                    const auto storage           = allocate_at_least(check_len(count, "vector::fill_insert()"));
+                    pointer old_start            = impl_.start_;
+                    pointer old_finish           = impl_.finish_;
+                    pointer new_start            = storage.ptr;
                     const size_type elems_before = position - begin();
 
-                    std::uninitialized_fill_n(new_start + elems_before, count, value);
-                    pointer new_finish = std::uninitialized_move(old_start, position, new_start);
+                    uninitialized_fill_n_a(new_start + elems_before, count, value, get_alloc());
+                    pointer new_finish = relocate_a(old_start, position, new_start, get_alloc());
                     new_finish += count;
-                    new_finish = std::uninitialized_move(position, old_finish, new_finish);
+                    new_finish = relocate_a(position, old_finish, new_finish, get_alloc());
 
-                    std::destroy(old_start, old_finish);
-                    deallocate(old_start, end_of_storage_ - old_start);
+                    deallocate(old_start, impl_.end_of_storage_ - old_start);
 
-                    this->start_          = new_start;
-                    this->finish_         = new_finish;
-                    this->end_of_storage_ = new_start + new_capacity;
+                    impl_.start_          = new_start;
+                    impl_.finish_         = new_finish;
+                    impl_.end_of_storage_ = new_start + storage.count;
                 }
             }
         }
 
+        // 不扩容插入 count 个 value：后半段整体 memmove 后移，空出的位置直接构造
+        LSH_CONSTEXPR20 void fill_insert_aux(iterator position, size_type count, const value_type& value,
+                                             std::true_type) {
+            if (Lsh::is_constant_evaluated()) {
+                return fill_insert_aux(position, count, value, std::false_type());
+            }
+            memmove_elements(position + count, position, impl_.finish_);
+            try {
+                uninitialized_fill_n_a(position, count, value, get_alloc());
+            } catch (...) {
+                memmove_elements(position, position + count, impl_.finish_ + count);
+                throw;
+            }
+            impl_.finish_ += count;
+        }
+
+        LSH_CONSTEXPR20 void fill_insert_aux(iterator position, size_type count, const value_type& value,
+                                             std::false_type) {
+            const size_type elems_after = impl_.finish_ - position;
+            pointer old_finish          = impl_.finish_;
+            if (elems_after > count) {
+                uninitialized_move_a(old_finish - count, old_finish, old_finish, get_alloc());
+                impl_.finish_ = old_finish + count;
+                // 将 [position,old_finish - count) 的元素倒序依次移动到 {old_finish,old_finish-- ...}
+                // 1111111 123456789abcdefgh 00000000000000000000000
+                //        |                 |
+                //   position          old_finish      count = 5
+                // 1111111 12345123456789abc 00000000000000000000000
+                std::move_backward(position, old_finish - count, old_finish);
+                std::fill(position, position + count, value);
+            } else {
+                impl_.finish_ = uninitialized_fill_n_a(old_finish, count - elems_after, value, get_alloc());
+                uninitialized_move_a(position, old_finish, impl_.finish_, get_alloc());
+                impl_.finish_ += elems_after;
+                std::fill(position, old_finish, value);
+            }
+        }
+
+        // 逐个追加 [first,last) 到末尾，容量不够时按 GrowthPolicy 扩容
         template<class InputIterator>
-        void range_insert(iterator pos, InputIterator first, InputIterator last, std::input_iterator_tag) {
+        LSH_CONSTEXPR20 void range_append(InputIterator first, InputIterator last) {
+            for (; first != last; ++first) {
+                this->emplace_back(*first);
+            }
+        }
+
+        /*
+         * 单趟迭代器无法预先得知长度：
+         * -- 先把 [first,last) 追加到末尾，再用 std::rotate 把它们转到 pos，整体仍是线性的
+         * -- 追加过程中抛出异常时删掉已追加的部分，vector 恢复原状
+         */
+        template<class InputIterator>
+        LSH_CONSTEXPR20 void range_insert(iterator pos, InputIterator first, InputIterator last,
+                                          std::input_iterator_tag) {
+            const size_type elems_before = pos - begin();
+            const size_type old_size     = size();
+            try {
+                this->range_append(first, last);
+            } catch (...) {
+                erase_at_end(impl_.start_ + old_size);
+                throw;
+            }
+            if (elems_before != old_size) {
+                std::rotate(begin() + elems_before, begin() + old_size, end());
+            }
+        }
+
+        template<class ForwardIterator>
+        LSH_CONSTEXPR20 void range_insert(iterator pos, ForwardIterator first, ForwardIterator last,
+                                          std::forward_iterator_tag) {
             // 实现逻辑同 fill_insert
             if (first != last) {
                 const size_type n = std::distance(first, last);
-                if (size_type(this->end_of_storage_ - this->finish_) > n) {
-                    const size_type elems_after = finish_ - pos;
-                    pointer old_finish          = this->finish_;
-                    if (elems_after > n) {
-                        std::uninitialized_move(old_finish - n, old_finish, old_finish);
-                        this->finish_ = old_finish + n;
-                        std::move_backward(pos, old_finish - n, old_finish);
-                        std::copy(first, last, pos);
-                    } else {
-                        InputIterator mid = first;
-                        std::advance(mid, elems_after);
-                        this->finish_ = std::uninitialized_copy(mid, last, this->finish_);
-                        std::uninitialized_move(pos, old_finish, this->finish_);
-                        this->finish_ += elems_after;
-                        std::copy(first, mid, pos);
-                    }
+                if (size_type(impl_.end_of_storage_ - impl_.finish_) >= n) {
+                    this->range_insert_aux(pos, first, last, n, use_memmove());
                 } else {
-                    const size_type new_capacity = check_len(n, "vector::range_insert()");
-                    pointer old_start            = this->start_;
-                    pointer old_finish           = this->finish_;
-                    pointer new_start            = allocate(new_capacity);
+                    const auto storage           = allocate_at_least(check_len(n, "vector::range_insert()"));
+                    pointer old_start            = impl_.start_;
+                    pointer old_finish           = impl_.finish_;
+                    pointer new_start            = storage.ptr;
                     const size_type elems_before = pos - begin();
 
-                    std::uninitialized_copy(first, last, new_start + elems_before);
-                    pointer new_finish = std::uninitialized_move(old_start, pos, new_start);
+                    uninitialized_copy_a(first, last, new_start + elems_before, get_alloc());
+                    pointer new_finish = relocate_a(old_start, pos, new_start, get_alloc());
                     new_finish += n;
-                    new_finish = std::uninitialized_move(pos, old_finish, new_finish);
+                    new_finish = relocate_a(pos, old_finish, new_finish, get_alloc());
 
-                    std::destroy(old_start, old_finish);
-                    deallocate(old_start, end_of_storage_ - old_start);
+                    deallocate(old_start, impl_.end_of_storage_ - old_start);
 
-                    this->start_          = new_start;
-                    this->finish_         = new_finish;
-                    this->end_of_storage_ = new_start + new_capacity;
+                    impl_.start_          = new_start;
+                    impl_.finish_         = new_finish;
+                    impl_.end_of_storage_ = new_start + storage.count;
                 }
             }
         }
 
+        // 不扩容插入 [first,last)：后半段整体 memmove 后移 n 位，空出的位置直接构造
+        template<class ForwardIterator>
+        LSH_CONSTEXPR20 void range_insert_aux(iterator pos, ForwardIterator first, ForwardIterator last, size_type n,
+                              std::true_type) {
+            if (Lsh::is_constant_evaluated()) {
+                return range_insert_aux(pos, first, last, n, std::false_type());
+            }
+            memmove_elements(pos + n, pos, impl_.finish_);
+            try {
+                uninitialized_copy_a(first, last, pos, get_alloc());
+            } catch (...) {
+                memmove_elements(pos, pos + n, impl_.finish_ + n);
+                throw;
+            }
+            impl_.finish_ += n;
+        }
+
+        template<class ForwardIterator>
+        LSH_CONSTEXPR20 void range_insert_aux(iterator pos, ForwardIterator first, ForwardIterator last, size_type n,
+                              std::false_type) {
+            const size_type elems_after = impl_.finish_ - pos;
+            pointer old_finish          = impl_.finish_;
+            if (elems_after > n) {
+                uninitialized_move_a(old_finish - n, old_finish, old_finish, get_alloc());
+                impl_.finish_ = old_finish + n;
+                std::move_backward(pos, old_finish - n, old_finish);
+                std::copy(first, last, pos);
+            } else {
+                ForwardIterator mid = first;
+                std::advance(mid, elems_after);
+                impl_.finish_ = uninitialized_copy_a(mid, last, impl_.finish_, get_alloc());
+                uninitialized_move_a(pos, old_finish, impl_.finish_, get_alloc());
+                impl_.finish_ += elems_after;
+                std::copy(first, mid, pos);
+            }
+        }
+
         // 在 end() 之后添加 n 个默认对象
-        void default_append(size_type n) {
+        // -- 不带 tag 时值初始化，带 default_init 时默认初始化
+        template<class... InitTag>
+        LSH_CONSTEXPR20 void default_append(size_type n, InitTag... tag) {
             if (n != 0) {
                 const size_type size      = this->size();
-                const size_type available = this->end_of_storage_ - this->finish_;
+                const size_type available = impl_.end_of_storage_ - impl_.finish_;
                 if (available >= n) {
-                    this->finish_ =
-                            std::uninitialized_default_construct_n(this->finish_, n);
+                    impl_.finish_ = construct_n(impl_.finish_, n, tag...);
                 } else {
-                    pointer old_start            = this->start_;
-                    pointer old_finish           = this->finish_;
-                    const size_type new_capacity = check_len(n, "vector::default_append()");
-                    pointer new_start            = allocate(new_capacity);
-                    pointer new_finish           =
-                            std::uninitialized_move(old_start, old_finish, new_start);
-                    std::uninitialized_default_construct_n(new_finish, n);
-                    std::destroy(old_start, old_finish);
-                    deallocate(old_start, end_of_storage_ - old_start);
-                    this->start_          = new_start;
-                    this->finish_         = new_start + size + n;
-                    this->end_of_storage_ = new_start + new_capacity;
+                    pointer old_start  = impl_.start_;
+                    pointer old_finish = impl_.finish_;
+                    const auto storage = allocate_and_construct(check_len(n, "vector::default_append()"),
+                                                                size, n, tag...);
+                    pointer new_start  = storage.ptr;
+                    relocate_a(old_start, old_finish, new_start, get_alloc());
+                    deallocate(old_start, impl_.end_of_storage_ - old_start);
+                    impl_.start_          = new_start;
+                    impl_.finish_         = new_start + size + n;
+                    impl_.end_of_storage_ = new_start + storage.count;
                 }
             }
         }
@@ -757,27 +1214,90 @@ namespace Lsh {
          * 在未初始化空间上构造元素
          * 被 vector 的各个构造函数调用
          */
-        //被 vector(size_type count) 调用
-        void default_initialize(size_type count) {
-            create_storage(count);
-            finish_ = std::uninitialized_default_construct_n(start_, count);
+        //被 vector(size_type count) 和 vector(size_type count, default_init_t) 调用
+        template<class... InitTag>
+        LSH_CONSTEXPR20 void default_initialize(size_type count, InitTag... tag) {
+            const auto storage    = allocate_and_construct(count, 0, count, tag...);
+            impl_.start_          = storage.ptr;
+            impl_.finish_         = storage.ptr + count;
+            impl_.end_of_storage_ = storage.ptr + storage.count;
+        }
+
+        /*
+         * 分配至少 len 个元素的空间，并在偏移 offset 处构造 n 个元素
+         * -- 值初始化时优先向分配器要全零内存（calloc / 匿名 mmap）：元素已经是零，
+         *    不再逐页写零，没写过的页保持未映射，大而稀疏的计数数组不占物理内存
+         * -- 构造抛出异常时归还内存
+         */
+        LSH_CONSTEXPR20 allocation_result<pointer, size_type>
+        allocate_and_construct(size_type len, size_type offset, size_type n) {
+            return allocate_and_construct_aux(len, offset, n, use_allocate_zeroed());
+        }
+
+        LSH_CONSTEXPR20 allocation_result<pointer, size_type>
+        allocate_and_construct(size_type len, size_type offset, size_type n, default_init_t) {
+            return allocate_and_construct_aux(len, offset, n, std::false_type(), default_init);
+        }
+
+        LSH_CONSTEXPR20 allocation_result<pointer, size_type>
+        allocate_and_construct_aux(size_type len, size_type offset, size_type n, std::true_type) {
+            if (Lsh::is_constant_evaluated()) {
+                return allocate_and_construct_aux(len, offset, n, std::false_type());
+            }
+            if (len == 0) {
+                return {pointer(), 0};
+            }
+            return {get_alloc().allocate_zeroed(len), len};
+        }
+
+        template<class... InitTag>
+        LSH_CONSTEXPR20 allocation_result<pointer, size_type>
+        allocate_and_construct_aux(size_type len, size_type offset, size_type n, std::false_type, InitTag... tag) {
+            const auto storage = allocate_at_least(len);
+            try {
+                construct_n(storage.ptr + offset, n, tag...);
+            } catch (...) {
+                deallocate(storage.ptr, storage.count);
+                throw;
+            }
+            return storage;
+        }
+
+        // 在 p 处构造 n 个元素：值初始化 / 默认初始化
+        LSH_CONSTEXPR20 pointer construct_n(pointer p, size_type n) {
+            return uninitialized_value_n_a(p, n, get_alloc());
+        }
+
+        LSH_CONSTEXPR20 pointer construct_n(pointer p, size_type n, default_init_t) {
+            return uninitialized_default_n_a(p, n, get_alloc());
         }
 
         // 被 vector(szie_type count,const_reference value) 调用
-        void fill_initialize(size_type count, const_reference value) {
+        LSH_CONSTEXPR20 void fill_initialize(size_type count, const_reference value) {
             create_storage(count);
-            finish_ = std::uninitialized_fill_n(start_, count, value);
+            impl_.finish_ = uninitialized_fill_n_a(impl_.start_, count, value, get_alloc());
         }
 
         // 被 vector(InputIterator first,InputIterator last) 调用
+        // -- 单趟迭代器：边读边追加，构造函数抛出异常时 vector_impl 仍会释放内存，这里只需析构元素
         template<class InputIterator>
-        void ranges_initialize(InputIterator first, InputIterator last, std::input_iterator_tag) {
+        LSH_CONSTEXPR20 void ranges_initialize(InputIterator first, InputIterator last, std::input_iterator_tag) {
+            try {
+                this->range_append(first, last);
+            } catch (...) {
+                clear();
+                throw;
+            }
+        }
+
+        template<class ForwardIterator>
+        LSH_CONSTEXPR20 void ranges_initialize(ForwardIterator first, ForwardIterator last, std::forward_iterator_tag) {
             size_type count = std::distance(first, last);
             create_storage(check_init_len(count));
-            finish_ = std::uninitialized_copy_n(first, count, start_);
+            impl_.finish_ = uninitialized_copy_a(first, last, impl_.start_, get_alloc());
         }
 
-        size_type check_init_len(size_type count) {
+        LSH_CONSTEXPR20 size_type check_init_len(size_type count) {
             if (count > max_size()) {
                 throw std::length_error("vector size is greater than max_size()");
             }
@@ -785,53 +1305,64 @@ namespace Lsh {
         }
 
         // 扩容时调用
-        size_type check_len(size_type count, const char* s) const {
-            if (max_size() < count + size()) {
+        LSH_CONSTEXPR20 size_type check_len(size_type count, const char* s) const {
+            if (max_size() - size() < count) {
                 throw std::length_error(s);
             }
-            // 一般情况下，二倍扩容
-            const size_type len = size() + std::max(count, size());
+            // 新容量由 GrowthPolicy 决定，至少要放下 size() + count 个元素
+            const size_type required = size() + count;
+            const size_type len      = GrowthPolicy::next_capacity(size(), required, sizeof(T));
             // 溢出或者超过 max_size() 时返回 max_size()
-            return (len < size() || len > max_size()) ? max_size() : len;
+            return (len < required || len > max_size()) ? max_size() : len;
         }
     };
 
     //==================================== 非成员函数 ==========================
-    template<class T>
-    bool operator==(const vector<T>& lhs, const vector<T>& rhs) {
+    template<class T, class Allocator, class GrowthPolicy>
+    LSH_CONSTEXPR20 bool operator==(const vector<T, Allocator, GrowthPolicy>& lhs,
+                    const vector<T, Allocator, GrowthPolicy>& rhs) {
         return (lhs.size() == rhs.size()) &&
                std::equal(lhs.begin(), lhs.end(), rhs.begin());
     }
 
-    template<class T>
-    bool operator!=(const vector<T>& lhs, const vector<T>& rhs) {
+    template<class T, class Allocator, class GrowthPolicy>
+    LSH_CONSTEXPR20 bool operator!=(const vector<T, Allocator, GrowthPolicy>& lhs,
+                    const vector<T, Allocator, GrowthPolicy>& rhs) {
         return !(lhs == rhs);
     }
 
-    template<class T>
-    bool operator<(const vector<T>& lhs, const vector<T>& rhs) {
+    template<class T, class Allocator, class GrowthPolicy>
+    LSH_CONSTEXPR20 bool operator<(const vector<T, Allocator, GrowthPolicy>& lhs,
+                   const vector<T, Allocator, GrowthPolicy>& rhs) {
         return std::lexicographical_compare(lhs.begin(), lhs.end(),
                                             rhs.begin(), rhs.end());
     }
 
-    template<class T>
-    bool operator<=(const vector<T>& lhs, const vector<T>& rhs) {
+    template<class T, class Allocator, class GrowthPolicy>
+    LSH_CONSTEXPR20 bool operator<=(const vector<T, Allocator, GrowthPolicy>& lhs,
+                    const vector<T, Allocator, GrowthPolicy>& rhs) {
         return !(rhs < lhs);
     }
 
-    template<class T>
-    bool operator>(const vector<T>& lhs, const vector<T>& rhs) {
+    template<class T, class Allocator, class GrowthPolicy>
+    LSH_CONSTEXPR20 bool operator>(const vector<T, Allocator, GrowthPolicy>& lhs,
+                   const vector<T, Allocator, GrowthPolicy>& rhs) {
         return rhs < lhs;
     }
 
-    template<class T>
-    bool operator>=(const vector<T>& lhs, const vector<T>& rhs) {
+    template<class T, class Allocator, class GrowthPolicy>
+    LSH_CONSTEXPR20 bool operator>=(const vector<T, Allocator, GrowthPolicy>& lhs,
+                    const vector<T, Allocator, GrowthPolicy>& rhs) {
         return !(lhs < rhs);
     }
 
-    template<class T>
-    void swap(vector<T>& lhs, vector<T>& rhs) noexcept {
+    template<class T, class Allocator, class GrowthPolicy>
+    LSH_CONSTEXPR20 void swap(vector<T, Allocator, GrowthPolicy>& lhs,
+              vector<T, Allocator, GrowthPolicy>& rhs) noexcept {
         lhs.swap(rhs);
     }
 }
+
+// vector<bool> 特化
+#include "bvector.h"
 #endif //VECTOR_H